@@ -0,0 +1,166 @@
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+#include "gpro/file.hpp"
+#include "gpro/mesh_cache.hpp"
+#include "gpro/mesh_codec.hpp"
+#include "gpro/mesh_optimizer.hpp"
+#include "gpro/utils.hpp"
+
+// Reproducible mesh load timing: the cold path (obj parse and weld, optimization, lods, meshlets, cache store) and the
+// warm path (cache load, unpack) of SceneSerializer::_loadMesh, on a generated grid.
+// The grid only depends on its size, so runs on different machines or revisions load the same file.
+//
+//     demo-05-load-bench [grid size = 500] [runs = 5]
+//
+// The obj and the cache entry are read through the file system cache in both paths, each stage prints the minimum
+// and median over the runs.
+
+namespace {
+
+using namespace gpro;
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point ts) { return std::chrono::duration<double, std::milli>(Clock::now() - ts).count(); }
+
+// a size x size quad grid with a fixed seed height field, v/vt/vn corners. std::mt19937 is specified bit for bit,
+// the heights are scaled from its raw output
+std::string generateGrid(uint32_t size) {
+    const std::string path = cachePath(std::format("bench/grid_{}.obj", size));
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+
+    std::mt19937 rng(5489u);
+    std::string obj;
+    obj.reserve(size_t(size + 1) * (size + 1) * 96 + size_t(size) * size * 64);
+    for (uint32_t y = 0; y <= size; y++) {
+        for (uint32_t x = 0; x <= size; x++) {
+            const float height = static_cast<float>(rng() >> 8) / (1u << 24) * 0.02f;
+            obj += std::format("v {0:.6f} {1:.6f} {2:.6f}\n", float(x) / size, height, float(y) / size);
+            obj += std::format("vt {0:.6f} {1:.6f}\n", float(x) / size, float(y) / size);
+            obj += std::format("vn {0:.6f} {1:.6f} {2:.6f}\n", 0.f, 1.f, 0.f);
+        }
+    }
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            const uint32_t i = y * (size + 1) + x + 1;
+            const uint32_t j = i + size + 1;
+            obj += std::format("f {0}/{0}/{0} {1}/{1}/{1} {2}/{2}/{2} {3}/{3}/{3}\n", i, j, j + 1, i + 1);
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(obj.data(), static_cast<std::streamsize>(obj.size()));
+    if (!file) throw std::runtime_error(std::format("Cannot write the benchmark obj: '{}'", path));
+    return path;
+}
+
+// the stages print their own diagnostics, only the summary is kept
+class DiscardCout {
+public:
+    DiscardCout() : m_buffer(std::cout.rdbuf(m_discarded.rdbuf())) {}
+    ~DiscardCout() { std::cout.rdbuf(m_buffer); }
+
+private:
+    std::ostringstream m_discarded;
+    std::streambuf *m_buffer;
+};
+
+class Stages {
+public:
+    void add(const char *name, double ms) {
+        auto it = std::find_if(m_stages.begin(), m_stages.end(), [&](const auto& s) { return s.first == name; });
+        if (it == m_stages.end()) it = m_stages.insert(m_stages.end(), {name, {}});
+        it->second.push_back(ms);
+    }
+
+    void print(const char *title) {
+        std::cout << std::format("{0:<28}{1:>10}{2:>10}\n", title, "min ms", "median ms");
+        for (auto& [name, samples] : m_stages) {
+            std::sort(samples.begin(), samples.end());
+            std::cout << std::format("    {0:<24}{1:>10.2f}{2:>10.2f}\n", name, samples.front(),
+                                     samples[samples.size() / 2]);
+        }
+    }
+
+private:
+    std::vector<std::pair<std::string, std::vector<double>>> m_stages;  // in first-added order
+};
+
+Stages benchmark(const std::string& objPath, uint32_t flags, uint32_t runCount) {
+    DiscardCout discardCout;
+    Stages stages;
+    Mesh mesh;
+
+    for (uint32_t run = 0; run < runCount; run++) {
+        std::filesystem::remove(MeshCache::entryPath(objPath));
+        mesh = Mesh{};
+
+        auto total = Clock::now();
+        auto ts = Clock::now();
+        util::loadObj(objPath, mesh.vertices, mesh.indices);
+        stages.add("cold: parse + weld", msSince(ts));
+
+        ts = Clock::now();
+        MeshOptimizer::optimizeVertexCache(mesh.indices, mesh.vertices.size());
+        MeshOptimizer::optimizeVertexFetch(mesh.vertices, mesh.indices);
+        stages.add("cold: optimize", msSince(ts));
+
+        ts = Clock::now();
+        MeshOptimizer::buildLodChain(mesh.vertices, mesh.indices, mesh.lods);
+        stages.add("cold: lods", msSince(ts));
+
+        ts = Clock::now();
+        MeshOptimizer::buildMeshlets(mesh.vertices, mesh.indices, mesh.lods, mesh.meshlets);
+        stages.add("cold: meshlets", msSince(ts));
+
+        ts = Clock::now();
+        const AABB aabb = AABB::calculateBoundingBox(mesh.vertices);
+        if (!MeshCache::store(objPath, flags, mesh.vertices, mesh.indices, mesh.lods, mesh.meshlets, aabb))
+            throw std::runtime_error("Cannot write the mesh cache entry");
+        stages.add("cold: store", msSince(ts));
+        stages.add("cold: total", msSince(total));
+    }
+
+    for (uint32_t run = 0; run < runCount; run++) {
+        mesh = Mesh{};
+
+        auto total = Clock::now();
+        auto ts = Clock::now();
+        MeshCache::MappedMesh cached;
+        if (!MeshCache::load(objPath, flags, cached)) throw std::runtime_error("The mesh cache entry did not load");
+        stages.add("warm: load", msSince(ts));
+
+        ts = Clock::now();
+        if (!MeshCache::unpack(cached, mesh)) throw std::runtime_error("The mesh cache entry did not unpack");
+        stages.add("warm: unpack", msSince(ts));
+        stages.add("warm: total", msSince(total));
+    }
+
+    std::filesystem::remove(MeshCache::entryPath(objPath));
+    return stages;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    try {
+        const uint32_t size = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 500;
+        const uint32_t runCount = std::max(1u, argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 5u);
+        const std::string objPath = generateGrid(size);
+
+        std::cout << std::format("load bench: {0}x{0} grid, {1} triangles, {2:.1f} MB obj, {3} runs, {4} threads\n",
+                                 size, 2ull * size * size, std::filesystem::file_size(objPath) / (1024.0 * 1024.0),
+                                 runCount, std::thread::hardware_concurrency())
+                  << std::format("mesh codec: {}\n", MeshCodec::decoderName());
+
+        benchmark(objPath, MeshCache::OPTIMIZED, runCount).print("float vertices");
+        benchmark(objPath, MeshCache::OPTIMIZED | MeshCache::COMPRESSED, runCount).print("compact vertices");
+    } catch (const std::exception& e) {
+        std::cerr << std::format("load bench failed: {}\n", e.what());
+        return 1;
+    }
+    return 0;
+}
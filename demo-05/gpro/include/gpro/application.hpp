@@ -1,5 +1,6 @@
 #pragma once
 
+#include "gpro/cpu_profiler.hpp"
 #include "gpro/scene.hpp"
 #include "gpro/scene_serializer.hpp"
 #include "gpro/shared.hpp"
@@ -30,6 +31,7 @@ private:
     // time
     float m_time;
     float m_deltaTime;
+    FrameTimeWindow m_frameTimes;
 
     std::shared_ptr<Scene> m_scene;
     std::shared_ptr<SceneSerializer> m_serializer;
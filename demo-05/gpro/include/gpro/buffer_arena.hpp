@@ -0,0 +1,197 @@
+#pragma once
+
+#include "gpro/deferred_release.hpp"
+#include "gpro/thread_pool.hpp"
+
+namespace gpro {
+
+// Device-local buffers of the renderer and their uploads. Buffers are created through the arena and released to it,
+// it frees them FRAMES_IN_FLIGHT frames later (the frames in flight may still use them). Sub-range uploads are queued
+// by reference and copied from their source into the staging buffer of the frame's slot once, split over a thread
+// pool, then recorded together.
+class BufferArena {
+public:
+    // since the last nextFrame
+    struct Stats {
+        uint64_t uploadedBytes = 0;
+        uint32_t uploadCount = 0;
+        uint32_t createdBufferCount = 0;
+    };
+
+    // buffer of capacity bytes, the first size bytes are copied from data
+    tga::Buffer createBuffer(tga::BufferUsage usage, size_t capacity, const void *data, size_t size);
+    void release(tga::Buffer buffer);
+
+    // the data is not copied, it has to stay unchanged until the next recordUploads (the arena buffers' cpu copies
+    // only change between frames)
+    void upload(tga::Buffer buffer, size_t offset, const void *data, size_t size);
+    // frameSlot < FRAMES_IN_FLIGHT, its last frame has completed. the workers of threadPool (if any) only copy, the
+    // upload commands are recorded by the calling thread. returns the uploaded bytes
+    size_t recordUploads(tga::CommandRecorder& cmdRecorder, uint32_t frameSlot, ThreadPool *threadPool);
+
+    // frees the buffers released FRAMES_IN_FLIGHT frames ago and resets the stats. render thread, once per frame
+    void nextFrame();
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    struct Upload {
+        tga::Buffer buffer;
+        size_t dstOffset;
+        const uint8_t *data;
+        size_t stagingOffset;
+        size_t size;
+    };
+    struct CopyChunk {
+        const uint8_t *data;
+        size_t stagingOffset;
+        size_t size;
+    };
+    static constexpr size_t COPY_CHUNK_BYTES = 256 << 10;  // per parallelFor call
+
+    struct Staging {
+        tga::StagingBuffer buffer;
+        size_t size = 0;
+    };
+    std::vector<Upload> m_uploads;
+    size_t m_uploadSize = 0;          // staging bytes of m_uploads
+    std::vector<CopyChunk> m_chunks;  // of the uploads, reused
+    std::array<Staging, FRAMES_IN_FLIGHT> m_stagings;  // per frame slot
+
+    DeferredRelease<tga::Buffer> m_releasedBuffers;
+    Stats m_stats;
+};
+
+// Offset based sub-allocation of the elements of one or more arena buffers. Allocations are taken first fit from a
+// free list sorted by offset, freed ranges are merged with their neighbours. If nothing fits, the range is appended
+// and the capacity grows geometrically.
+class ArenaPool {
+public:
+    struct Range {
+        uint32_t offset = 0;
+        uint32_t count = 0;
+    };
+
+    struct Stats {
+        uint32_t capacity;
+        uint32_t size;              // end of the last allocation
+        uint32_t usedCount;
+        uint32_t freeRangeCount;    // below size
+        uint32_t largestFreeRange;
+        uint32_t allocationCount;   // since the last resetFrameStats
+        uint32_t freeCount;
+
+        // share of the free elements below size that are not in the largest free range
+        float fragmentation() const {
+            const uint32_t freeCount = size - usedCount;
+            return freeCount ? 1.f - float(largestFreeRange) / freeCount : 0.f;
+        }
+    };
+
+    ArenaPool(const char *name, uint32_t initialCapacity) : m_name(name), m_capacity(initialCapacity) {}
+
+    Range allocate(uint32_t count);
+    void free(Range range);
+
+    const char *name() const { return m_name; }
+    uint32_t capacity() const { return m_capacity; }
+    uint32_t size() const { return m_size; }
+
+    Stats stats() const;
+    void resetFrameStats();
+
+private:
+    const char *m_name;
+    uint32_t m_capacity;
+    uint32_t m_size = 0;
+    uint32_t m_usedCount = 0;
+    std::vector<Range> m_freeRanges;  // sorted by offset, never adjacent, all below m_size
+
+    uint32_t m_allocationCount = 0;
+    uint32_t m_freeCount = 0;
+};
+
+// One array in an arena pool: a cpu copy with the capacity of the pool and its device-local buffer. Writes mark the
+// elements dirty, commit uploads the dirty ranges or recreates the buffer (with the whole copy) if the pool grew.
+// tga cannot copy between buffers on the gpu, so the cpu copy is kept for the growth.
+template <typename T>
+class ArenaBuffer {
+public:
+    ArenaBuffer(BufferArena& arena, const ArenaPool& pool, tga::BufferUsage usage, const T& fill = T())
+        : m_arena(arena), m_pool(pool), m_usage(usage), m_fill(fill) {}
+
+    ArenaBuffer(const ArenaBuffer&) = delete;
+    ArenaBuffer& operator=(const ArenaBuffer&) = delete;
+
+    const T& operator[](uint32_t index) const { return m_data[index]; }
+
+    void write(uint32_t offset, const T *data, uint32_t count) {
+        _reserve();
+        std::copy(data, data + count, m_data.begin() + offset);
+        markDirty(offset, count);
+    }
+
+    void fill(uint32_t offset, uint32_t count, const T& value) {
+        _reserve();
+        std::fill_n(m_data.begin() + offset, count, value);
+        markDirty(offset, count);
+    }
+
+    // for in-place changes, followed by markDirty
+    T *data(uint32_t offset) {
+        _reserve();
+        return m_data.data() + offset;
+    }
+
+    void markDirty(uint32_t offset, uint32_t count) {
+        if (count > 0) m_dirtyRanges.push_back({offset, count});
+    }
+
+    // true if the buffer was recreated
+    bool commit() {
+        if (m_capacity != m_pool.capacity()) {
+            _reserve();
+            if (m_buffer) m_arena.release(m_buffer);
+            m_capacity = m_pool.capacity();
+            m_buffer = m_arena.createBuffer(m_usage, size_t(m_capacity) * sizeof(T), m_data.data(),
+                                            size_t(m_pool.size()) * sizeof(T));
+            m_dirtyRanges.clear();
+            return true;
+        }
+
+        // overlapping and adjacent ranges are uploaded together
+        std::sort(m_dirtyRanges.begin(), m_dirtyRanges.end(),
+                  [](const auto& a, const auto& b) { return a.offset < b.offset; });
+        for (size_t i = 0; i < m_dirtyRanges.size();) {
+            uint32_t begin = m_dirtyRanges[i].offset;
+            uint32_t end = begin + m_dirtyRanges[i].count;
+            for (i++; i < m_dirtyRanges.size() && m_dirtyRanges[i].offset <= end; i++)
+                end = std::max(end, m_dirtyRanges[i].offset + m_dirtyRanges[i].count);
+            end = std::min(end, m_pool.size());  // freed at the end
+            if (begin < end)
+                m_arena.upload(m_buffer, size_t(begin) * sizeof(T), m_data.data() + begin,
+                               size_t(end - begin) * sizeof(T));
+        }
+        m_dirtyRanges.clear();
+        return false;
+    }
+
+    tga::Buffer buffer() const { return m_buffer; }
+
+private:
+    void _reserve() {
+        if (m_data.size() < m_pool.capacity()) m_data.resize(m_pool.capacity(), m_fill);
+    }
+
+    BufferArena& m_arena;
+    const ArenaPool& m_pool;
+    tga::BufferUsage m_usage;
+    T m_fill;  // unused elements
+
+    std::vector<T> m_data;
+    std::vector<ArenaPool::Range> m_dirtyRanges;
+    tga::Buffer m_buffer;
+    uint32_t m_capacity = 0;  // of m_buffer, in elements
+};
+
+}  // namespace gpro
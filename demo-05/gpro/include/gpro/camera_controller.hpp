@@ -23,6 +23,7 @@ struct Plane {
     float distance;
 };
 
+// inward facing planes, a point p is inside if dot(normal, p) >= distance for all of them (std140, the culling pass)
 struct Frustum {
     Plane topFace;
     Plane bottomFace;
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <span>
+
 #include "gpro/shared.hpp"
 
 namespace gpro {
 
+class MappedFile;
+
 struct Light {
     alignas(16) glm::vec3 lightPos = glm::vec3(0);  // TODO: use transform component instead
     alignas(16) glm::vec3 lightColor = glm::vec3(1);
@@ -18,9 +22,46 @@ struct Transform {
     }
 };
 
+// triangle cluster of a mesh (std430), culled as a unit on the gpu
+struct Meshlet {
+    alignas(16) glm::vec3 center;    // bounding sphere, mesh space
+    float radius;
+    alignas(16) glm::vec3 coneApex;  // normal cone, backfacing if dot(normalize(coneApex - eye), coneAxis) >= coneCutoff
+    float coneCutoff;                // >= 1 -> no backface rejection
+    alignas(16) glm::vec3 coneAxis;
+    uint32_t triangleCount;
+    uint32_t indexOffset;            // first index, relative to the mesh
+    uint32_t vertexCount;
+    uint32_t lod;
+};
+
+// level of detail of a mesh, a range of the mesh indices (all levels share the vertices)
+struct MeshLOD {
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    uint32_t meshletOffset;
+    uint32_t meshletCount;
+    float error;  // object space deviation from the full detail mesh
+};
+
 struct Mesh {
     std::vector<Vertex> vertices;
     std::vector<IndexFormat> indices;
+    std::vector<Meshlet> meshlets;  // contiguous ranges of indices
+    std::vector<MeshLOD> lods;      // lods[0] is the full detail mesh
+    std::vector<CompactVertex> compactVertices;  // gpu layout (mesh AABB relative), set by compressed cache loads
+
+    // uncompressed cache loads leave vertices and indices empty, the arrays stay in the mapped cache entry and are
+    // batched straight from there
+    std::shared_ptr<const MappedFile> mapping;
+    std::span<const Vertex> mappedVertices;
+    std::span<const IndexFormat> mappedIndices;
+
+    // the vertices and indices, wherever they are
+    std::span<const Vertex> vertexData() const { return mapping ? mappedVertices : std::span<const Vertex>(vertices); }
+    std::span<const IndexFormat> indexData() const {
+        return mapping ? mappedIndices : std::span<const IndexFormat>(indices);
+    }
 
     static const tga::VertexLayout& getVertexLayout() {
         static tga::VertexLayout vertexLayout(sizeof(Vertex),
@@ -29,6 +70,15 @@ struct Mesh {
                                                {offsetof(Vertex, normal), tga::Format::r32g32b32_sfloat}});
         return vertexLayout;
     }
+
+    // layout of CompactVertex, positions are decoded with the mesh AABB in the vertex shader
+    static const tga::VertexLayout& getCompactVertexLayout() {
+        static tga::VertexLayout vertexLayout(sizeof(CompactVertex),
+                                              {{offsetof(CompactVertex, position), tga::Format::r16g16b16a16_unorm},
+                                               {offsetof(CompactVertex, uv), tga::Format::r16g16_sfloat},
+                                               {offsetof(CompactVertex, normal), tga::Format::r16g16_snorm}});
+        return vertexLayout;
+    }
 };
 
 struct AABB {
@@ -47,7 +97,7 @@ struct SceneObject {  // TODO: use ecs
     Mesh mesh;
     std::vector<Transform> transforms;
     uint32_t instanceCount;
-    tga::Texture diffuseMap;
+    uint32_t diffuseMapID;  // in the renderer's texture registry
     AABB boundingBox;
 };
 
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "gpro/shared.hpp"
+
+namespace gpro {
+
+// Scoped cpu zones, exported as a Chrome trace (chrome://tracing, ui.perfetto.dev). A zone is recorded when it ends,
+// into a ring of the last RING_CAPACITY zones of its thread, without locks: two clock reads and four relaxed stores
+// (measureZoneOverheadNs). GPRO_ZONE and GPRO_THREAD_NAME compile to nothing unless GPRO_PROFILE_CPU is defined.
+class CpuProfiler {
+public:
+    static constexpr uint32_t RING_CAPACITY = 1 << 15;  // zones per thread
+
+    static uint64_t nowNs();
+    // name is kept as a pointer, a string literal
+    static void record(const char *name, uint64_t beginNs, uint64_t endNs);
+    static void setThreadName(const char *name);
+
+    // the zones in every thread's ring as complete events. the other threads may keep recording, zones they
+    // overwrite meanwhile are left out
+    static bool writeChromeTrace(const std::string& path);
+
+    // average cost of an empty zone, timed on a thread of its own (it shows up in the trace)
+    static double measureZoneOverheadNs(uint32_t zoneCount = 1 << 20);
+};
+
+class CpuZone {
+public:
+    explicit CpuZone(const char *name) : m_name(name), m_beginNs(CpuProfiler::nowNs()) {}
+    ~CpuZone() { CpuProfiler::record(m_name, m_beginNs, CpuProfiler::nowNs()); }
+
+    CpuZone(const CpuZone&) = delete;
+    CpuZone& operator=(const CpuZone&) = delete;
+
+private:
+    const char *m_name;
+    uint64_t m_beginNs;
+};
+
+#ifdef GPRO_PROFILE_CPU
+#define GPRO_ZONE_CONCAT_(a, b) a##b
+#define GPRO_ZONE_CONCAT(a, b) GPRO_ZONE_CONCAT_(a, b)
+#define GPRO_ZONE(name) ::gpro::CpuZone GPRO_ZONE_CONCAT(gproZone, __LINE__)(name)
+#define GPRO_THREAD_NAME(name) ::gpro::CpuProfiler::setThreadName(name)
+#else
+#define GPRO_ZONE(name) ((void)0)
+#define GPRO_THREAD_NAME(name) ((void)0)
+#endif
+
+// Frame times over windows of WINDOW_SIZE frames, reported as percentiles instead of a per-frame fps print.
+class FrameTimeWindow {
+public:
+    static constexpr uint32_t WINDOW_SIZE = 300;
+
+    // true if the frame completed a window, the percentiles are then those of the new window
+    bool add(double ms);
+
+    // nearest rank, p in (0, 1]
+    double percentile(double p) const;
+    double max() const { return m_sorted.empty() ? 0 : m_sorted.back(); }
+
+private:
+    std::vector<double> m_frames;
+    std::vector<double> m_sorted;  // the last complete window
+};
+
+}  // namespace gpro
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "gpro/shared.hpp"
+
+namespace gpro {
+
+// Resources replaced while frames are in flight. Released ones are freed FRAMES_IN_FLIGHT frames later, when every
+// frame recorded before the release has completed.
+template <typename T>
+class DeferredRelease {
+public:
+    void release(T resource) {
+        if (resource) m_frames[m_frameIndex].push_back(resource);
+    }
+
+    // render thread, once per frame after the wait for the frame's slot and before recording
+    void nextFrame() {
+        m_frameIndex = (m_frameIndex + 1) % FRAMES_IN_FLIGHT;
+        for (auto& resource : m_frames[m_frameIndex]) tgai.free(resource);
+        m_frames[m_frameIndex].clear();
+    }
+
+private:
+    std::array<std::vector<T>, FRAMES_IN_FLIGHT> m_frames;  // released during the frame
+    uint32_t m_frameIndex = 0;
+};
+
+}  // namespace gpro
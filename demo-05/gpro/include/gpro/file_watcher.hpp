@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+
+#include "gpro/lock_free_queue.hpp"
+#include "gpro/shared.hpp"
+
+namespace gpro {
+
+struct FileEvent {
+    enum class Type {
+        added,
+        modified,
+        removed,
+        rescan,  // events were lost, the watched directories have to be scanned again
+    };
+
+    Type type = Type::rescan;
+    std::string path;
+};
+
+// Watches directories (not recursively) for files with the given extensions and queues debounced change events:
+// the events of a file are merged until it has been quiet for DEBOUNCE_MS, so a save is reported once.
+// Uses inotify on linux. Elsewhere, or if inotify is unavailable, the directories are polled every POLL_INTERVAL_MS.
+// Either way the work is done on the watcher's own thread, an idle consumer only pays for an empty queue pop.
+class FileWatcher {
+public:
+    static constexpr uint32_t DEBOUNCE_MS = 100;
+    static constexpr uint32_t POLL_INTERVAL_MS = 200;
+
+    // extensions with the dot, e.g. ".yaml"
+    FileWatcher(std::vector<std::string> directories, std::vector<std::string> extensions);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // any thread, false if there is no event
+    bool tryPop(FileEvent& event) { return m_events.tryPop(event); }
+
+    const char *backendName() const;
+
+private:
+    struct PendingEvent {
+        FileEvent::Type type;
+        std::chrono::steady_clock::time_point time;  // of the last merged event
+    };
+
+    struct FileStamp {
+        std::filesystem::file_time_type writeTime;
+        uintmax_t size;
+    };
+
+    void _run();
+    bool _isWatched(const std::filesystem::path& path) const;
+    void _record(const std::string& path, FileEvent::Type type);
+    void _flush();
+
+    // polling backend
+    void _scan(std::unordered_map<std::string, FileStamp>& snapshot) const;
+    void _poll();
+
+#ifdef __linux__
+    bool _initInotify();
+    void _readInotify();
+
+    int m_inotifyFD = -1;
+    std::unordered_map<int, std::string> m_watchDirectories;  // watch descriptor -> directory
+#endif
+
+    std::vector<std::string> m_directories;
+    std::vector<std::string> m_extensions;
+
+    // watcher thread only
+    std::unordered_map<std::string, PendingEvent> m_pendingEvents;
+    std::unordered_map<std::string, FileStamp> m_snapshot;  // polling backend
+    bool m_isRescanPending = false;                         // an event did not fit into the queue
+
+    LockFreeQueue<FileEvent> m_events{1024};  // watcher thread -> consumer
+    std::atomic<bool> m_isRunning{true};
+    std::thread m_thread;  // started last, in the constructor body
+};
+
+}  // namespace gpro
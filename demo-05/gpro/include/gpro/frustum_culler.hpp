@@ -0,0 +1,34 @@
+#pragma once
+
+#include "gpro/camera_controller.hpp"
+#include "gpro/components.hpp"
+
+namespace gpro {
+
+// The plane tests of the culling pass on the cpu, the reference its output is validated against. Conservative: a
+// world space sphere or AABB is culled only if it lies completely behind one (inward facing) frustum plane.
+// Tests 4 primitives at once with SSE or NEON where available, with a scalar fallback.
+class FrustumCuller {
+public:
+    explicit FrustumCuller(const Frustum& frustum);
+
+    // spheres as xyz center, w radius. visibility is 1 for visible primitives and 0 otherwise, returns the number of
+    // visible primitives
+    size_t cullSpheres(const glm::vec4 *spheres, size_t count, uint8_t *visibility) const;
+    size_t cullAABBs(const AABB *aabbs, size_t count, uint8_t *visibility) const;
+
+    // one primitive at a time, without simd
+    bool isSphereVisible(const glm::vec4& sphere) const;
+    bool isAABBVisible(const AABB& aabb) const;
+
+    // the implementation picked for this cpu
+    static const char *simdName();
+
+private:
+    static constexpr uint32_t PLANE_COUNT = 6;
+
+    // structure of arrays, one lane per plane in the scalar tests and broadcast in the simd tests
+    float m_normalX[PLANE_COUNT], m_normalY[PLANE_COUNT], m_normalZ[PLANE_COUNT], m_distance[PLANE_COUNT];
+};
+
+}  // namespace gpro
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+
+#include "gpro/shared.hpp"
+
+namespace gpro {
+
+// Unbounded multi-producer queue guarded by a mutex, for results the workers hand to the render thread. push never
+// fails, so a worker never waits for the render thread to drain the queue (which it may only do a few items per
+// frame, or not at all while shutting down).
+template <typename T>
+class HandoffQueue {
+public:
+    void push(T&& value) {
+        std::lock_guard lock(m_mutex);
+        m_values.push_back(std::move(value));
+    }
+
+    // false if the queue is empty
+    bool tryPop(T& value) {
+        std::lock_guard lock(m_mutex);
+        if (m_values.empty()) return false;
+        value = std::move(m_values.front());
+        m_values.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::deque<T> m_values;
+};
+
+}  // namespace gpro
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <memory>
+
+#include "gpro/shared.hpp"
+
+namespace gpro {
+
+// Bounded multi-producer multi-consumer queue (Vyukov). Each cell carries a sequence number that tells producers
+// and consumers whether it is free or filled, so they only contend on their own position counter.
+template <typename T>
+class LockFreeQueue {
+public:
+    explicit LockFreeQueue(size_t capacity)
+        : m_capacity(std::bit_ceil(std::max<size_t>(capacity, 2))), m_cells(new Cell[m_capacity]) {
+        for (size_t i = 0; i < m_capacity; i++) m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    // false if the queue is full, value is only moved from on success
+    bool tryPush(T&& value) {
+        size_t position = m_pushPosition.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = m_cells[position & (m_capacity - 1)];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (diff == 0) {
+                if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                position = m_pushPosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // false if the queue is empty
+    bool tryPop(T& value) {
+        size_t position = m_popPosition.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = m_cells[position & (m_capacity - 1)];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+            if (diff == 0) {
+                if (m_popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.sequence.store(position + m_capacity, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                position = m_popPosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    const size_t m_capacity;
+    std::unique_ptr<Cell[]> m_cells;
+    alignas(64) std::atomic<size_t> m_pushPosition{0};
+    alignas(64) std::atomic<size_t> m_popPosition{0};
+};
+
+}  // namespace gpro
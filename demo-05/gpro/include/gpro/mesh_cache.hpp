@@ -0,0 +1,75 @@
+#pragma once
+
+#include "gpro/components.hpp"
+#include "gpro/mapped_file.hpp"
+#include "gpro/shared.hpp"
+
+namespace gpro {
+
+// Binary cache of loaded meshes (final vertex/index arrays + lods + meshlets + bounds), stored under GPRO_CACHE_DIR.
+// An entry is keyed by the source path and validated with the source write time, size and content hash.
+class MeshCache {
+public:
+    static constexpr uint32_t MAGIC = 0x4D4F5247;  // "GROM"
+    static constexpr uint32_t VERSION = 5;
+
+    enum Flags : uint32_t {
+        NONE = 0,
+        OPTIMIZED = 1 << 0,   // vertex cache + vertex fetch optimized
+        COMPRESSED = 1 << 1,  // quantized CompactVertex array + indices, stored as MeshCodec streams
+    };
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vertexStride;  // sizeof(Vertex) or sizeof(CompactVertex) at write time
+        uint32_t indexStride;   // sizeof(IndexFormat) at write time
+        uint32_t flags;         // Flags the arrays were processed with
+        uint32_t reserved;
+        int64_t sourceWriteTime;
+        uint64_t sourceSize;
+        uint64_t sourceHash;
+        uint64_t sourcePathLength;  // path follows the header
+        uint64_t vertexCount;
+        uint64_t indexCount;
+        uint64_t vertexOffset;  // byte offset of the vertices from the file start
+        uint64_t indexOffset;   // byte offset of the indices from the file start
+        uint64_t vertexSize;    // stored bytes of the vertices
+        uint64_t indexSize;     // stored bytes of the indices
+        uint64_t lodCount;
+        uint64_t lodOffset;     // byte offset of the lods from the file start
+        uint64_t meshletCount;
+        uint64_t meshletOffset;  // byte offset of the meshlets from the file start
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    // a cache entry mapped into memory, vertex and index data point into the mapping. shared with the meshes that
+    // are unpacked from it
+    struct MappedMesh {
+        std::shared_ptr<const MappedFile> file;
+        uint32_t flags = NONE;
+        const uint8_t *vertexData = nullptr;  // Vertex array, or a CompactVertex stream if COMPRESSED
+        const uint8_t *indexData = nullptr;   // IndexFormat array, or an index stream if COMPRESSED
+        uint64_t vertexSize = 0;
+        uint64_t indexSize = 0;
+        uint64_t vertexCount = 0;
+        uint64_t indexCount = 0;
+        std::vector<MeshLOD> lods;
+        std::vector<Meshlet> meshlets;  // the lods' meshlet ranges index into them
+        AABB boundingBox{glm::vec3(0), glm::vec3(0)};
+    };
+
+    static bool load(const std::string& sourcePath, uint32_t flags, MappedMesh& out);
+    static bool store(const std::string& sourcePath, uint32_t flags, const std::vector<Vertex>& vertices,
+                      const std::vector<IndexFormat>& indices, const std::vector<MeshLOD>& lods,
+                      const std::vector<Meshlet>& meshlets, const AABB& boundingBox);
+
+    // points the mesh into an uncompressed entry or decodes a compressed one into the mesh arrays, false if the
+    // compressed streams are corrupt
+    static bool unpack(const MappedMesh& cached, Mesh& mesh);
+
+    static std::string entryPath(const std::string& sourcePath);
+};
+
+}  // namespace gpro
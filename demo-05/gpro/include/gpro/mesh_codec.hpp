@@ -0,0 +1,27 @@
+#pragma once
+
+#include "gpro/shared.hpp"
+
+namespace gpro {
+
+// Lossless byte stream codecs for mesh data, in the spirit of meshoptimizer's codecs.
+// - indices: delta to the previous index, zigzag, stream vbyte (2-bit length codes, 1-4 data bytes per index)
+// - vertices: every byte of a vertex is delta coded against the previous vertex and zigzagged. groups of 16
+//   vertices are stored as byte planes, each packed with 0, 2, 4 or 8 bits per value
+// Decoding uses SSE2/SSSE3 or NEON where available and a scalar fallback otherwise.
+class MeshCodec {
+public:
+    static constexpr uint32_t GROUP_SIZE = 16;
+    static constexpr uint32_t MAX_VERTEX_STRIDE = 256;  // vertex strides must be a multiple of 4
+
+    static std::vector<uint8_t> encodeIndices(const IndexFormat *indices, size_t count);
+    static bool decodeIndices(const uint8_t *data, size_t size, IndexFormat *indices, size_t count);
+
+    static std::vector<uint8_t> encodeVertices(const void *vertices, size_t count, size_t stride);
+    static bool decodeVertices(const uint8_t *data, size_t size, void *vertices, size_t count, size_t stride);
+
+    // the decoder picked for this cpu
+    static const char *decoderName();
+};
+
+}  // namespace gpro
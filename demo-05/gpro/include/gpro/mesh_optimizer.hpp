@@ -0,0 +1,54 @@
+#pragma once
+
+#include "gpro/components.hpp"
+#include "gpro/shared.hpp"
+
+namespace gpro {
+
+// Post-load index/vertex reordering for the post-transform vertex cache and vertex fetch locality.
+// The cache can be simulated on the cpu, so the gains are measurable without a gpu.
+class MeshOptimizer {
+public:
+    enum class CacheModel { fifo, lru };
+
+    struct VertexCacheStats {
+        uint32_t transformedVertexCount = 0;  // cache misses
+        float acmr = 0;                       // average cache miss ratio: misses per triangle (0.5 - 3)
+        float atvr = 0;                       // average transformed vertex ratio: misses per referenced vertex (>= 1)
+    };
+
+    static constexpr uint32_t DEFAULT_CACHE_SIZE = 16;
+    static constexpr uint32_t MAX_MESHLET_VERTICES = 64;
+    static constexpr uint32_t MAX_MESHLET_TRIANGLES = 124;
+    static constexpr uint32_t MAX_LOD_COUNT = 5;
+
+    // triangle reordering for vertex cache locality (Tipsify, Sander et al. 2007)
+    static void optimizeVertexCache(std::vector<IndexFormat>& indices, size_t vertexCount,
+                                    uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+
+    // vertex reordering in first-use order of the indices, unreferenced vertices are dropped
+    static void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<IndexFormat>& indices);
+
+    // quadric error edge collapse (Garland & Heckbert 1997). the result indexes the same vertices, vertices on
+    // attribute seams and open borders are locked, so it can stop above the target. returns the object space error
+    static float simplify(const std::vector<Vertex>& vertices, const std::vector<IndexFormat>& indices,
+                          size_t targetIndexCount, std::vector<IndexFormat>& result);
+
+    // appends lods of halving triangle count to the indices until maxLodCount or until simplification stalls.
+    // lods[0] is the input
+    static void buildLodChain(const std::vector<Vertex>& vertices, std::vector<IndexFormat>& indices,
+                              std::vector<MeshLOD>& lods, uint32_t maxLodCount = MAX_LOD_COUNT);
+
+    // greedy split of each lod index range into meshlets with bounding spheres and normal cones. triangles keep
+    // their order, so run it after optimizeVertexCache for tight clusters
+    static void buildMeshlets(std::span<const Vertex> vertices, std::span<const IndexFormat> indices,
+                              std::vector<MeshLOD>& lods, std::vector<Meshlet>& meshlets,
+                              uint32_t maxVertices = MAX_MESHLET_VERTICES,
+                              uint32_t maxTriangles = MAX_MESHLET_TRIANGLES);
+
+    static VertexCacheStats analyzeVertexCache(const std::vector<IndexFormat>& indices, size_t vertexCount,
+                                               uint32_t cacheSize = DEFAULT_CACHE_SIZE,
+                                               CacheModel model = CacheModel::fifo);
+};
+
+}  // namespace gpro
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "gpro/shared.hpp"
+
+namespace gpro {
+
+// Multi-threaded Wavefront OBJ reader for v/vt/vn/f records.
+// The file is split into line-aligned chunks that are parsed on worker threads, the per-chunk results are merged
+// with a prefix sum over the per-chunk record counts. Polygons are fan-triangulated.
+class ObjParser {
+public:
+    static constexpr int32_t MISSING = -1;
+
+    struct Corner {  // zero-based attribute indices of a face corner, MISSING if not present
+        int32_t position;
+        int32_t uv;
+        int32_t normal;
+    };
+
+    struct Result {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> uvs;
+        std::vector<glm::vec3> normals;
+        std::vector<Corner> corners;  // 3 per triangle
+    };
+
+    // throws std::runtime_error on i/o or malformed records, threadCount 0 -> hardware concurrency
+    static void parse(const std::string& path, Result& out, uint32_t threadCount = 0);
+    static void parse(const char *data, size_t size, Result& out, uint32_t threadCount = 0);
+};
+
+}  // namespace gpro
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <optional>
+
+#include "gpro/shared.hpp"
+
+namespace gpro {
+
+// Cpu-observed pass latency. This is not a gpu measurement: tga cannot expose timestamp or pipeline statistics
+// queries. Instead, every interval-th frame is recorded as one submission per pass instead of one per frame, and each
+// pass is executed and waited for on its own. The latency is the cpu wall clock from execute to completion, so it
+// includes the submission, the gpu's idle time before it starts and the wake-up of the waiting thread, and only bounds
+// the pass's gpu time from above. The last HISTORY_LENGTH profiled frames are kept per pass.
+class PassProfiler {
+public:
+    static constexpr uint32_t HISTORY_LENGTH = 64;  // profiled frames
+
+    explicit PassProfiler(uint32_t interval) : m_interval(interval) {}  // 0: never profiles
+
+    // the command buffer the frame records its first pass into: cmdBuffer, or the profiler's own if the frame is
+    // profiled. the frames in flight have to be complete before a profiled frame
+    tga::CommandBuffer beginFrame(uint64_t frameIndex, tga::CommandBuffer cmdBuffer);
+    // until the next beginFrame
+    bool isProfiling() const { return m_isProfiling; }
+
+    // profiled frames: ends the recording of the pass, submits it and waits for it. the recorder then records the
+    // next pass, unless this was the last one. nothing otherwise
+    void endPass(const char *name, std::optional<tga::CommandRecorder>& cmdRecorder, bool isLastPass = false);
+
+    // the passes of the last profiled frame with their history, in submission order
+    void print() const;
+
+private:
+    struct Pass {
+        const char *name;
+        tga::CommandBuffer cmdBuffer{};  // reused by the next profiled frame
+        std::array<double, HISTORY_LENGTH> samples{};  // ms, ring
+    };
+
+    uint32_t m_interval;
+    bool m_isProfiling = false;
+    uint32_t m_passIndex = 0;      // in the profiled frame
+    uint64_t m_profiledCount = 0;  // frames
+    std::vector<Pass> m_passes;
+};
+
+}  // namespace gpro
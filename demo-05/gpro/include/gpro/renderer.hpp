@@ -1,8 +1,15 @@
 #pragma once
 
+#include "gpro/buffer_arena.hpp"
 #include "gpro/camera_controller.hpp"
 #include "gpro/shared.hpp"
 #include "gpro/components.hpp"
+#include "gpro/deferred_release.hpp"
+#include "gpro/mesh_optimizer.hpp"
+#include "gpro/pass_profiler.hpp"
+#include "gpro/texture_registry.hpp"
+#include "gpro/thread_pool.hpp"
+#include "gpro/virtual_texture_streamer.hpp"
 
 namespace gpro {
 
@@ -17,65 +24,247 @@ public:
     void initLights(std::vector<Light>& lights);
     void initTime(float time);
 
+    // allocates the object's ranges in the arena pools and fills them on the cpu, uploaded by the next commit
     void batch(const SceneObject& so);
+    // uploads everything batched or changed since the last commit, called by render once per frame
+    void commit();
+    // patches the instances of a batched scene object in place. the object only moves to a new instance range if
+    // the instance count exceeds its slots
+    void updateInstances(uint32_t objectIndex, const std::vector<Transform>& transforms);
+    // batches so in place of a batched scene object (a reloaded mesh or diffuse map) and frees the old one's ranges
+    void replace(uint32_t objectIndex, const SceneObject& so);
 
     void render(tga::Window& window);
 
+#ifdef GPRO_VIRTUAL_TEXTURES
+    VirtualTextureStreamer& virtualTextures() { return m_virtualTextures; }
+#else
+    TextureRegistry& textureRegistry() { return m_textureRegistry; }
+#endif
+
 private:
-    struct BatchGPU  { // TODO: create different systems for dynamic and static batches
-        tga::Buffer verticesBuffer;
-        tga::Buffer indicesBuffer;
-        std::vector<tga::Texture> diffuseMaps;
-        uint32_t size = 0;
-        uint32_t instanceCount = 0;
-        uint32_t diicmdOffset = 0;
+    static constexpr uint32_t INVALID_MESH_ID = ~0u;  // free instance slot or draw, skipped by the culling passes
+    static constexpr uint32_t STATS_INTERVAL = 300;   // frames between the culling stats and frame timing prints
+    // visible list entries per culling phase. draws past it get no list, their clusters are counted as dropped
+    static constexpr uint32_t MAX_VISIBLE_LIST_CAPACITY = 1 << 22;
+    // the cluster pass loops over the surviving instances with up to this many work groups
+    static constexpr uint32_t MAX_CLUSTER_CULLING_WORK_GROUPS = 8192;
+
+#ifdef GPRO_COMPACT_VERTICES
+    using GPUVertex = CompactVertex;
+#else
+    using GPUVertex = Vertex;
+#endif
+
+    // lod selection data of a mesh and the draws of each lod (std430)
+    struct MeshLODs {
+        alignas(16) glm::vec3 center;  // bounding sphere, mesh space
+        float radius;
+        float errors[MeshOptimizer::MAX_LOD_COUNT];
+        uint32_t lodCount;
+        uint32_t drawOffset;  // draw of the first meshlet, draw j renders meshlet j
+        uint32_t meshletOffsets[MeshOptimizer::MAX_LOD_COUNT];  // relative to the mesh
+        uint32_t meshletCounts[MeshOptimizer::MAX_LOD_COUNT];
+    };
+
+    // what a draw renders, besides its indirect command (std430)
+    struct DrawInfo {
+        uint32_t meshletID;
+        uint32_t meshID;  // INVALID_MESH_ID once freed
+    };
+
+    // geometry and instance data, sub-allocated from arena pools. every pool holds the elements of all scene objects,
+    // so one vertex and one index buffer serve every draw
+    BufferArena m_arena;
+    ArenaPool m_vertexPool{"vertices", 1 << 20};
+    ArenaPool m_indexPool{"indices", 1 << 22};
+    ArenaPool m_meshPool{"meshes", 256};
+    ArenaPool m_meshletPool{"meshlets", 1 << 16};
+    ArenaPool m_instancePool{"instances", 1 << 14};
+    ArenaPool m_drawPool{"draws", 1 << 16};
+    const std::array<ArenaPool *, 6> m_pools{&m_vertexPool,  &m_indexPool,    &m_meshPool,
+                                             &m_meshletPool, &m_instancePool, &m_drawPool};
+
+    ArenaBuffer<GPUVertex> m_vertices{m_arena, m_vertexPool, tga::BufferUsage::vertex};
+    ArenaBuffer<IndexFormat> m_indices{m_arena, m_indexPool, tga::BufferUsage::index};
+    ArenaBuffer<AABB> m_aabbs{m_arena, m_meshPool, tga::BufferUsage::storage, AABB{glm::vec3(0), glm::vec3(0)}};
+    ArenaBuffer<MeshLODs> m_meshLODs{m_arena, m_meshPool, tga::BufferUsage::storage};
+    ArenaBuffer<Meshlet> m_meshlets{m_arena, m_meshletPool, tga::BufferUsage::storage};
+    ArenaBuffer<Transform> m_models{m_arena, m_instancePool, tga::BufferUsage::storage};
+    ArenaBuffer<uint32_t> m_instanceIDToMeshIDMap{m_arena, m_instancePool, tga::BufferUsage::storage,
+                                                  INVALID_MESH_ID};
+    // diffuse map ids in m_textureRegistry/m_virtualTextures
+    ArenaBuffer<uint32_t> m_instanceIDToTextureIDMap{m_arena, m_instancePool, tga::BufferUsage::storage};
+    // 1 if a cluster of the instance was drawn last frame, gpu written
+    ArenaBuffer<uint32_t> m_instanceVisibility{m_arena, m_instancePool, tga::BufferUsage::storage};
+    // one draw per mesh meshlet. the culling passes set the instance count to the visible instances, which they list
+    // from the first instance on in m_visibleInstanceIDsBuffer
+    ArenaBuffer<tga::DrawIndexedIndirectCommand> m_diicmds{
+        m_arena, m_drawPool, tga::BufferUsage::indirect | tga::BufferUsage::storage, tga::DrawIndexedIndirectCommand{}};
+    ArenaBuffer<DrawInfo> m_drawInfos{m_arena, m_drawPool, tga::BufferUsage::storage, DrawInfo{0, INVALID_MESH_ID}};
+    // occlusion culling phase 2, the same draws with the instances that became visible
+    ArenaBuffer<tga::DrawIndexedIndirectCommand> m_occlusionDiicmds{
+        m_arena, m_drawPool, tga::BufferUsage::indirect | tga::BufferUsage::storage, tga::DrawIndexedIndirectCommand{}};
+    uint32_t m_maxMeshVertexCount = 0;  // decides if 16-bit indices would suffice
+
+    tga::Buffer m_cullingStatsBuffer;
+    tga::Buffer m_cullingParamsBuffer, m_occlusionCullingParamsBuffer;
+
+    // gpu-only buffers of the culling passes, one per phase (0/1 and 2), recreated by _reserveCullingBuffers. the
+    // counters are the survivor count, the visible list cursor and the surviving instances per mesh lod, the survivors
+    // the instance id and lod of each instance that passed the instance pass. the visible lists of all draws share
+    // one buffer, a draw's list is as long as the instances that picked its lod
+    tga::Buffer m_cullingCountersBuffer, m_occlusionCullingCountersBuffer;
+    tga::Buffer m_survivorsBuffer, m_occlusionSurvivorsBuffer;
+    tga::Buffer m_visibleInstanceIDsBuffer, m_occlusionVisibleInstanceIDsBuffer;
+    uint32_t m_cullingMeshCapacity = 0;  // meshes the counters hold
+    uint32_t m_survivorCapacity = 0;     // instance slots
+    uint32_t m_visibleListCapacity = 0;  // visible instance ids
+    uint64_t m_visibleListSize = 0;      // instances times the meshlets of their largest lod, the longest lists
+
+    // written by the culling passes and the forward passes
+    struct CullingStats {
+        uint32_t fragmentCount;
+        uint32_t visibleClusterCount;
+        uint32_t occludedClusterCount;  // by the depth pyramid
+        uint32_t visibleTriangleCount;
+        uint32_t lodTriangleCounts[MeshOptimizer::MAX_LOD_COUNT];  // visible triangles per lod
+        uint32_t visibleInstanceCount;  // passed the instance pass
+        uint32_t droppedClusterCount;   // visible, but their draw did not fit into the visible lists
+    };
+
+    // cpu side of a frame
+    struct FrameTiming {
+        double updateMs = 0;  // scene update and loading since the last frame
+        double waitMs = 0;    // for the slot's last frame
+        double commitMs = 0;
+        double acquireMs = 0;  // swapchain image
+        double recordMs = 0;
+        double submitMs = 0;  // execute and present
+        double uploadMs = 0;  // part of record: staging copies and upload commands of the arena
+        uint64_t uploadedBytes = 0;
+        uint32_t batchCount = 0;  // batched scene objects
+    };
+
+    // per frame slot, reused once the slot's last frame (FRAMES_IN_FLIGHT frames ago) has completed. the culling stats
+    // are downloaded by the frame's own commands and read then, the scene sizes are kept for the print
+    struct FrameResources {
+        uint64_t frameIndex = 0;
+        tga::CommandBuffer cmdBuffer{};
+        std::chrono::steady_clock::time_point submitTime;
+        FrameTiming timing;
+        tga::StagingBuffer cullingStatsStaging;
+        bool isPending = false;
+        uint32_t drawCount;
+        uint32_t instanceCount;
+        uint64_t submittedTriangleCount;
+    };
+    std::array<FrameResources, FRAMES_IN_FLIGHT> m_frames;
+    uint64_t m_frameIndex = 0;  // recorded frames
+    std::chrono::steady_clock::time_point m_lastRenderEnd;
+
+    // the completed frames since the last frame timing print, summed
+    struct FrameTimingTotals {
+        FrameTiming sum;
+        double gpuLatencyMs = 0;
+        double maxCpuMs = 0;
+        double maxWaitMs = 0;
+        uint32_t frameCount = 0;
+        uint32_t uploadFrameCount = 0;
+    };
+    FrameTimingTotals m_timingTotals;
+
+    // the buffers have spare capacity
+    struct CullingParams {
+        float lodErrorScale;
+        uint32_t drawCount;
+        uint32_t instanceSlotCount;
+        uint32_t phase;  // 0: no occlusion culling, 1: visible last frame, 2: newly visible
+        uint32_t screenWidth;
+        uint32_t screenHeight;
+        uint32_t pyramidLevelCount;
+        uint32_t meshCount;
+        uint32_t visibleListCapacity;
+    };
+    CullingParams m_cullingParams;
+
+    // occlusion culling. the first forward pass writes its nearest depth per pixel into the depth copy (the window's
+    // depth buffer cannot be bound), which is reduced to a pyramid of farthest depths for phase 2
+    struct DepthCopyHeader {
+        uint32_t width;
+        uint32_t isWritten;
     };
-    std::vector<BatchGPU> m_batchesGPU;
-    tga::Buffer m_modelsBuffer;                 // per instance
-    tga::Buffer m_aabbsBuffer;                  // per mesh
-    tga::Buffer m_visibleObjectCountBuffer;     // per instance
-    tga::Buffer m_diicmdsBuffer;                // per instance (TODO: make it work per mesh)
-    tga::Buffer m_instanceIDToMeshIDMapBuffer;  // per instance
-
-    struct BatchCPU { // TODO: use staging buffer with mapping instead of duplicate data
-        BatchCPU() : vertexOffset(0), indexOffset(0), size(0), byte(0), index(0), isPushed(false) {}
-
-        int32_t vertexOffset = 0;
-        uint32_t indexOffset = 0;
-        uint32_t size = 0;                                      // mesh count
-        uint32_t byte = 0;                                      // byte
-        uint32_t index = 0;                                     // batch index  
-        uint32_t instanceCount = 0;                             // total number of instance
-        std::vector<Vertex> vertices;
-        std::vector<IndexFormat> indices;
-        std::vector<tga::Texture> diffuseMaps;
-        bool isPushed = false;
+    struct DepthPyramidParams {
+        uint32_t screenWidth;
+        uint32_t screenHeight;
+        uint32_t levelCount;
+        uint32_t level;
     };
-    std::vector<BatchCPU> m_batchesCPU;
-    std::vector<Transform> m_models;
-    std::vector<AABB> m_aabbs;
-    tga::StagingBuffer m_visibleObjectCountStaging;
-    std::vector<tga::DrawIndexedIndirectCommand> m_diicmds;
-    std::vector<uint32_t> m_instanceIDToMeshIDMap;
+    tga::Buffer m_depthCopyBuffer;
+    tga::Buffer m_depthPyramidBuffer;
+    tga::Buffer m_depthPyramidParamsBuffer;
+    uint64_t m_submittedTriangleCount = 0;  // triangles of all instances, before culling
+    uint32_t m_instanceCount = 0;           // of all scene objects
 
+    // arena ranges of a batched scene object. the instance slots past instanceCount are free, their instance id to
+    // mesh id entries are INVALID_MESH_ID
     struct BatchedObjectData {
-        uint32_t batchIndex;
-        uint32_t index;
+        ArenaPool::Range vertices;
+        ArenaPool::Range indices;
+        ArenaPool::Range meshlets;
+        ArenaPool::Range instances;
+        ArenaPool::Range draws;       // one per meshlet
+        uint32_t meshID;              // in the mesh pool
+        uint32_t diffuseMapID;
+        uint32_t instanceCount;
+        uint32_t triangleCount;       // full detail, per instance
+        uint32_t maxLODMeshletCount;  // of the lod with the most meshlets
     };
-    std::unordered_map<uint32_t, BatchedObjectData> m_batchedObjectMap;
+    std::vector<BatchedObjectData> m_batchedObjects;  // per scene object
 
-    tga::CommandBuffer m_cmdBuffer{};
+    // cpu-observed latency per pass, every GPRO_PROFILE_PASSES-th frame
+    PassProfiler m_passProfiler{GPRO_PROFILE_PASSES};
 
-    // render passes
-    std::vector<tga::RenderPass> m_renderPasses;
-    std::vector<std::vector<tga::InputSet>> m_inputSets;
+    // copies the arena uploads into the frame's staging buffer with the render thread, null if it copies alone.
+    // tga is only called from the render thread
+    std::unique_ptr<ThreadPool> m_stagingCopyPool;
+
+    // replaced by a commit, the frames in flight may still use them
+    DeferredRelease<tga::InputSet> m_releasedInputSets;
+
+    // forward render pass
+    tga::RenderPass m_renderPass;
+    tga::InputSet m_camAndLightInputSet;
+    tga::InputSet m_modelsInputSet;
+    tga::RenderPass m_occlusionRenderPass;  // phase 2, keeps the color and depth of the first pass
+    tga::InputSet m_occlusionModelsInputSet;
+#ifdef GPRO_VIRTUAL_TEXTURES
+    VirtualTextureStreamer m_virtualTextures;  // diffuse maps
+#else
+    TextureRegistry m_textureRegistry;  // diffuse maps
+#endif
     tga::Shader m_vertexShader;
     tga::Shader m_fragmentShader;
 
-    // frustum culling pass
-    tga::ComputePass m_frustumCullingPass;
-    tga::InputSet m_frustumCullingPassInputSet;
-    tga::Shader m_frustumCullingComputeShader;
+    // culling passes after the reset pass: instance culling (frustum, lod, occlusion), visible list allocation per
+    // draw and cluster culling of the surviving instances. phase 2 of the occlusion culling has its own input sets
+    tga::ComputePass m_resetCullingPass;
+    tga::InputSet m_resetCullingPassInputSet;
+    tga::Shader m_resetCullingComputeShader;
+    tga::ComputePass m_instanceCullingPass;
+    tga::InputSet m_instanceCullingPassInputSet, m_occlusionInstanceCullingPassInputSet;
+    tga::Shader m_instanceCullingComputeShader;
+    tga::ComputePass m_visibleListPass;
+    tga::InputSet m_visibleListPassInputSet, m_occlusionVisibleListPassInputSet;
+    tga::Shader m_visibleListComputeShader;
+    tga::ComputePass m_clusterCullingPass;
+    tga::InputSet m_clusterCullingPassInputSet, m_occlusionClusterCullingPassInputSet;
+    tga::Shader m_clusterCullingComputeShader;
+
+    // depth pyramid pass, one dispatch per level
+    tga::ComputePass m_depthPyramidPass;
+    tga::InputSet m_depthPyramidPassInputSet;
+    tga::Shader m_depthPyramidComputeShader;
 
     // uniforms
     tga::Buffer m_camBuffer, m_frustumBuffer;       // camera buffers
@@ -84,9 +273,24 @@ private:
     tga::Buffer m_timeBuffer;                       // app time buffer
 
 private:
-    void _flushBatch(bool createNextBatchData);
-    void _updateRenderPass(bool isNewRenderPass);
-    void _updateFrustumCullingPass();
+    BatchedObjectData _batch(const SceneObject& so);
+    void _freeObject(const BatchedObjectData& object);
+    void _createDraws(const BatchedObjectData& object);
+    void _growInstances(BatchedObjectData& object, uint32_t instanceCapacity);
+#ifdef GPRO_VERBOSE
+    void _printArenaStats(double commitMs);
+#endif
+    void _printCullingStats(const FrameResources& frame);
+    // prints the averages once STATS_INTERVAL frames are summed
+    void _addFrameTiming(const FrameTiming& timing, double gpuLatencyMs);
+    // grows the culling buffers with the pools and the visible list size, true if one was recreated
+    bool _reserveCullingBuffers();
+    void _updateRenderPassInputSets();
+    void _updateCullingPassInputSets();
+#ifdef GPRO_VALIDATE_CULLING
+    // the culling shader's plane tests against FrustumCuller on a million random spheres and boxes, printed
+    void _validateFrustumCulling(const glm::vec3& eye);
+#endif
 
 private:
     static Renderer *s_instance;
@@ -11,6 +11,8 @@ class Scene {
 public:
     void init();
     void addSceneObject(const SceneObject& so);
+    void updateSceneObject(uint32_t index, std::vector<Transform> transforms);
+    void replaceSceneObject(uint32_t index, const SceneObject& so);
     void onUpdate();
 
 private:
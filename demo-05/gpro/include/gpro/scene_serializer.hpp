@@ -2,28 +2,88 @@
 
 #include <yaml-cpp/yaml.h>
 
+#include <unordered_set>
+
+#include "gpro/file_watcher.hpp"
+#include "gpro/handoff_queue.hpp"
 #include "gpro/scene.hpp"
 #include "gpro/shared.hpp"
+#include "gpro/texture_cache.hpp"
+#include "gpro/texture_loader.hpp"
+#include "gpro/thread_pool.hpp"
 
 namespace gpro {
 
 class SceneSerializer {
 public:
     SceneSerializer(std::shared_ptr<Scene> scene);
+    ~SceneSerializer();
+
+    // scans the models folder on the first call, afterwards only handles the changed files reported by the file
+    // watcher. starts loading new models in the background, returns true if any load was started
     bool deserialize();
 
+    // adds models that finished loading to the scene, call once per frame on the render thread
+    void processLoadedModels();
+
 private:
+    // of a model's obj and png when its load started, a rescan reloads the model if they changed
+    struct ModelFileTimes {
+        std::filesystem::file_time_type mesh;
+        std::filesystem::file_time_type diffuseMap;
+    };
+
+    // everything a model needs, prepared off the render thread
+    struct ModelAsset {
+        std::string name;
+        bool isLoaded = false;
+        Mesh mesh;
+        AABB boundingBox{glm::vec3(0), glm::vec3(0)};
+        std::vector<Transform> transforms;
+        uint32_t instanceCount = 0;
+        std::string diffusePath;  // loaded by the texture loader
+        ModelFileTimes fileTimes;
+        double loadMs = 0;
+    };
+
+    // first, so the loader is constructed after it. stopped by the destructor before the members its loads use
+    ThreadPool m_threadPool;
+
     std::shared_ptr<Scene> m_scene;
 
     std::unordered_map<std::string, uint32_t> m_modelNameToSceneObject;
+    std::unordered_map<std::string, ModelFileTimes> m_modelFileTimes;  // of the models in the scene
+    std::unordered_set<std::string> m_pendingModels;  // loads in flight, render thread only
+    // changed while their load was in flight, loaded again once it is in. true: the diffuse map changed too
+    std::unordered_map<std::string, bool> m_staleModels;
+    std::vector<ModelAsset> m_waitingModels;          // loaded, waiting for their diffuse map, render thread only
+    std::chrono::steady_clock::time_point m_sceneLoadStartTime;
+
+    HandoffQueue<ModelAsset> m_loadedModels;  // workers -> render thread
+    TextureLoader m_textureLoader{m_threadPool};
 
-    // Initialize start time
-    std::chrono::time_point<std::chrono::file_clock> m_lastUpdateTime;
+    // model configs/meshes and diffuse maps
+    FileWatcher m_fileWatcher;
+    bool m_isScanned = false;
 
 private:
     bool _deserializeModels();
-    bool _deserializeModel(const std::string& modelName, const YAML::Node& data);
-    bool _deserializeModelConfig(const YAML::Node& data, glm::vec3& position, float& scale, uint32_t& instanceCount);
+    // the watcher lost events: every model in the scene is checked against its files, new ones are requested
+    bool _rescanModels();
+    bool _onFileEvent(const FileEvent& event);
+    bool _requestModel(const std::string& modelName);
+    void _updateModel(const std::string& modelName);
+    bool _reloadModel(const std::string& modelName, bool reloadDiffuseMap);
+    void _hideModel(const std::string& modelName);
+    AsyncTask _loadModelAsync(std::string modelName);
+    bool _loadModel(const std::string& modelName, ModelAsset& asset);
+    AABB _loadMesh(const std::string& modelPath, bool optimize, Mesh& mesh);
+    void _optimizeMesh(const std::string& modelPath, Mesh& mesh);
+    void _buildLods(const std::string& modelPath, Mesh& mesh);
+    static void _createTransforms(const glm::vec3& position, float scale, uint32_t instanceCount,
+                                  std::vector<Transform>& transforms);
+    bool _deserializeModelConfig(const YAML::Node& data, glm::vec3& position, float& scale, uint32_t& instanceCount,
+                                 bool& optimizeMesh, TextureCache::Encoding& diffuseEncoding);
     bool _loadYAML(const std::string& path, YAML::Node& data);
 };
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstring>
 #include <ctime>
 #include <glm/gtc/random.hpp>
 #include <limits>
@@ -20,6 +21,19 @@ namespace gpro
 
 typedef uint32_t IndexFormat;
 
+#ifndef GPRO_FRAMES_IN_FLIGHT
+#define GPRO_FRAMES_IN_FLIGHT 2
+#endif
+
+// frames the cpu records ahead of the gpu. per-frame resources are reused once the frame that used them
+// FRAMES_IN_FLIGHT frames ago has completed
+constexpr uint32_t FRAMES_IN_FLIGHT = GPRO_FRAMES_IN_FLIGHT;
+static_assert(FRAMES_IN_FLIGHT >= 1, "at least one frame has to be in flight");
+
+#ifndef GPRO_PROFILE_PASSES
+#define GPRO_PROFILE_PASSES 0  // every n-th frame is submitted pass by pass and its latency printed, 0: never
+#endif
+
 struct Vertex {
     glm::vec3 position;
     glm::vec2 uv;
@@ -31,6 +45,37 @@ struct Vertex {
     }
 };
 
+// quantized vertex (16 bytes): position as unorm16 relative to the mesh AABB, uv as half floats,
+// normal as octahedral snorm16
+struct CompactVertex {
+    uint16_t position[4];  // w is padding
+    uint16_t uv[2];
+    int16_t normal[2];
+};
+
+// mixing hash over the raw vertex bytes, -0.0f is folded into 0.0f to stay consistent with operator==
+inline uint64_t hashVertex(const Vertex& v)
+{
+    static_assert(sizeof(Vertex) == 8 * sizeof(uint32_t));
+
+    uint32_t words[8];
+    std::memcpy(words, &v, sizeof(Vertex));
+
+    uint64_t h = 0x9e3779b97f4a7c15ull;
+    for (int i = 0; i < 8; i += 2) {
+        uint64_t lo = words[i] == 0x80000000u ? 0 : words[i];
+        uint64_t hi = words[i + 1] == 0x80000000u ? 0 : words[i + 1];
+        h = (h ^ (lo | hi << 32)) * 0xff51afd7ed558ccdull;
+        h ^= h >> 32;
+    }
+
+    // murmur3 finalizer
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
 }  // namespace gpro
 
 namespace std
@@ -39,8 +84,7 @@ template <>
 struct hash<gpro::Vertex> {
     size_t operator()(gpro::Vertex const& v) const
     {
-        return ((hash<glm::vec3>()(v.position) ^ (hash<glm::vec3>()(v.normal) << 1)) >> 1) ^
-               (hash<glm::vec2>()(v.uv) << 1);
+        return static_cast<size_t>(gpro::hashVertex(v));
     }
 };
 }  // namespace std
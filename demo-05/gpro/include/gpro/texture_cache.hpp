@@ -0,0 +1,72 @@
+#pragma once
+
+#include "gpro/mapped_file.hpp"
+#include "gpro/shared.hpp"
+
+namespace gpro {
+
+// Binary cache of decoded textures with their full mip chain, stored under GPRO_CACHE_DIR. Levels are 16 byte
+// aligned in the file, so each one can be copied to a staging buffer straight from the mapping.
+// Entries are keyed like the mesh cache: source path, write time, size and content hash.
+// With a page size, rgba8 levels are stored as square pages of pageSize^2 texels instead of rows, for virtual
+// texture streaming: pages are row-major within a level, edge pages are padded, so every page is one contiguous read.
+class TextureCache {
+public:
+    static constexpr uint32_t MAGIC = 0x544F5247;  // "GROT"
+    static constexpr uint32_t VERSION = 2;
+
+    enum class Encoding : uint32_t {
+        rgba8 = 0,
+        bc1 = 1,  // opaque, 8 bytes per 4x4 block
+        bc7 = 2,  // 16 bytes per 4x4 block
+    };
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        Encoding encoding;
+        uint32_t isSRGB;  // mips were filtered in linear space
+        uint32_t width;
+        uint32_t height;
+        uint32_t levelCount;
+        uint32_t pageSize;  // 0: rows
+        int64_t sourceWriteTime;
+        uint64_t sourceSize;
+        uint64_t sourceHash;
+        uint64_t sourcePathLength;  // path follows the header, then levelCount LevelHeaders
+    };
+
+    struct LevelHeader {
+        uint32_t width;
+        uint32_t height;
+        uint64_t offset;  // byte offset from the file start
+        uint64_t size;
+    };
+
+    struct Level {
+        uint32_t width;
+        uint32_t height;
+        const uint8_t *data;  // points into the mapping
+        uint64_t size;
+    };
+
+    struct MappedTexture {
+        MappedFile file;
+        Encoding encoding = Encoding::rgba8;
+        uint32_t pageSize = 0;
+        std::vector<Level> levels;  // levels[0] is the full resolution image
+    };
+
+    static bool load(const std::string& sourcePath, Encoding encoding, bool isSRGB, uint32_t pageSize,
+                     MappedTexture& out);
+    // builds the mip chain of an rgba8 image and encodes it, cpu only. pages are rgba8 only
+    static bool store(const std::string& sourcePath, Encoding encoding, bool isSRGB, uint32_t pageSize,
+                      const tga::Image& image);
+
+    static uint32_t pageCount(uint32_t width, uint32_t height, uint32_t pageSize);  // of a level
+
+    static std::string entryPath(const std::string& sourcePath);
+    static const char *encodingName(Encoding encoding);
+};
+
+}  // namespace gpro
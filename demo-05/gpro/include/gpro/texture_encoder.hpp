@@ -0,0 +1,38 @@
+#pragma once
+
+#include "gpro/shared.hpp"
+
+namespace gpro {
+
+// CPU texture processing for the texture cache: mip chains and block compression of rgba8 images.
+// Nothing here needs a gpu, so cache entries can be built on any machine.
+class TextureEncoder {
+public:
+    static constexpr uint32_t BLOCK_SIZE = 4;  // texels per block side
+    static constexpr uint32_t BC1_BLOCK_BYTES = 8;
+    static constexpr uint32_t BC7_BLOCK_BYTES = 16;
+
+    struct Level {
+        uint32_t width;
+        uint32_t height;
+        std::vector<uint8_t> data;  // rgba8
+    };
+
+    // 2x2 box filtered chain down to 1x1, levels[0] is a copy of the image. levels are filtered in 16-bit
+    // (sse2/neon), color in linear space if isSRGB
+    static std::vector<Level> buildMipChain(const uint8_t *rgba, uint32_t width, uint32_t height, bool isSRGB);
+
+    // edge blocks are padded by repeating the last row/column
+    // bc1: opaque 4-color blocks, alpha is dropped. bc7: mode 6 blocks (rgba, 7-bit endpoints + p-bit, 4-bit indices)
+    static std::vector<uint8_t> encodeBC1(const uint8_t *rgba, uint32_t width, uint32_t height);
+    static std::vector<uint8_t> encodeBC7(const uint8_t *rgba, uint32_t width, uint32_t height);
+
+    // into width * height * 4 bytes. the bc7 decoder only reads mode 6, as written by encodeBC7, and
+    // returns false on other modes
+    static void decodeBC1(const uint8_t *blocks, uint32_t width, uint32_t height, uint8_t *rgba);
+    static bool decodeBC7(const uint8_t *blocks, uint32_t width, uint32_t height, uint8_t *rgba);
+
+    static size_t blockCompressedSize(uint32_t width, uint32_t height, uint32_t blockBytes);
+};
+
+}  // namespace gpro
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <unordered_set>
+
+#include "gpro/handoff_queue.hpp"
+#include "gpro/shared.hpp"
+#include "gpro/texture_cache.hpp"
+#include "gpro/thread_pool.hpp"
+
+namespace gpro {
+
+// Loads textures once per path. Decoding, mips and the texture cache run as separate tasks on the thread pool, the
+// gpu textures are created on the render thread, added to the renderer's texture registry and shared by everything
+// that requests the same path.
+class TextureLoader {
+public:
+    // the pool has to be stopped before the loader is destroyed, its workers push into the loader
+    explicit TextureLoader(ThreadPool& threadPool);
+
+    // starts loading the path unless it is loaded or in flight, any thread
+    void request(const std::string& path, TextureCache::Encoding encoding);
+
+    // creates the gpu textures of every decode that finished, all in the same frame. render thread only
+    void processLoaded();
+
+    // render thread only: the texture registry id, false while the texture is in flight or after it failed
+    bool find(const std::string& path, uint32_t& textureID) const;
+    bool isPending(const std::string& path);
+    // forgets a loaded path, so the next request loads it again (the file changed). the texture stays in the registry
+    // as long as the scene objects that use it. render thread only
+    void invalidate(const std::string& path);
+
+private:
+    struct TextureAsset {
+        std::string path;
+        bool isLoaded = false;
+        TextureCache::MappedTexture texture;  // rows flipped to match the uv convention
+        tga::Image image;  // rgba8 level 0, if the cached one cannot be uploaded straight from the mapping
+        double loadMs = 0;
+    };
+
+    AsyncTask _loadAsync(std::string path, TextureCache::Encoding encoding);
+    bool _load(const std::string& path, TextureCache::Encoding encoding, TextureAsset& asset);
+    bool _decodeImage(const std::string& path, tga::Image& image);
+
+    ThreadPool& m_threadPool;
+
+    std::mutex m_requestMutex;
+    std::unordered_set<std::string> m_requested;  // in flight or uploaded, guarded by m_requestMutex
+
+    HandoffQueue<TextureAsset> m_loadedTextures;  // workers -> render thread
+    std::unordered_map<std::string, uint32_t> m_textureIDs;  // holds one registry reference each
+};
+
+}  // namespace gpro
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "gpro/deferred_release.hpp"
+
+namespace gpro {
+
+// Global, append-only table of the textures sampled by the forward pass (set 1, binding 0). Textures keep their
+// index for their whole lifetime, released slots are recycled. Unused slots hold a 1x1 white texture, so the
+// sampler array is always fully bound and its layout never changes.
+// tga input sets cannot be updated, so the table's single input set is recreated once per frame at most, and only
+// when a texture was added or released.
+class TextureRegistry {
+public:
+    static constexpr uint32_t MAX_TEXTURE_COUNT = 1024;
+    static constexpr uint32_t DEFAULT_TEXTURE_ID = 0;  // white, also handed out when the table is full
+
+    void init();
+
+    // takes ownership of the texture, the returned id holds one reference
+    uint32_t add(tga::Texture texture);
+    void retain(uint32_t id);
+    void release(uint32_t id);  // the texture is freed and its slot recycled with the last reference
+
+    // recreates the input set if the table changed since the last call. render thread, once per frame before recording
+    void update(tga::RenderPass renderPass, uint32_t setIndex);
+    tga::InputSet inputSet() const { return m_inputSet; }
+
+    uint32_t textureCount() const { return static_cast<uint32_t>(m_textures.size() - m_freeIDs.size()); }
+
+private:
+    std::vector<tga::Texture> m_textures;  // by id, m_textures[DEFAULT_TEXTURE_ID] is the default texture
+    std::vector<uint32_t> m_refCounts;
+    std::vector<uint32_t> m_freeIDs;
+    bool m_isDirty = true;
+
+    tga::InputSet m_inputSet;
+    // the frames in flight may still use them
+    DeferredRelease<tga::Texture> m_releasedTextures;
+    DeferredRelease<tga::InputSet> m_releasedInputSets;
+};
+
+}  // namespace gpro
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+#include "gpro/shared.hpp"
+
+namespace gpro {
+
+// Worker threads that resume coroutines. `co_await pool.schedule()` continues the calling coroutine on a worker.
+class ThreadPool {
+public:
+    explicit ThreadPool(uint32_t threadCount = 0);  // 0 -> one less than the hardware threads, at least 1
+    ~ThreadPool();  // stop()
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    auto schedule() {
+        struct Awaiter {
+            ThreadPool& pool;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { pool._enqueue(handle); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this};
+    }
+
+    // calls fn(0..count-1) on the workers and the calling thread, returns when every call has returned. workers busy
+    // with other coroutines join late or not at all, the calling thread does what is left
+    void parallelFor(uint32_t count, const std::function<void(uint32_t)>& fn);
+
+    // joins the workers once their current coroutines suspend or finish and destroys the coroutines that never got
+    // one. owners whose members the coroutines use call it before those members are destroyed
+    void stop();
+
+    uint32_t threadCount() const { return static_cast<uint32_t>(m_threads.size()); }
+
+private:
+    void _enqueue(std::coroutine_handle<> handle);
+    void _run();
+
+    std::vector<std::thread> m_threads;
+    std::deque<std::coroutine_handle<>> m_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_isStopping = false;
+};
+
+// eagerly started coroutine without a result, the frame is destroyed when the body finishes.
+// the body is responsible for its own errors
+struct AsyncTask {
+    struct promise_type {
+        AsyncTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+}  // namespace gpro
@@ -1,20 +1,57 @@
 #pragma once
 
+#include <span>
+
 #include "gpro/shared.hpp"
 
 namespace gpro::util {
 
 tga::Buffer createBuffer(tga::BufferUsage usage, size_t size, uint8_t const *data);
+// buffer of capacity bytes, the first size bytes are copied from data
+tga::Buffer createBuffer(tga::BufferUsage usage, size_t capacity, uint8_t const *data, size_t size);
 tga::Buffer createUniformBuffer(size_t size, uint8_t const *data);
 tga::Buffer createStorageBuffer(size_t size, uint8_t const *data);
 tga::Buffer createVertexBuffer(std::vector<Vertex>& vertices);
+tga::Buffer createVertexBuffer(std::vector<CompactVertex>& vertices);
 tga::Buffer createIndexBuffer(std::vector<IndexFormat>& indices);
 tga::Buffer createDrawIndexedIndirectBuffer(std::vector<tga::DrawIndexedIndirectCommand> diicmds);
+tga::Texture createTexture(const tga::Image& image, tga::Format format, tga::SamplerMode samplerMode);
+tga::Texture createTexture(uint32_t width, uint32_t height, const uint8_t *data, size_t size, tga::Format format,
+                           tga::SamplerMode samplerMode);
 
 glm::vec3 rnd3();
 
+// 64-bit FNV-1a
+uint64_t hashBytes(const uint8_t *data, size_t size);
+
+// source file keys for the on-disk caches: write time + size, and the hash of the contents
+bool fileStamp(const std::string& path, int64_t& writeTime, uint64_t& size);
+bool hashFile(const std::string& path, uint64_t& hash);
+// same size and write time, or same contents for touched files
+bool isFileUnchanged(const std::string& path, int64_t writeTime, uint64_t size, uint64_t hash);
+
+inline uint64_t alignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+// range checks for offsets and sizes read from a cache entry, a corrupt one must not wrap around them
+inline bool isInFile(uint64_t offset, uint64_t size, uint64_t fileSize) {
+    return offset <= fileSize && size <= fileSize - offset;
+}
+inline bool isArrayInFile(uint64_t offset, uint64_t count, uint64_t stride, uint64_t fileSize) {
+    return offset <= fileSize && count <= (fileSize - offset) / stride;
+}
+
 void loadObj(const std::string& objFilePath, std::vector<Vertex>& vBuffer, std::vector<IndexFormat>& iBuffer);
 
+// quantizes vertices into the compact layout, positions are stored relative to [boundsMin, boundsMax]
+void quantizeVertices(std::span<const Vertex> vertices, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                      std::vector<CompactVertex>& out);
+std::array<int16_t, 2> encodeOctahedral(const glm::vec3& normal);
+
+// inverse of quantizeVertices, up to the quantization error
+void dequantizeVertices(const std::vector<CompactVertex>& vertices, const glm::vec3& boundsMin,
+                        const glm::vec3& boundsMax, std::vector<Vertex>& out);
+glm::vec3 decodeOctahedral(int16_t x, int16_t y);
+
 // A little helper function to create a staging buffer that acts like a specific type
 template <typename T>
 std::tuple<T&, tga::StagingBuffer, size_t> stagingBufferOfType(tga::Interface& tgai);
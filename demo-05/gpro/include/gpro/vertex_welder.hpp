@@ -0,0 +1,31 @@
+#pragma once
+
+#include "gpro/shared.hpp"
+
+namespace gpro {
+
+// Deduplicates vertices while they are streamed in. Unique vertices are appended to the output vector and
+// looked up through a flat open-addressing table (linear probing) of indices into that vector.
+class VertexWelder {
+public:
+    VertexWelder(std::vector<Vertex>& vertices, size_t expectedUniqueCount = 0);
+
+    // returns the index of the vertex relative to the first vertex appended by this welder
+    uint32_t weld(const Vertex& vertex);
+
+    size_t uniqueCount() const { return m_count; }
+    size_t tableBytes() const { return m_slots.capacity() * sizeof(uint32_t); }
+
+private:
+    static constexpr uint32_t EMPTY = std::numeric_limits<uint32_t>::max();
+
+    void _rehash(size_t capacity);
+
+    std::vector<Vertex>& m_vertices;
+    size_t m_base;
+    std::vector<uint32_t> m_slots;
+    size_t m_mask = 0;
+    size_t m_count = 0;
+};
+
+}  // namespace gpro
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "gpro/deferred_release.hpp"
+#include "gpro/texture_cache.hpp"
+
+namespace gpro {
+
+// Feedback-driven virtual texturing of the diffuse maps (GPRO_VIRTUAL_TEXTURES).
+// Textures are paged texture cache entries, mapped from disk. The forward pass samples them through a page table
+// from a fixed pool of physical pages and writes the pages it wanted into a feedback buffer, from one pixel of every
+// 4x4 block per frame. The frame downloads its feedback itself, the streamer reads it when the frame's slot comes
+// around again (FRAMES_IN_FLIGHT frames later), copies the missing pages from the mapping into the pool (coarse levels
+// first, least recently requested pages are evicted) and the shader falls back to the next resident coarser level
+// meanwhile. The tail level of each texture (the first one that fits a page) is
+// pinned, so there is always something to sample.
+// tga textures cannot be updated in parts, so the pool and the page table are storage buffers and the shader filters
+// the texels itself.
+class VirtualTextureStreamer {
+public:
+    static constexpr uint32_t PAGE_SIZE = 128;  // texels per page side
+    static constexpr uint32_t PAGE_BYTES = PAGE_SIZE * PAGE_SIZE * 4;
+    static constexpr uint32_t PHYSICAL_PAGE_COUNT = 512;  // 32 MB pool
+    static constexpr uint32_t MAX_LEVEL_COUNT = 16;
+    static constexpr uint32_t MAX_UPLOADS_PER_FRAME = 32;
+    static constexpr uint32_t FEEDBACK_RATE = 4;  // one feedback pixel per 4x4 block, all of them every 16 frames
+    static constexpr uint32_t INVALID_ID = ~0u;
+
+    struct Stats {
+        uint32_t residentPageCount = 0;  // pinned included
+        uint32_t pendingPageCount = 0;   // requested, not resident
+        uint32_t streamedPageCount = 0;  // in the last update
+        uint64_t virtualBytes = 0;       // all levels of all textures, if they were resident
+        uint64_t faultCount = 0;         // streamed pages, pinned ones excluded
+        double averageFaultLatencyMs = 0;  // first request seen -> upload recorded
+        double maxFaultLatencyMs = 0;
+
+        uint64_t residentBytes() const { return uint64_t(residentPageCount) * PAGE_BYTES; }
+    };
+
+    void init();
+
+    // takes a paged (PAGE_SIZE) rgba8 cache entry and returns its id, INVALID_ID for other entries. render thread
+    uint32_t add(TextureCache::MappedTexture texture);
+
+    // render thread, before the render pass: reads the feedback of the slot's last frame, records the page uploads and
+    // recreates the input set if textures were added. frameSlot < FRAMES_IN_FLIGHT, its last frame has completed
+    void update(tga::CommandRecorder& cmdRecorder, tga::RenderPass renderPass, uint32_t setIndex, uint32_t frameSlot);
+    // render thread, after the render passes of the frame
+    void downloadFeedback(tga::CommandRecorder& cmdRecorder, uint32_t frameSlot);
+
+    tga::InputSet inputSet() const { return m_inputSet; }
+    const Stats& stats() const { return m_stats; }
+
+private:
+    static constexpr uint32_t INVALID_PAGE = ~0u;
+
+    // per texture (std430)
+    struct VirtualTextureGPU {
+        uint32_t width;
+        uint32_t height;
+        uint32_t levelCount;  // up to the tail level
+        uint32_t padding;
+        uint32_t levelFirstPage[MAX_LEVEL_COUNT];  // in the page table
+    };
+
+    struct VirtualPage {
+        uint32_t textureID;
+        uint32_t level;
+        uint32_t levelPage;  // page index within the level
+    };
+
+    void _recreateBuffers(tga::RenderPass renderPass, uint32_t setIndex);
+    void _readFeedback(const uint32_t *feedback, std::vector<uint32_t>& requestedPages,
+                       std::vector<uint32_t>& evictionCandidates);
+    uint32_t _allocatePhysicalPage(tga::CommandRecorder& cmdRecorder, std::vector<uint32_t>& evictionCandidates);
+    void _upload(tga::CommandRecorder& cmdRecorder, uint32_t virtualPage, uint32_t physicalPage, uint32_t slot);
+
+    std::vector<TextureCache::MappedTexture> m_textures;
+    std::vector<VirtualTextureGPU> m_texturesGPU;
+    std::vector<VirtualPage> m_virtualPages;
+    std::vector<uint32_t> m_pageTable;          // per virtual page: physical page + 1, 0 if not resident
+    std::vector<uint32_t> m_physicalToVirtual;  // INVALID_PAGE if free
+    std::vector<uint8_t> m_isPinned;            // per physical page
+    std::vector<uint32_t> m_freePhysicalPages;
+    std::vector<uint32_t> m_pinRequests;        // tail pages of new textures
+    std::unordered_map<uint32_t, std::chrono::steady_clock::time_point> m_faultTimes;  // missing virtual pages
+    uint32_t m_frame = 1;                       // feedback stamp, 0 is never requested
+    bool m_isDirty = false;
+    uint32_t m_bufferPageCount = 0;             // virtual pages in the current buffers
+    uint32_t m_bufferGeneration = 0;            // recreations of the buffers
+    uint32_t m_frameSlot = 0;                   // of the update
+
+    Stats m_stats;
+
+    // gpu
+    tga::Buffer m_texturesBuffer;
+    tga::Buffer m_pageTableBuffer;
+    tga::Buffer m_physicalPagesBuffer;
+    tga::Buffer m_feedbackBuffer;
+    tga::Buffer m_streamingBuffer;  // current frame stamp
+    tga::InputSet m_inputSet;
+
+    // per frame slot
+    struct FeedbackReadback {
+        tga::StagingBuffer staging;
+        uint32_t pageCount = 0;         // capacity of the staging buffer
+        uint32_t bufferGeneration = 0;  // of the downloaded feedback
+        bool isPending = false;
+    };
+    std::array<FeedbackReadback, FRAMES_IN_FLIGHT> m_feedbackReadbacks;
+    std::array<tga::StagingBuffer, FRAMES_IN_FLIGHT> m_uploadStagings;  // MAX_UPLOADS_PER_FRAME pages
+
+    // replaced by an update, the frames in flight may still use them
+    DeferredRelease<tga::Buffer> m_releasedBuffers;
+    DeferredRelease<tga::InputSet> m_releasedInputSets;
+};
+
+}  // namespace gpro
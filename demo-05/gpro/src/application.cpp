@@ -1,5 +1,6 @@
 #include "gpro/application.hpp"
 
+#include "gpro/cpu_profiler.hpp"
 #include "gpro/renderer.hpp"
 #include "gpro/scene_serializer.hpp"
 #include "gpro/utils.hpp"
@@ -41,34 +42,50 @@ Application::Application() {
     m_scene->init();
     m_serializer = std::make_shared<SceneSerializer>(m_scene);
     m_serializer->deserialize();
+
+#ifdef GPRO_PROFILE_CPU
+    std::cout << std::format("CPU profiler: {0:.1f} ns per zone\n", CpuProfiler::measureZoneOverheadNs());
+#endif
 }
 
 void Application::run() {
-    double sceneSerializeTimer = 0;
-    double messageTimer = 0;
+    GPRO_THREAD_NAME("main");
     while (!tgai.windowShouldClose(m_window)) {
         // init time
         auto ts = std::chrono::steady_clock::now();
-    
-        if (sceneSerializeTimer > 0.2) {
-            sceneSerializeTimer = 0;
-            m_serializer->deserialize();
+        {
+            GPRO_ZONE("frame");
+            {
+                GPRO_ZONE("serializer poll");
+                m_serializer->deserialize();  // only reacts to changed files
+            }
+            {
+                GPRO_ZONE("process loaded models");
+                m_serializer->processLoadedModels();
+            }
+            {
+                GPRO_ZONE("Scene::onUpdate");
+                m_scene->onUpdate();
+            }
+            Renderer::get().render(m_window);
         }
 
-        m_scene->onUpdate();
-        Renderer::get().render(m_window);
-
         // update time
         m_time += m_deltaTime;
         m_deltaTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - ts).count();
-        sceneSerializeTimer += m_deltaTime;
-        messageTimer += m_deltaTime;
 
-        //if (messageTimer > 0.2) {
-        //    messageTimer = 0;
-        //    std::cout << std::format("fps: {:.0f}\n\n", 1 / m_deltaTime);
-        //}
+        // percentiles of a window instead of a print per frame
+        if (m_frameTimes.add(m_deltaTime * 1000.0)) {
+            std::cout << std::format("Frame time over {0} frames: p50 {1:.2f} ms, p95 {2:.2f} ms, p99 {3:.2f} ms, "
+                                     "max {4:.2f} ms\n",
+                                     FrameTimeWindow::WINDOW_SIZE, m_frameTimes.percentile(0.5),
+                                     m_frameTimes.percentile(0.95), m_frameTimes.percentile(0.99), m_frameTimes.max());
+        }
     }
+
+#ifdef GPRO_PROFILE_CPU
+    CpuProfiler::writeChromeTrace(cachePath("cpu_trace.json"));
+#endif
 }
 
 }  // namespace gpro
\ No newline at end of file
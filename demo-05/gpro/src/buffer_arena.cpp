@@ -0,0 +1,128 @@
+#include "gpro/buffer_arena.hpp"
+
+#include "gpro/utils.hpp"
+
+namespace gpro {
+
+tga::Buffer BufferArena::createBuffer(tga::BufferUsage usage, size_t capacity, const void *data, size_t size) {
+    m_stats.createdBufferCount++;
+    m_stats.uploadedBytes += size;
+    return util::createBuffer(usage, capacity, static_cast<const uint8_t *>(data), size);
+}
+
+void BufferArena::release(tga::Buffer buffer) { m_releasedBuffers.release(buffer); }
+
+void BufferArena::upload(tga::Buffer buffer, size_t offset, const void *data, size_t size) {
+    m_uploads.push_back({buffer, offset, static_cast<const uint8_t *>(data), m_uploadSize, size});
+    m_uploadSize += size;
+    m_stats.uploadCount++;
+    m_stats.uploadedBytes += size;
+}
+
+size_t BufferArena::recordUploads(tga::CommandRecorder& cmdRecorder, uint32_t frameSlot,
+                                  ThreadPool *threadPool) {
+    if (m_uploads.empty()) return 0;
+
+    // the other slots' staging buffers may still be read by the frames in flight, this one's frame has completed
+    Staging& staging = m_stagings[frameSlot];
+    const size_t size = m_uploadSize;
+    if (size > staging.size) {
+        if (staging.buffer) tgai.free(staging.buffer);
+        staging.size = std::max(size, 2 * staging.size);
+        staging.buffer = tgai.createStagingBuffer({staging.size});
+    }
+
+    // one copy from each source into the staging buffer, large uploads are split so they spread over the threads
+    m_chunks.clear();
+    for (const auto& upload : m_uploads) {
+        for (size_t offset = 0; offset < upload.size; offset += COPY_CHUNK_BYTES)
+            m_chunks.push_back({upload.data + offset, upload.stagingOffset + offset,
+                                std::min(COPY_CHUNK_BYTES, upload.size - offset)});
+    }
+
+    // tga is not thread safe, the mapping is taken here and the workers only copy
+    uint8_t *mapping = static_cast<uint8_t *>(tgai.getMapping(staging.buffer));
+    const uint32_t chunkCount = static_cast<uint32_t>(m_chunks.size());
+    auto copyChunk = [&](uint32_t chunk) {
+        const CopyChunk& copy = m_chunks[chunk];
+        std::memcpy(mapping + copy.stagingOffset, copy.data, copy.size);
+    };
+    if (threadPool && chunkCount > 1)
+        threadPool->parallelFor(chunkCount, copyChunk);
+    else
+        for (uint32_t chunk = 0; chunk < chunkCount; chunk++) copyChunk(chunk);
+
+    for (const auto& upload : m_uploads)
+        cmdRecorder.bufferUpload(staging.buffer, upload.buffer, upload.size, upload.stagingOffset, upload.dstOffset);
+
+    m_uploads.clear();
+    m_uploadSize = 0;
+    return size;
+}
+
+void BufferArena::nextFrame() {
+    // uploads queued for a released buffer are harmless, it is freed after they were executed
+    m_releasedBuffers.nextFrame();
+    m_stats = {};
+}
+
+ArenaPool::Range ArenaPool::allocate(uint32_t count) {
+    if (count == 0) return {m_size, 0};
+    m_usedCount += count;
+    m_allocationCount++;
+
+    // first fit
+    for (auto it = m_freeRanges.begin(); it != m_freeRanges.end(); ++it) {
+        if (it->count < count) continue;
+        Range range{it->offset, count};
+        it->offset += count;
+        it->count -= count;
+        if (it->count == 0) m_freeRanges.erase(it);
+        return range;
+    }
+
+    Range range{m_size, count};
+    m_size += count;
+    if (m_size > m_capacity) m_capacity = std::max(m_size, 2 * m_capacity);
+    return range;
+}
+
+void ArenaPool::free(Range range) {
+    if (range.count == 0) return;
+    m_usedCount -= range.count;
+    m_freeCount++;
+
+    auto next = std::lower_bound(m_freeRanges.begin(), m_freeRanges.end(), range,
+                                 [](const Range& a, const Range& b) { return a.offset < b.offset; });
+    if (next != m_freeRanges.begin() && std::prev(next)->offset + std::prev(next)->count == range.offset) {
+        next = std::prev(next);
+        next->count += range.count;
+    } else {
+        next = m_freeRanges.insert(next, range);
+    }
+    auto after = std::next(next);
+    if (after != m_freeRanges.end() && next->offset + next->count == after->offset) {
+        next->count += after->count;
+        m_freeRanges.erase(after);
+    }
+
+    // a free range at the end gives the elements back
+    if (m_freeRanges.back().offset + m_freeRanges.back().count == m_size) {
+        m_size = m_freeRanges.back().offset;
+        m_freeRanges.pop_back();
+    }
+}
+
+ArenaPool::Stats ArenaPool::stats() const {
+    Stats stats{m_capacity, m_size, m_usedCount, static_cast<uint32_t>(m_freeRanges.size()), 0, m_allocationCount,
+                m_freeCount};
+    for (const auto& range : m_freeRanges) stats.largestFreeRange = std::max(stats.largestFreeRange, range.count);
+    return stats;
+}
+
+void ArenaPool::resetFrameStats() {
+    m_allocationCount = 0;
+    m_freeCount = 0;
+}
+
+}  // namespace gpro
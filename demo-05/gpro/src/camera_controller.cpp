@@ -12,7 +12,7 @@ CameraController::CameraController(tga::Window _window, float _fov, float _aspec
       camData(static_cast<CamData *>(tgai.getMapping(camStaging))),
       camMetaData(static_cast<CamMetaData *>(tgai.getMapping(camMetaStaging))), fov(_fov), aspectRatio(_aspectRatio),
       frustumData(static_cast<Frustum *>(tgai.getMapping(frustumStaging))), nearPlane(_nearPlane), farPlane(_farPlane),
-      position(_position), front(_front), up(_up), right(glm::cross(up, front)) {
+      position(_position), front(_front), up(_up), right(glm::cross(up, front)), lookDir(_front) {
     updateData();
 }
 
@@ -59,18 +59,20 @@ void CameraController::updateData() {
     camMetaData->lookDirection = lookDir;
     camMetaData->fovNearFar = glm::vec3(fov, nearPlane, farPlane);
 
-    // create frustum
-    const float halfVSide = farPlane * tanf(fov * .5f);
+    // create frustum, inward facing planes through the camera up and right (not the world up, which is only the same
+    // without pitch)
+    const float halfVSide = farPlane * tanf(glm::radians(fov) * .5f);
     const float halfHSide = halfVSide * aspectRatio;
     const glm::vec3 frontMultFar = farPlane * lookDir;
-    glm::vec3 right = glm::normalize(glm::cross(lookDir, up)); 
+    const glm::vec3 camRight = glm::normalize(glm::cross(lookDir, up));
+    const glm::vec3 camUp = glm::cross(camRight, lookDir);
 
     frustumData->nearFace = {position + nearPlane * lookDir, lookDir};
     frustumData->farFace = {position + frontMultFar, -lookDir};
-    frustumData->rightFace = {position, glm::normalize(glm::cross(frontMultFar - right * halfHSide, up))};
-    frustumData->leftFace = {position, glm::normalize(glm::cross(up, frontMultFar + right * halfHSide))};
-    frustumData->topFace = {position, glm::normalize(glm::cross(right, frontMultFar - up * halfVSide))};
-    frustumData->bottomFace = {position, glm::normalize(glm::cross(frontMultFar + up * halfVSide, right))};
+    frustumData->rightFace = {position, glm::cross(frontMultFar - camRight * halfHSide, camUp)};
+    frustumData->leftFace = {position, glm::cross(camUp, frontMultFar + camRight * halfHSide)};
+    frustumData->topFace = {position, glm::cross(camRight, frontMultFar - camUp * halfVSide)};
+    frustumData->bottomFace = {position, glm::cross(frontMultFar + camUp * halfVSide, camRight)};
 }
 
 }  // namespace gpro
\ No newline at end of file
@@ -3,7 +3,7 @@
 namespace gpro {
 
 AABB AABB::calculateBoundingBox(const std::vector<glm::vec3>& points) {
-    glm::vec3 mx(std::numeric_limits<float>::min());
+    glm::vec3 mx(std::numeric_limits<float>::lowest());
     glm::vec3 mn(std::numeric_limits<float>::max());
 
     for (const auto& point : points) {
@@ -11,11 +11,11 @@ AABB AABB::calculateBoundingBox(const std::vector<glm::vec3>& points) {
         mn = glm::min(point, mn);
     }
 
-    return {mx, mn};
+    return {mn, mx};
 }
 
 AABB AABB::calculateBoundingBox(const std::vector<Vertex>& vertices) {
-    glm::vec3 mx(std::numeric_limits<float>::min());
+    glm::vec3 mx(std::numeric_limits<float>::lowest());
     glm::vec3 mn(std::numeric_limits<float>::max());
 
     for (const auto& vertex : vertices) {
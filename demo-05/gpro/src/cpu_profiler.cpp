@@ -0,0 +1,173 @@
+#include "gpro/cpu_profiler.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <mutex>
+
+namespace gpro {
+
+namespace {
+
+// written by the owning thread only. the fields are atomics, so writeChromeTrace may read them meanwhile
+struct Zone {
+    std::atomic<const char *> name{nullptr};
+    std::atomic<uint64_t> beginNs{0};
+    std::atomic<uint64_t> endNs{0};
+};
+
+struct ThreadRing {
+    uint32_t threadID;
+    std::atomic<const char *> threadName{nullptr};
+    std::atomic<uint64_t> writeIndex{0};  // zones recorded, the last RING_CAPACITY are kept
+    std::array<Zone, CpuProfiler::RING_CAPACITY> zones;
+};
+
+// the rings outlive their threads, they are read at exit. never destroyed, workers may still record then
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+};
+
+Registry& registry() {
+    static Registry& registry = *new Registry;
+    return registry;
+}
+
+ThreadRing& threadRing() {
+    thread_local ThreadRing *ring = nullptr;
+    if (!ring) {
+        Registry& r = registry();
+        std::lock_guard lock(r.mutex);
+        r.rings.push_back(std::make_unique<ThreadRing>());
+        ring = r.rings.back().get();
+        ring->threadID = static_cast<uint32_t>(r.rings.size());
+    }
+    return *ring;
+}
+
+void writeJsonString(std::ofstream& out, const char *string) {
+    out << '"';
+    for (const char *c = string ? string : ""; *c; c++) {
+        if (*c == '"' || *c == '\\') out << '\\';
+        out << *c;
+    }
+    out << '"';
+}
+
+}  // namespace
+
+uint64_t CpuProfiler::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void CpuProfiler::record(const char *name, uint64_t beginNs, uint64_t endNs) {
+    ThreadRing& ring = threadRing();
+    const uint64_t index = ring.writeIndex.load(std::memory_order_relaxed);
+    Zone& zone = ring.zones[index % RING_CAPACITY];
+    zone.name.store(name, std::memory_order_relaxed);
+    zone.beginNs.store(beginNs, std::memory_order_relaxed);
+    zone.endNs.store(endNs, std::memory_order_relaxed);
+    ring.writeIndex.store(index + 1, std::memory_order_release);
+}
+
+void CpuProfiler::setThreadName(const char *name) { threadRing().threadName.store(name, std::memory_order_relaxed); }
+
+bool CpuProfiler::writeChromeTrace(const std::string& path) {
+    struct Event {
+        const char *name;
+        uint64_t beginNs;
+        uint64_t endNs;
+        uint32_t threadID;
+    };
+    std::vector<Event> events;
+    std::vector<std::pair<uint32_t, const char *>> threadNames;
+
+    Registry& r = registry();
+    {
+        std::lock_guard lock(r.mutex);
+        for (const auto& ring : r.rings) {
+            threadNames.emplace_back(ring->threadID, ring->threadName.load(std::memory_order_relaxed));
+
+            // copy, then drop what the thread overwrote meanwhile (seqlock style)
+            const uint64_t end = ring->writeIndex.load(std::memory_order_acquire);
+            const uint64_t begin = end > RING_CAPACITY ? end - RING_CAPACITY : 0;
+            const size_t first = events.size();
+            for (uint64_t i = begin; i < end; i++) {
+                const Zone& zone = ring->zones[i % RING_CAPACITY];
+                events.push_back({zone.name.load(std::memory_order_relaxed),
+                                  zone.beginNs.load(std::memory_order_relaxed),
+                                  zone.endNs.load(std::memory_order_relaxed), ring->threadID});
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const uint64_t endAfter = ring->writeIndex.load(std::memory_order_relaxed);
+            const uint64_t validBegin = endAfter >= RING_CAPACITY ? endAfter - RING_CAPACITY + 1 : 0;
+            if (validBegin > begin)
+                events.erase(events.begin() + first,
+                             events.begin() + first + std::min<uint64_t>(validBegin - begin, end - begin));
+        }
+    }
+
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << std::format("Cannot write the cpu trace to '{}'\n", path);
+        return false;
+    }
+
+    // microseconds since the first zone
+    uint64_t originNs = std::numeric_limits<uint64_t>::max();
+    for (const Event& event : events) originNs = std::min(originNs, event.beginNs);
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool isFirst = true;
+    for (const auto& [threadID, threadName] : threadNames) {
+        if (!threadName) continue;
+        out << (isFirst ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << threadID
+            << ",\"args\":{\"name\":";
+        writeJsonString(out, threadName);
+        out << "}}";
+        isFirst = false;
+    }
+    for (const Event& event : events) {
+        out << (isFirst ? "" : ",\n") << "{\"ph\":\"X\",\"name\":";
+        writeJsonString(out, event.name);
+        out << std::format(",\"pid\":1,\"tid\":{0},\"ts\":{1:.3f},\"dur\":{2:.3f}}}", event.threadID,
+                           (event.beginNs - originNs) / 1000.0, (event.endNs - event.beginNs) / 1000.0);
+        isFirst = false;
+    }
+    out << "\n]}\n";
+
+    std::cout << std::format("Wrote {0} cpu zones of {1} threads to {2}\n", events.size(), threadNames.size(), path);
+    return true;
+}
+
+double CpuProfiler::measureZoneOverheadNs(uint32_t zoneCount) {
+    double overheadNs = 0;
+    std::thread([&] {
+        setThreadName("zone overhead");
+        const auto ts = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < zoneCount; i++) CpuZone zone("empty zone");
+        overheadNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - ts).count() /
+                     std::max(1u, zoneCount);
+    }).join();
+    return overheadNs;
+}
+
+bool FrameTimeWindow::add(double ms) {
+    m_frames.push_back(ms);
+    if (m_frames.size() < WINDOW_SIZE) return false;
+
+    m_sorted.swap(m_frames);
+    std::sort(m_sorted.begin(), m_sorted.end());
+    m_frames.clear();
+    return true;
+}
+
+double FrameTimeWindow::percentile(double p) const {
+    if (m_sorted.empty()) return 0;
+    const size_t rank = static_cast<size_t>(std::ceil(p * m_sorted.size()));
+    return m_sorted[std::clamp<size_t>(rank, 1, m_sorted.size()) - 1];
+}
+
+}  // namespace gpro
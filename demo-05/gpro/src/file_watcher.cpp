@@ -0,0 +1,179 @@
+#include "gpro/file_watcher.hpp"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace gpro {
+
+FileWatcher::FileWatcher(std::vector<std::string> directories, std::vector<std::string> extensions)
+    : m_directories(std::move(directories)), m_extensions(std::move(extensions)) {
+    // watch before the thread starts, changes made from now on are reported
+#ifdef __linux__
+    if (!_initInotify())
+#endif
+        _scan(m_snapshot);
+
+    m_thread = std::thread(&FileWatcher::_run, this);
+    std::cout << std::format("file watcher: {0} ({1} directories)\n", backendName(), m_directories.size());
+}
+
+FileWatcher::~FileWatcher() {
+    m_isRunning.store(false, std::memory_order_relaxed);
+    if (m_thread.joinable()) m_thread.join();
+#ifdef __linux__
+    if (m_inotifyFD >= 0) close(m_inotifyFD);
+#endif
+}
+
+const char *FileWatcher::backendName() const {
+#ifdef __linux__
+    if (m_inotifyFD >= 0) return "inotify";
+#endif
+    return "polling";
+}
+
+void FileWatcher::_run() {
+    while (m_isRunning.load(std::memory_order_relaxed)) {
+#ifdef __linux__
+        if (m_inotifyFD >= 0) {
+            // wake up often enough to flush pending events and to notice the destructor
+            pollfd fd{m_inotifyFD, POLLIN, 0};
+            const int timeoutMs = m_pendingEvents.empty() ? 100 : DEBOUNCE_MS / 4;
+            if (poll(&fd, 1, timeoutMs) > 0) _readInotify();
+            _flush();
+            continue;
+        }
+#endif
+        // sleep in short steps, the destructor waits for this loop
+        auto wakeUpTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(POLL_INTERVAL_MS);
+        while (m_isRunning.load(std::memory_order_relaxed) && std::chrono::steady_clock::now() < wakeUpTime)
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        _poll();
+        _flush();
+    }
+}
+
+bool FileWatcher::_isWatched(const std::filesystem::path& path) const {
+    const std::string extension = path.extension().string();
+    return std::find(m_extensions.begin(), m_extensions.end(), extension) != m_extensions.end();
+}
+
+void FileWatcher::_record(const std::string& path, FileEvent::Type type) {
+    auto now = std::chrono::steady_clock::now();
+    auto it = m_pendingEvents.find(path);
+    if (it == m_pendingEvents.end()) {
+        m_pendingEvents.emplace(path, PendingEvent{type, now});
+        return;
+    }
+
+    // merge with the events of the same file that are still pending
+    FileEvent::Type& pendingType = it->second.type;
+    if (pendingType == FileEvent::Type::added && type == FileEvent::Type::removed) {
+        m_pendingEvents.erase(it);  // came and went
+        return;
+    }
+    if (pendingType == FileEvent::Type::removed && type == FileEvent::Type::added)
+        pendingType = FileEvent::Type::modified;  // replaced, e.g. saved through a temporary file
+    else if (pendingType != FileEvent::Type::added || type == FileEvent::Type::removed)
+        pendingType = type == FileEvent::Type::added ? FileEvent::Type::modified : type;
+    it->second.time = now;
+}
+
+void FileWatcher::_flush() {
+    if (m_isRescanPending) m_isRescanPending = !m_events.tryPush({FileEvent::Type::rescan, {}});
+
+    // files that have been quiet for the debounce time
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = m_pendingEvents.begin(); it != m_pendingEvents.end();) {
+        if (now - it->second.time < std::chrono::milliseconds(DEBOUNCE_MS)) {
+            ++it;
+            continue;
+        }
+        if (!m_events.tryPush({it->second.type, it->first})) m_isRescanPending = true;
+        it = m_pendingEvents.erase(it);
+    }
+}
+
+void FileWatcher::_scan(std::unordered_map<std::string, FileStamp>& snapshot) const {
+    std::error_code ec;
+    for (const auto& directory : m_directories) {
+        for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+            if (!entry.is_regular_file(ec) || !_isWatched(entry.path())) continue;
+            snapshot[entry.path().string()] = {entry.last_write_time(ec), entry.file_size(ec)};
+        }
+    }
+}
+
+void FileWatcher::_poll() {
+    std::unordered_map<std::string, FileStamp> snapshot;
+    _scan(snapshot);
+
+    for (const auto& [path, stamp] : snapshot) {
+        auto it = m_snapshot.find(path);
+        if (it == m_snapshot.end())
+            _record(path, FileEvent::Type::added);
+        else if (it->second.writeTime != stamp.writeTime || it->second.size != stamp.size)
+            _record(path, FileEvent::Type::modified);
+    }
+    for (const auto& [path, stamp] : m_snapshot) {
+        if (!snapshot.contains(path)) _record(path, FileEvent::Type::removed);
+    }
+    m_snapshot = std::move(snapshot);
+}
+
+#ifdef __linux__
+
+bool FileWatcher::_initInotify() {
+    m_inotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotifyFD < 0) return false;
+
+    constexpr uint32_t mask = IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+    for (const auto& directory : m_directories) {
+        const int wd = inotify_add_watch(m_inotifyFD, directory.c_str(), mask);
+        if (wd < 0) {
+            std::cerr << std::format("Failed to watch '{}' with inotify, polling instead\n", directory);
+            close(m_inotifyFD);
+            m_inotifyFD = -1;
+            m_watchDirectories.clear();
+            return false;
+        }
+        m_watchDirectories.emplace(wd, directory);
+    }
+    return true;
+}
+
+void FileWatcher::_readInotify() {
+    alignas(inotify_event) char buffer[16 * 1024];
+    ssize_t length;
+    while ((length = read(m_inotifyFD, buffer, sizeof(buffer))) > 0) {
+        const inotify_event *event;
+        for (char *ptr = buffer; ptr < buffer + length; ptr += sizeof(inotify_event) + event->len) {
+            event = reinterpret_cast<const inotify_event *>(ptr);
+            if (event->mask & IN_Q_OVERFLOW) {
+                m_isRescanPending = true;
+                continue;
+            }
+
+            auto it = m_watchDirectories.find(event->wd);
+            if (event->len == 0 || it == m_watchDirectories.end()) continue;  // about the directory itself
+            const std::filesystem::path path = std::filesystem::path(it->second) / event->name;
+            if (!_isWatched(path)) continue;
+
+            if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                _record(path.string(), FileEvent::Type::added);
+            else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                _record(path.string(), FileEvent::Type::removed);
+            else
+                _record(path.string(), FileEvent::Type::modified);
+        }
+    }
+}
+
+#endif
+
+}  // namespace gpro
@@ -0,0 +1,201 @@
+#include "gpro/frustum_culler.hpp"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define GPRO_CULLER_SSE
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define GPRO_CULLER_NEON
+#include <arm_neon.h>
+#endif
+
+namespace gpro {
+
+static_assert(sizeof(AABB) == 32 && offsetof(AABB, mx) == 16, "the simd aabb test loads min and max as 4 floats");
+
+// the signed distances are computed in the same order everywhere, so the scalar and simd tests agree bit for bit
+// (unless the compiler contracts the scalar multiply-adds)
+
+FrustumCuller::FrustumCuller(const Frustum& frustum) {
+    const Plane planes[PLANE_COUNT] = {frustum.topFace,  frustum.bottomFace, frustum.rightFace,
+                                       frustum.leftFace, frustum.farFace,    frustum.nearFace};
+    for (uint32_t i = 0; i < PLANE_COUNT; i++) {
+        m_normalX[i] = planes[i].normal.x;
+        m_normalY[i] = planes[i].normal.y;
+        m_normalZ[i] = planes[i].normal.z;
+        m_distance[i] = planes[i].distance;
+    }
+}
+
+bool FrustumCuller::isSphereVisible(const glm::vec4& sphere) const {
+    for (uint32_t i = 0; i < PLANE_COUNT; i++) {
+        const float distance =
+            m_normalX[i] * sphere.x + m_normalY[i] * sphere.y + m_normalZ[i] * sphere.z - m_distance[i];
+        if (distance < -sphere.w) return false;
+    }
+    return true;
+}
+
+bool FrustumCuller::isAABBVisible(const AABB& aabb) const {
+    const glm::vec3 center = (aabb.mn + aabb.mx) * 0.5f;
+    const glm::vec3 extent = (aabb.mx - aabb.mn) * 0.5f;
+    for (uint32_t i = 0; i < PLANE_COUNT; i++) {
+        const float distance =
+            m_normalX[i] * center.x + m_normalY[i] * center.y + m_normalZ[i] * center.z - m_distance[i];
+        const float radius = std::fabs(m_normalX[i]) * extent.x + std::fabs(m_normalY[i]) * extent.y +
+                             std::fabs(m_normalZ[i]) * extent.z;
+        if (distance < -radius) return false;
+    }
+    return true;
+}
+
+size_t FrustumCuller::cullSpheres(const glm::vec4 *spheres, size_t count, uint8_t *visibility) const {
+    size_t visibleCount = 0;
+    size_t i = 0;
+
+#if defined(GPRO_CULLER_SSE)
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(&spheres[i].x);
+        __m128 y = _mm_loadu_ps(&spheres[i + 1].x);
+        __m128 z = _mm_loadu_ps(&spheres[i + 2].x);
+        __m128 r = _mm_loadu_ps(&spheres[i + 3].x);
+        _MM_TRANSPOSE4_PS(x, y, z, r);
+        const __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), r);
+
+        __m128 outside = _mm_setzero_ps();
+        for (uint32_t p = 0; p < PLANE_COUNT; p++) {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m_normalX[p]), x),
+                                         _mm_mul_ps(_mm_set1_ps(m_normalY[p]), y));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(m_normalZ[p]), z));
+            distance = _mm_sub_ps(distance, _mm_set1_ps(m_distance[p]));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negRadius));
+        }
+
+        const int outsideMask = _mm_movemask_ps(outside);
+        for (uint32_t k = 0; k < 4; k++) {
+            visibility[i + k] = ((outsideMask >> k) & 1) ^ 1;
+            visibleCount += visibility[i + k];
+        }
+    }
+#elif defined(GPRO_CULLER_NEON)
+    for (; i + 4 <= count; i += 4) {
+        const float32x4x4_t s = vld4q_f32(&spheres[i].x);  // deinterleaved x, y, z, radius
+        const float32x4_t negRadius = vnegq_f32(s.val[3]);
+
+        uint32x4_t outside = vdupq_n_u32(0);
+        for (uint32_t p = 0; p < PLANE_COUNT; p++) {
+            float32x4_t distance = vaddq_f32(vmulq_n_f32(s.val[0], m_normalX[p]), vmulq_n_f32(s.val[1], m_normalY[p]));
+            distance = vaddq_f32(distance, vmulq_n_f32(s.val[2], m_normalZ[p]));
+            distance = vsubq_f32(distance, vdupq_n_f32(m_distance[p]));
+            outside = vorrq_u32(outside, vcltq_f32(distance, negRadius));
+        }
+
+        uint32_t lanes[4];
+        vst1q_u32(lanes, outside);
+        for (uint32_t k = 0; k < 4; k++) {
+            visibility[i + k] = lanes[k] ? 0 : 1;
+            visibleCount += visibility[i + k];
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        visibility[i] = isSphereVisible(spheres[i]) ? 1 : 0;
+        visibleCount += visibility[i];
+    }
+    return visibleCount;
+}
+
+size_t FrustumCuller::cullAABBs(const AABB *aabbs, size_t count, uint8_t *visibility) const {
+    size_t visibleCount = 0;
+    size_t i = 0;
+
+#if defined(GPRO_CULLER_SSE) || defined(GPRO_CULLER_NEON)
+    // centers and extents of 4 boxes, deinterleaved into x, y, z (w is padding)
+    alignas(16) float centers[16], extents[16];
+#endif
+
+#if defined(GPRO_CULLER_SSE)
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (; i + 4 <= count; i += 4) {
+        for (uint32_t k = 0; k < 4; k++) {
+            const __m128 mn = _mm_loadu_ps(&aabbs[i + k].mn.x);
+            const __m128 mx = _mm_loadu_ps(&aabbs[i + k].mx.x);
+            _mm_store_ps(centers + 4 * k, _mm_mul_ps(_mm_add_ps(mn, mx), half));
+            _mm_store_ps(extents + 4 * k, _mm_mul_ps(_mm_sub_ps(mx, mn), half));
+        }
+        __m128 cx = _mm_load_ps(centers), cy = _mm_load_ps(centers + 4), cz = _mm_load_ps(centers + 8),
+               cw = _mm_load_ps(centers + 12);
+        __m128 ex = _mm_load_ps(extents), ey = _mm_load_ps(extents + 4), ez = _mm_load_ps(extents + 8),
+               ew = _mm_load_ps(extents + 12);
+        _MM_TRANSPOSE4_PS(cx, cy, cz, cw);
+        _MM_TRANSPOSE4_PS(ex, ey, ez, ew);
+
+        __m128 outside = _mm_setzero_ps();
+        for (uint32_t p = 0; p < PLANE_COUNT; p++) {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m_normalX[p]), cx),
+                                         _mm_mul_ps(_mm_set1_ps(m_normalY[p]), cy));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(m_normalZ[p]), cz));
+            distance = _mm_sub_ps(distance, _mm_set1_ps(m_distance[p]));
+            __m128 radius = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::fabs(m_normalX[p])), ex),
+                                       _mm_mul_ps(_mm_set1_ps(std::fabs(m_normalY[p])), ey));
+            radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(std::fabs(m_normalZ[p])), ez));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_sub_ps(_mm_setzero_ps(), radius)));
+        }
+
+        const int outsideMask = _mm_movemask_ps(outside);
+        for (uint32_t k = 0; k < 4; k++) {
+            visibility[i + k] = ((outsideMask >> k) & 1) ^ 1;
+            visibleCount += visibility[i + k];
+        }
+    }
+#elif defined(GPRO_CULLER_NEON)
+    for (; i + 4 <= count; i += 4) {
+        for (uint32_t k = 0; k < 4; k++) {
+            const float32x4_t mn = vld1q_f32(&aabbs[i + k].mn.x);
+            const float32x4_t mx = vld1q_f32(&aabbs[i + k].mx.x);
+            vst1q_f32(centers + 4 * k, vmulq_n_f32(vaddq_f32(mn, mx), 0.5f));
+            vst1q_f32(extents + 4 * k, vmulq_n_f32(vsubq_f32(mx, mn), 0.5f));
+        }
+        const float32x4x4_t c = vld4q_f32(centers);
+        const float32x4x4_t e = vld4q_f32(extents);
+
+        uint32x4_t outside = vdupq_n_u32(0);
+        for (uint32_t p = 0; p < PLANE_COUNT; p++) {
+            float32x4_t distance = vaddq_f32(vmulq_n_f32(c.val[0], m_normalX[p]), vmulq_n_f32(c.val[1], m_normalY[p]));
+            distance = vaddq_f32(distance, vmulq_n_f32(c.val[2], m_normalZ[p]));
+            distance = vsubq_f32(distance, vdupq_n_f32(m_distance[p]));
+            float32x4_t radius = vaddq_f32(vmulq_n_f32(e.val[0], std::fabs(m_normalX[p])),
+                                           vmulq_n_f32(e.val[1], std::fabs(m_normalY[p])));
+            radius = vaddq_f32(radius, vmulq_n_f32(e.val[2], std::fabs(m_normalZ[p])));
+            outside = vorrq_u32(outside, vcltq_f32(distance, vnegq_f32(radius)));
+        }
+
+        uint32_t lanes[4];
+        vst1q_u32(lanes, outside);
+        for (uint32_t k = 0; k < 4; k++) {
+            visibility[i + k] = lanes[k] ? 0 : 1;
+            visibleCount += visibility[i + k];
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        visibility[i] = isAABBVisible(aabbs[i]) ? 1 : 0;
+        visibleCount += visibility[i];
+    }
+    return visibleCount;
+}
+
+const char *FrustumCuller::simdName() {
+#if defined(GPRO_CULLER_SSE)
+    return "sse";
+#elif defined(GPRO_CULLER_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+}  // namespace gpro
@@ -0,0 +1,175 @@
+#include "gpro/mesh_cache.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "gpro/file.hpp"
+#include "gpro/mesh_codec.hpp"
+#include "gpro/utils.hpp"
+
+namespace gpro {
+
+static constexpr uint64_t s_dataAlignment = 16;
+
+std::string MeshCache::entryPath(const std::string& sourcePath) {
+    const std::string absolutePath = std::filesystem::absolute(sourcePath).generic_string();
+    const uint64_t key = util::hashBytes(reinterpret_cast<const uint8_t *>(absolutePath.data()), absolutePath.size());
+    return gpro::cachePath(std::format("meshes/{:016x}.mesh", key));
+}
+
+bool MeshCache::load(const std::string& sourcePath, uint32_t flags, MappedMesh& out) {
+    MappedFile file(entryPath(sourcePath));
+    if (!file.isOpen() || file.size() < sizeof(Header)) return false;
+
+    Header header;
+    std::memcpy(&header, file.data(), sizeof(Header));
+
+    // format checks
+    const bool isCompressed = flags & COMPRESSED;
+    const uint32_t vertexStride = isCompressed ? sizeof(CompactVertex) : sizeof(Vertex);
+    if (header.magic != MAGIC || header.version != VERSION || header.vertexStride != vertexStride ||
+        header.indexStride != sizeof(IndexFormat) || header.flags != flags)
+        return false;
+
+    if (!util::isInFile(sizeof(Header), header.sourcePathLength, file.size()) ||
+        !util::isInFile(header.vertexOffset, header.vertexSize, file.size()) ||
+        !util::isInFile(header.indexOffset, header.indexSize, file.size()) ||
+        !util::isArrayInFile(header.lodOffset, header.lodCount, sizeof(MeshLOD), file.size()) ||
+        !util::isArrayInFile(header.meshletOffset, header.meshletCount, sizeof(Meshlet), file.size()) ||
+        header.vertexOffset % alignof(Vertex) != 0 || header.indexOffset % alignof(IndexFormat) != 0)
+        return false;
+    if (!isCompressed && (header.vertexSize % sizeof(Vertex) != 0 ||
+                          header.vertexSize / sizeof(Vertex) != header.vertexCount ||
+                          header.indexSize % sizeof(IndexFormat) != 0 ||
+                          header.indexSize / sizeof(IndexFormat) != header.indexCount))
+        return false;
+
+    // key checks: path, then write time + size, falling back to the content hash for touched files
+    const std::string absolutePath = std::filesystem::absolute(sourcePath).generic_string();
+    const std::string_view storedPath(reinterpret_cast<const char *>(file.data() + sizeof(Header)),
+                                      header.sourcePathLength);
+    if (storedPath != absolutePath) return false;
+    if (!util::isFileUnchanged(sourcePath, header.sourceWriteTime, header.sourceSize, header.sourceHash)) return false;
+
+    out.flags = header.flags;
+    out.vertexData = file.data() + header.vertexOffset;
+    out.indexData = file.data() + header.indexOffset;
+    out.vertexSize = header.vertexSize;
+    out.indexSize = header.indexSize;
+    out.vertexCount = header.vertexCount;
+    out.indexCount = header.indexCount;
+    out.lods.resize(header.lodCount);
+    std::memcpy(out.lods.data(), file.data() + header.lodOffset, header.lodCount * sizeof(MeshLOD));
+    out.meshlets.resize(header.meshletCount);
+    std::memcpy(out.meshlets.data(), file.data() + header.meshletOffset, header.meshletCount * sizeof(Meshlet));
+    for (const MeshLOD& lod : out.lods) {
+        if (lod.meshletOffset > header.meshletCount || lod.meshletCount > header.meshletCount - lod.meshletOffset)
+            return false;
+    }
+    out.boundingBox = AABB(glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]),
+                           glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]));
+    out.file = std::make_shared<const MappedFile>(std::move(file));
+
+    return true;
+}
+
+bool MeshCache::store(const std::string& sourcePath, uint32_t flags, const std::vector<Vertex>& vertices,
+                      const std::vector<IndexFormat>& indices, const std::vector<MeshLOD>& lods,
+                      const std::vector<Meshlet>& meshlets, const AABB& boundingBox) {
+    // compressed entries keep the gpu layout of the vertices, quantized against the bounds
+    const bool isCompressed = flags & COMPRESSED;
+    std::vector<uint8_t> vertexStream, indexStream;
+    if (isCompressed) {
+        std::vector<CompactVertex> compactVertices;
+        util::quantizeVertices(vertices, boundingBox.mn, boundingBox.mx, compactVertices);
+        vertexStream = MeshCodec::encodeVertices(compactVertices.data(), compactVertices.size(), sizeof(CompactVertex));
+        indexStream = MeshCodec::encodeIndices(indices.data(), indices.size());
+    }
+    const uint8_t *vertexData = isCompressed ? vertexStream.data() : reinterpret_cast<const uint8_t *>(vertices.data());
+    const uint8_t *indexData = isCompressed ? indexStream.data() : reinterpret_cast<const uint8_t *>(indices.data());
+
+    Header header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.vertexStride = isCompressed ? sizeof(CompactVertex) : sizeof(Vertex);
+    header.indexStride = sizeof(IndexFormat);
+    header.flags = flags;
+    if (!util::fileStamp(sourcePath, header.sourceWriteTime, header.sourceSize)) return false;
+    if (!util::hashFile(sourcePath, header.sourceHash)) return false;
+
+    const std::string absolutePath = std::filesystem::absolute(sourcePath).generic_string();
+    header.sourcePathLength = absolutePath.size();
+    header.vertexCount = vertices.size();
+    header.indexCount = indices.size();
+    header.vertexSize = isCompressed ? vertexStream.size() : vertices.size() * sizeof(Vertex);
+    header.indexSize = isCompressed ? indexStream.size() : indices.size() * sizeof(IndexFormat);
+    header.vertexOffset = util::alignUp(sizeof(Header) + absolutePath.size(), s_dataAlignment);
+    header.indexOffset = util::alignUp(header.vertexOffset + header.vertexSize, s_dataAlignment);
+    header.lodCount = lods.size();
+    header.lodOffset = util::alignUp(header.indexOffset + header.indexSize, s_dataAlignment);
+    header.meshletCount = meshlets.size();
+    header.meshletOffset = util::alignUp(header.lodOffset + lods.size() * sizeof(MeshLOD), s_dataAlignment);
+    for (int i = 0; i < 3; i++) {
+        header.boundsMin[i] = boundingBox.mn[i];
+        header.boundsMax[i] = boundingBox.mx[i];
+    }
+
+    // write to a temporary file first, so a half-written entry is never picked up
+    const std::string path = entryPath(sourcePath);
+    const std::string tmpPath = path + ".tmp";
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    {
+        std::ofstream stream(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!stream) return false;
+
+        const char padding[s_dataAlignment] = {};
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+        stream.write(absolutePath.data(), absolutePath.size());
+        stream.write(padding, header.vertexOffset - sizeof(Header) - absolutePath.size());
+        stream.write(reinterpret_cast<const char *>(vertexData), header.vertexSize);
+        stream.write(padding, header.indexOffset - header.vertexOffset - header.vertexSize);
+        stream.write(reinterpret_cast<const char *>(indexData), header.indexSize);
+        stream.write(padding, header.lodOffset - header.indexOffset - header.indexSize);
+        stream.write(reinterpret_cast<const char *>(lods.data()), lods.size() * sizeof(MeshLOD));
+        stream.write(padding, header.meshletOffset - header.lodOffset - lods.size() * sizeof(MeshLOD));
+        stream.write(reinterpret_cast<const char *>(meshlets.data()), meshlets.size() * sizeof(Meshlet));
+        if (!stream) return false;
+    }
+
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+
+    return true;
+}
+
+bool MeshCache::unpack(const MappedMesh& cached, Mesh& mesh) {
+    mesh.lods = cached.lods;
+    mesh.meshlets = cached.meshlets;
+
+    // no copy, the renderer batches from the mapping (load checked the alignment)
+    if (!(cached.flags & COMPRESSED)) {
+        mesh.mapping = cached.file;
+        mesh.mappedVertices = {reinterpret_cast<const Vertex *>(cached.vertexData), cached.vertexCount};
+        mesh.mappedIndices = {reinterpret_cast<const IndexFormat *>(cached.indexData), cached.indexCount};
+        return true;
+    }
+
+    // decode straight into the layouts the renderer batches, the float vertices are only used on the cpu
+    mesh.compactVertices.resize(cached.vertexCount);
+    mesh.indices.resize(cached.indexCount);
+    if (!MeshCodec::decodeVertices(cached.vertexData, cached.vertexSize, mesh.compactVertices.data(),
+                                   cached.vertexCount, sizeof(CompactVertex)) ||
+        !MeshCodec::decodeIndices(cached.indexData, cached.indexSize, mesh.indices.data(), cached.indexCount))
+        return false;
+
+    mesh.vertices.clear();
+    util::dequantizeVertices(mesh.compactVertices, cached.boundingBox.mn, cached.boundingBox.mx, mesh.vertices);
+    return true;
+}
+
+}  // namespace gpro
@@ -0,0 +1,469 @@
+#include "gpro/mesh_codec.hpp"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define GPRO_CODEC_SSE
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define GPRO_TARGET_SSSE3
+#else
+#define GPRO_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define GPRO_CODEC_NEON
+#include <arm_neon.h>
+#endif
+
+namespace gpro {
+
+namespace {
+
+static_assert(sizeof(IndexFormat) == 4, "the index codec expects 32 bit indices");
+
+inline uint32_t zigzag32(uint32_t v) { return (v << 1) ^ static_cast<uint32_t>(static_cast<int32_t>(v) >> 31); }
+inline uint32_t unzigzag32(uint32_t v) { return (v >> 1) ^ (0u - (v & 1)); }
+inline uint8_t zigzag8(uint8_t v) { return static_cast<uint8_t>((v << 1) ^ (static_cast<int8_t>(v) >> 7)); }
+inline uint8_t unzigzag8(uint8_t v) { return static_cast<uint8_t>((v >> 1) ^ (0u - (v & 1))); }
+
+// bits per value of a vertex byte plane, by its 2-bit header code
+constexpr uint32_t PLANE_BITS[4] = {0, 2, 4, 8};
+
+/* -------------------------------------------------------------------------- */
+/*                                   indices                                  */
+/* -------------------------------------------------------------------------- */
+
+// stream vbyte layout: ceil(count / 4) control bytes, then the data bytes. a control byte holds the byte length - 1
+// of four consecutive values, the first value in the low bits
+
+// pshufb / tbl masks that spread the data bytes of one control byte into four 32-bit lanes
+struct IndexDecodeTables {
+    std::array<std::array<uint8_t, 16>, 256> shuffles{};
+    std::array<uint8_t, 256> lengths{};
+
+    constexpr IndexDecodeTables() {
+        for (uint32_t control = 0; control < 256; control++) {
+            uint8_t offset = 0;
+            for (uint32_t lane = 0; lane < 4; lane++) {
+                const uint8_t length = ((control >> (lane * 2)) & 3) + 1;
+                for (uint8_t b = 0; b < 4; b++) shuffles[control][lane * 4 + b] = b < length ? offset + b : 0x80;
+                offset += length;
+            }
+            lengths[control] = offset;
+        }
+    }
+};
+constexpr IndexDecodeTables INDEX_TABLES;
+
+// decodes indices [first, count), returns the data read position or nullptr if the stream is too short
+const uint8_t *decodeIndicesScalar(const uint8_t *control, const uint8_t *data, const uint8_t *end,
+                                   IndexFormat *indices, size_t first, size_t count) {
+    uint32_t previous = first > 0 ? indices[first - 1] : 0;
+    for (size_t i = first; i < count; i++) {
+        const uint32_t length = ((control[i / 4] >> ((i % 4) * 2)) & 3) + 1;
+        if (data + length > end) return nullptr;
+
+        uint32_t value = 0;
+        for (uint32_t b = 0; b < length; b++) value |= static_cast<uint32_t>(data[b]) << (b * 8);
+        data += length;
+
+        previous += unzigzag32(value);
+        indices[i] = previous;
+    }
+    return data;
+}
+
+#if defined(GPRO_CODEC_SSE)
+GPRO_TARGET_SSSE3 const uint8_t *decodeIndicesSSSE3(const uint8_t *control, const uint8_t *data,
+                                                    const uint8_t *end, IndexFormat *indices, size_t count) {
+    const __m128i one = _mm_set1_epi32(1);
+    __m128i previous = _mm_setzero_si128();
+
+    // full control bytes while a 16 byte load stays inside the stream
+    size_t i = 0;
+    for (; i + 4 <= count && data + 16 <= end; i += 4) {
+        const uint8_t code = control[i / 4];
+        const __m128i shuffle =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(INDEX_TABLES.shuffles[code].data()));
+        __m128i v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data)), shuffle);
+        data += INDEX_TABLES.lengths[code];
+
+        // unzigzag and prefix sum over the four lanes
+        v = _mm_xor_si128(_mm_srli_epi32(v, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(v, one)));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi32(v, previous);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(indices + i), v);
+        previous = _mm_shuffle_epi32(v, 0xFF);
+    }
+    return decodeIndicesScalar(control, data, end, indices, i, count);
+}
+#endif
+
+#if defined(GPRO_CODEC_NEON)
+const uint8_t *decodeIndicesNEON(const uint8_t *control, const uint8_t *data, const uint8_t *end,
+                                 IndexFormat *indices, size_t count) {
+    const uint32x4_t zero = vdupq_n_u32(0);
+    const uint32x4_t one = vdupq_n_u32(1);
+    uint32x4_t previous = zero;
+
+    size_t i = 0;
+    for (; i + 4 <= count && data + 16 <= end; i += 4) {
+        const uint8_t code = control[i / 4];
+        const uint8x16_t shuffle = vld1q_u8(INDEX_TABLES.shuffles[code].data());
+        uint32x4_t v = vreinterpretq_u32_u8(vqtbl1q_u8(vld1q_u8(data), shuffle));
+        data += INDEX_TABLES.lengths[code];
+
+        v = veorq_u32(vshrq_n_u32(v, 1), vsubq_u32(zero, vandq_u32(v, one)));
+        v = vaddq_u32(v, vextq_u32(zero, v, 3));
+        v = vaddq_u32(v, vextq_u32(zero, v, 2));
+        v = vaddq_u32(v, previous);
+        vst1q_u32(indices + i, v);
+        previous = vdupq_laneq_u32(v, 3);
+    }
+    return decodeIndicesScalar(control, data, end, indices, i, count);
+}
+#endif
+
+/* -------------------------------------------------------------------------- */
+/*                                  vertices                                  */
+/* -------------------------------------------------------------------------- */
+
+// per group of 16 vertices: stride / 4 header bytes with a 2-bit code per vertex byte, then for every byte the
+// packed plane of its 16 zigzagged deltas. 2-bit planes keep value 4j + k at bit 2k of byte j, 4-bit planes value
+// 2j in the low nibble of byte j
+
+size_t planeSize(uint32_t code) { return PLANE_BITS[code] * MeshCodec::GROUP_SIZE / 8; }
+
+const uint8_t *decodeVerticesScalar(const uint8_t *data, const uint8_t *end, uint8_t *vertices, size_t count,
+                                    size_t stride) {
+    std::array<uint8_t, MeshCodec::MAX_VERTEX_STRIDE> previous{};
+    std::array<uint8_t, MeshCodec::GROUP_SIZE> plane;
+
+    for (size_t group = 0; group < count; group += MeshCodec::GROUP_SIZE) {
+        const size_t groupCount = std::min<size_t>(MeshCodec::GROUP_SIZE, count - group);
+        if (data + stride / 4 > end) return nullptr;
+        const uint8_t *header = data;
+        data += stride / 4;
+
+        for (size_t k = 0; k < stride; k++) {
+            const uint32_t code = (header[k / 4] >> ((k % 4) * 2)) & 3;
+            if (data + planeSize(code) > end) return nullptr;
+
+            for (uint32_t v = 0; v < MeshCodec::GROUP_SIZE; v++) {
+                switch (code) {
+                    case 0: plane[v] = 0; break;
+                    case 1: plane[v] = (data[v / 4] >> ((v % 4) * 2)) & 3; break;
+                    case 2: plane[v] = (data[v / 2] >> ((v % 2) * 4)) & 15; break;
+                    default: plane[v] = data[v]; break;
+                }
+            }
+            data += planeSize(code);
+
+            uint8_t value = previous[k];
+            for (size_t v = 0; v < groupCount; v++) {
+                value += unzigzag8(plane[v]);
+                vertices[(group + v) * stride + k] = value;
+            }
+            previous[k] = value;
+        }
+    }
+    return data;
+}
+
+#if defined(GPRO_CODEC_SSE)
+using Bytes16 = __m128i;
+
+inline Bytes16 zipLo8(Bytes16 a, Bytes16 b) { return _mm_unpacklo_epi8(a, b); }
+inline Bytes16 zipHi8(Bytes16 a, Bytes16 b) { return _mm_unpackhi_epi8(a, b); }
+inline Bytes16 zipLo16(Bytes16 a, Bytes16 b) { return _mm_unpacklo_epi16(a, b); }
+inline Bytes16 zipHi16(Bytes16 a, Bytes16 b) { return _mm_unpackhi_epi16(a, b); }
+inline Bytes16 zipLo32(Bytes16 a, Bytes16 b) { return _mm_unpacklo_epi32(a, b); }
+inline Bytes16 zipHi32(Bytes16 a, Bytes16 b) { return _mm_unpackhi_epi32(a, b); }
+inline Bytes16 zipLo64(Bytes16 a, Bytes16 b) { return _mm_unpacklo_epi64(a, b); }
+inline Bytes16 zipHi64(Bytes16 a, Bytes16 b) { return _mm_unpackhi_epi64(a, b); }
+
+inline Bytes16 decodePlane(uint32_t code, const uint8_t *data) {
+    switch (code) {
+        case 0: return _mm_setzero_si128();
+        case 1: {
+            uint32_t packed;
+            std::memcpy(&packed, data, sizeof(packed));
+            const __m128i v = _mm_cvtsi32_si128(static_cast<int>(packed));
+            const __m128i mask = _mm_set1_epi8(3);
+            const __m128i b0 = _mm_and_si128(v, mask);
+            const __m128i b1 = _mm_and_si128(_mm_srli_epi16(v, 2), mask);
+            const __m128i b2 = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+            const __m128i b3 = _mm_and_si128(_mm_srli_epi16(v, 6), mask);
+            return _mm_unpacklo_epi16(_mm_unpacklo_epi8(b0, b1), _mm_unpacklo_epi8(b2, b3));
+        }
+        case 2: {
+            const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(data));
+            const __m128i mask = _mm_set1_epi8(15);
+            return _mm_unpacklo_epi8(_mm_and_si128(v, mask), _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+        }
+        default: return _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+    }
+}
+
+inline Bytes16 unzigzagBytes(Bytes16 v) {
+    const __m128i high = _mm_and_si128(_mm_srli_epi16(v, 1), _mm_set1_epi8(0x7F));
+    return _mm_xor_si128(high, _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(v, _mm_set1_epi8(1))));
+}
+
+inline Bytes16 addBytes(Bytes16 a, Bytes16 b) { return _mm_add_epi8(a, b); }
+inline Bytes16 loadBytes(const uint8_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+inline void storeBytes(uint8_t *p, Bytes16 v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+#define GPRO_CODEC_VERTEX_SIMD "sse2"
+#elif defined(GPRO_CODEC_NEON)
+using Bytes16 = uint8x16_t;
+
+inline Bytes16 zipLo8(Bytes16 a, Bytes16 b) { return vzip1q_u8(a, b); }
+inline Bytes16 zipHi8(Bytes16 a, Bytes16 b) { return vzip2q_u8(a, b); }
+inline Bytes16 zipLo16(Bytes16 a, Bytes16 b) {
+    return vreinterpretq_u8_u16(vzip1q_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)));
+}
+inline Bytes16 zipHi16(Bytes16 a, Bytes16 b) {
+    return vreinterpretq_u8_u16(vzip2q_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)));
+}
+inline Bytes16 zipLo32(Bytes16 a, Bytes16 b) {
+    return vreinterpretq_u8_u32(vzip1q_u32(vreinterpretq_u32_u8(a), vreinterpretq_u32_u8(b)));
+}
+inline Bytes16 zipHi32(Bytes16 a, Bytes16 b) {
+    return vreinterpretq_u8_u32(vzip2q_u32(vreinterpretq_u32_u8(a), vreinterpretq_u32_u8(b)));
+}
+inline Bytes16 zipLo64(Bytes16 a, Bytes16 b) {
+    return vreinterpretq_u8_u64(vzip1q_u64(vreinterpretq_u64_u8(a), vreinterpretq_u64_u8(b)));
+}
+inline Bytes16 zipHi64(Bytes16 a, Bytes16 b) {
+    return vreinterpretq_u8_u64(vzip2q_u64(vreinterpretq_u64_u8(a), vreinterpretq_u64_u8(b)));
+}
+
+inline Bytes16 decodePlane(uint32_t code, const uint8_t *data) {
+    switch (code) {
+        case 0: return vdupq_n_u8(0);
+        case 1: {
+            uint32_t packed;
+            std::memcpy(&packed, data, sizeof(packed));
+            const uint8x8_t v = vreinterpret_u8_u32(vdup_n_u32(packed));
+            const uint8x8_t mask = vdup_n_u8(3);
+            const uint8x8_t b01 = vzip1_u8(vand_u8(v, mask), vand_u8(vshr_n_u8(v, 2), mask));
+            const uint8x8_t b23 = vzip1_u8(vand_u8(vshr_n_u8(v, 4), mask), vshr_n_u8(v, 6));
+            return vreinterpretq_u8_u16(
+                vcombine_u16(vzip1_u16(vreinterpret_u16_u8(b01), vreinterpret_u16_u8(b23)),
+                             vzip2_u16(vreinterpret_u16_u8(b01), vreinterpret_u16_u8(b23))));
+        }
+        case 2: {
+            const uint8x8_t v = vld1_u8(data);
+            const uint8x8x2_t nibbles = vzip_u8(vand_u8(v, vdup_n_u8(15)), vshr_n_u8(v, 4));
+            return vcombine_u8(nibbles.val[0], nibbles.val[1]);
+        }
+        default: return vld1q_u8(data);
+    }
+}
+
+inline Bytes16 unzigzagBytes(Bytes16 v) {
+    return veorq_u8(vshrq_n_u8(v, 1), vsubq_u8(vdupq_n_u8(0), vandq_u8(v, vdupq_n_u8(1))));
+}
+
+inline Bytes16 addBytes(Bytes16 a, Bytes16 b) { return vaddq_u8(a, b); }
+inline Bytes16 loadBytes(const uint8_t *p) { return vld1q_u8(p); }
+inline void storeBytes(uint8_t *p, Bytes16 v) { vst1q_u8(p, v); }
+#define GPRO_CODEC_VERTEX_SIMD "neon"
+#endif
+
+#if defined(GPRO_CODEC_VERTEX_SIMD)
+// rows[i] byte j <-> rows[j] byte i, four interleave passes of growing width
+inline void transpose16x16(Bytes16 *rows) {
+    Bytes16 a[16], b[16];
+    for (int i = 0; i < 8; i++) {
+        a[2 * i] = zipLo8(rows[2 * i], rows[2 * i + 1]);
+        a[2 * i + 1] = zipHi8(rows[2 * i], rows[2 * i + 1]);
+    }
+    for (int i = 0; i < 4; i++) {
+        b[4 * i + 0] = zipLo16(a[4 * i], a[4 * i + 2]);
+        b[4 * i + 1] = zipHi16(a[4 * i], a[4 * i + 2]);
+        b[4 * i + 2] = zipLo16(a[4 * i + 1], a[4 * i + 3]);
+        b[4 * i + 3] = zipHi16(a[4 * i + 1], a[4 * i + 3]);
+    }
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 4; j++) {
+            a[8 * i + 2 * j] = zipLo32(b[8 * i + j], b[8 * i + j + 4]);
+            a[8 * i + 2 * j + 1] = zipHi32(b[8 * i + j], b[8 * i + j + 4]);
+        }
+    }
+    for (int i = 0; i < 8; i++) {
+        rows[2 * i] = zipLo64(a[i], a[i + 8]);
+        rows[2 * i + 1] = zipHi64(a[i], a[i + 8]);
+    }
+}
+
+// strides that are a multiple of 16: 16 byte planes are unpacked, transposed into 16 vertex rows and summed
+const uint8_t *decodeVerticesSIMD(const uint8_t *data, const uint8_t *end, uint8_t *vertices, size_t count,
+                                  size_t stride) {
+    Bytes16 previous[MeshCodec::MAX_VERTEX_STRIDE / 16];
+    for (size_t c = 0; c < stride / 16; c++) previous[c] = decodePlane(0, nullptr);  // zeros
+
+    Bytes16 rows[16];
+    for (size_t group = 0; group < count; group += MeshCodec::GROUP_SIZE) {
+        const size_t groupCount = std::min<size_t>(MeshCodec::GROUP_SIZE, count - group);
+        if (data + stride / 4 > end) return nullptr;
+        const uint8_t *header = data;
+        data += stride / 4;
+
+        for (size_t c = 0; c < stride / 16; c++) {
+            // 4 header bytes cover the 16 planes of this chunk
+            uint32_t codes;
+            std::memcpy(&codes, header + c * 4, sizeof(codes));
+
+            for (uint32_t k = 0; k < 16; k++) {
+                const uint32_t code = (codes >> (k * 2)) & 3;
+                const size_t size = planeSize(code);
+                // plane loads read up to 16 bytes, fall back to the bounds checked scalar unpack at the tail
+                if (data + 16 > end) {
+                    if (data + size > end) return nullptr;
+                    alignas(16) uint8_t padded[16] = {};
+                    std::memcpy(padded, data, size);
+                    rows[k] = decodePlane(code, padded);
+                } else {
+                    rows[k] = decodePlane(code, data);
+                }
+                data += size;
+            }
+
+            transpose16x16(rows);
+
+            Bytes16 value = previous[c];
+            for (size_t v = 0; v < groupCount; v++) {
+                value = addBytes(value, unzigzagBytes(rows[v]));
+                storeBytes(vertices + (group + v) * stride + c * 16, value);
+            }
+            previous[c] = value;
+        }
+    }
+    return data;
+}
+#endif
+
+#if defined(GPRO_CODEC_SSE)
+bool hasSSSE3() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+#else
+    return __builtin_cpu_supports("ssse3");
+#endif
+}
+#endif
+
+}  // namespace
+
+std::vector<uint8_t> MeshCodec::encodeIndices(const IndexFormat *indices, size_t count) {
+    std::vector<uint8_t> result((count + 3) / 4, 0);
+    result.reserve(result.size() + count * 2);
+
+    uint32_t previous = 0;
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t value = zigzag32(indices[i] - previous);
+        previous = indices[i];
+
+        const uint32_t length = value < (1u << 8) ? 1 : value < (1u << 16) ? 2 : value < (1u << 24) ? 3 : 4;
+        result[i / 4] |= static_cast<uint8_t>((length - 1) << ((i % 4) * 2));
+        for (uint32_t b = 0; b < length; b++) result.push_back(static_cast<uint8_t>(value >> (b * 8)));
+    }
+    return result;
+}
+
+bool MeshCodec::decodeIndices(const uint8_t *data, size_t size, IndexFormat *indices, size_t count) {
+    const size_t controlSize = (count + 3) / 4;
+    if (size < controlSize) return false;
+
+    const uint8_t *end = data + size;
+    const uint8_t *control = data;
+    data += controlSize;
+
+#if defined(GPRO_CODEC_SSE)
+    static const bool s_hasSSSE3 = hasSSSE3();
+    if (s_hasSSSE3) return decodeIndicesSSSE3(control, data, end, indices, count) == end;
+#elif defined(GPRO_CODEC_NEON)
+    return decodeIndicesNEON(control, data, end, indices, count) == end;
+#endif
+    return decodeIndicesScalar(control, data, end, indices, 0, count) == end;
+}
+
+std::vector<uint8_t> MeshCodec::encodeVertices(const void *vertices, size_t count, size_t stride) {
+    if (stride == 0 || stride % 4 != 0 || stride > MAX_VERTEX_STRIDE) {
+        throw std::runtime_error(std::format("Unsupported vertex stride for encoding: {}", stride));
+    }
+
+    const uint8_t *bytes = static_cast<const uint8_t *>(vertices);
+    std::vector<uint8_t> result;
+    result.reserve(count * stride / 2);
+
+    std::array<uint8_t, MAX_VERTEX_STRIDE> previous{};
+    std::array<uint8_t, GROUP_SIZE> plane;
+
+    for (size_t group = 0; group < count; group += GROUP_SIZE) {
+        const size_t headerOffset = result.size();
+        result.resize(result.size() + stride / 4, 0);
+
+        for (size_t k = 0; k < stride; k++) {
+            // the last group repeats its final vertex, which encodes as zero deltas
+            uint8_t last = previous[k];
+            uint8_t maxValue = 0;
+            for (size_t v = 0; v < GROUP_SIZE; v++) {
+                const uint8_t value = bytes[std::min(group + v, count - 1) * stride + k];
+                plane[v] = zigzag8(static_cast<uint8_t>(value - last));
+                maxValue |= plane[v];
+                last = value;
+            }
+            previous[k] = last;
+
+            const uint32_t code = maxValue == 0 ? 0 : maxValue < 4 ? 1 : maxValue < 16 ? 2 : 3;
+            result[headerOffset + k / 4] |= static_cast<uint8_t>(code << ((k % 4) * 2));
+
+            switch (code) {
+                case 0: break;
+                case 1:
+                    for (size_t j = 0; j < GROUP_SIZE / 4; j++) {
+                        result.push_back(static_cast<uint8_t>(plane[4 * j] | plane[4 * j + 1] << 2 |
+                                                              plane[4 * j + 2] << 4 | plane[4 * j + 3] << 6));
+                    }
+                    break;
+                case 2:
+                    for (size_t j = 0; j < GROUP_SIZE / 2; j++) {
+                        result.push_back(static_cast<uint8_t>(plane[2 * j] | plane[2 * j + 1] << 4));
+                    }
+                    break;
+                default: result.insert(result.end(), plane.begin(), plane.end()); break;
+            }
+        }
+    }
+    return result;
+}
+
+bool MeshCodec::decodeVertices(const uint8_t *data, size_t size, void *vertices, size_t count, size_t stride) {
+    if (stride == 0 || stride % 4 != 0 || stride > MAX_VERTEX_STRIDE) return false;
+
+    const uint8_t *end = data + size;
+    uint8_t *out = static_cast<uint8_t *>(vertices);
+#if defined(GPRO_CODEC_VERTEX_SIMD)
+    if (stride % 16 == 0) return decodeVerticesSIMD(data, end, out, count, stride) == end;
+#endif
+    return decodeVerticesScalar(data, end, out, count, stride) == end;
+}
+
+const char *MeshCodec::decoderName() {
+#if defined(GPRO_CODEC_SSE)
+    return hasSSSE3() ? "ssse3 indices, sse2 vertices" : "scalar indices, sse2 vertices";
+#elif defined(GPRO_CODEC_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+}  // namespace gpro
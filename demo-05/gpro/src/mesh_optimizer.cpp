@@ -0,0 +1,509 @@
+#include "gpro/mesh_optimizer.hpp"
+
+#include <queue>
+#include <tuple>
+#include <unordered_map>
+
+namespace gpro {
+
+namespace {
+
+struct TriangleAdjacency {
+    std::vector<uint32_t> offsets;    // per vertex, into triangles
+    std::vector<uint32_t> counts;     // per vertex
+    std::vector<uint32_t> triangles;  // triangle indices grouped by vertex
+
+    TriangleAdjacency(const std::vector<IndexFormat>& indices, size_t vertexCount)
+        : offsets(vertexCount, 0), counts(vertexCount, 0), triangles(indices.size()) {
+        for (IndexFormat index : indices) counts[index]++;
+
+        uint32_t offset = 0;
+        for (size_t v = 0; v < vertexCount; v++) {
+            offsets[v] = offset;
+            offset += counts[v];
+        }
+
+        std::vector<uint32_t> fill(offsets);
+        for (size_t i = 0; i < indices.size(); i++) triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+};
+
+// symmetric 4x4 plane quadric, weighted by triangle area
+struct Quadric {
+    double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+    double weight = 0;
+
+    static Quadric fromPlane(const glm::vec3& normal, double d, double weight) {
+        const double a = normal.x, b = normal.y, c = normal.z;
+        return {weight * a * a, weight * a * b, weight * a * c, weight * a * d, weight * b * b,
+                weight * b * c, weight * b * d, weight * c * c, weight * c * d, weight * d * d, weight};
+    }
+
+    Quadric& operator+=(const Quadric& other) {
+        a2 += other.a2, ab += other.ab, ac += other.ac, ad += other.ad, b2 += other.b2;
+        bc += other.bc, bd += other.bd, c2 += other.c2, cd += other.cd, d2 += other.d2;
+        weight += other.weight;
+        return *this;
+    }
+
+    // weighted mean squared distance of p to the planes
+    double error(const glm::vec3& p) const {
+        const double x = p.x, y = p.y, z = p.z;
+        const double e = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x + b2 * y * y + 2 * bc * y * z +
+                         2 * bd * y + c2 * z * z + 2 * cd * z + d2;
+        return weight > 0 ? std::max(e, 0.0) / weight : 0;
+    }
+};
+
+// bounding sphere and normal cone of the triangles in [begin, end) of the indices
+Meshlet computeMeshletBounds(std::span<const Vertex> vertices, std::span<const IndexFormat> indices,
+                             uint32_t begin, uint32_t end, uint32_t vertexCount) {
+    Meshlet meshlet{};
+    meshlet.triangleCount = (end - begin) / 3;
+    meshlet.indexOffset = begin;
+    meshlet.vertexCount = vertexCount;
+
+    // sphere around the center of the corner bounds
+    glm::vec3 mn(std::numeric_limits<float>::max());
+    glm::vec3 mx(std::numeric_limits<float>::lowest());
+    for (uint32_t i = begin; i < end; i++) {
+        mn = glm::min(mn, vertices[indices[i]].position);
+        mx = glm::max(mx, vertices[indices[i]].position);
+    }
+    meshlet.center = (mn + mx) * 0.5f;
+    for (uint32_t i = begin; i < end; i++)
+        meshlet.radius = std::max(meshlet.radius, glm::length(vertices[indices[i]].position - meshlet.center));
+
+    // cone around the average triangle normal, degenerate triangles do not contribute
+    struct TrianglePlane {
+        glm::vec3 point;
+        glm::vec3 normal;
+    };
+    std::vector<TrianglePlane> planes;
+    planes.reserve(meshlet.triangleCount);
+    glm::vec3 axis(0);
+    for (uint32_t i = begin; i < end; i += 3) {
+        const glm::vec3& a = vertices[indices[i + 0]].position;
+        const glm::vec3 n = glm::cross(vertices[indices[i + 1]].position - a, vertices[indices[i + 2]].position - a);
+        const float area = glm::length(n);
+        if (area <= std::numeric_limits<float>::min()) continue;
+        planes.push_back({a, n / area});
+        axis += n / area;
+    }
+
+    meshlet.coneApex = meshlet.center;
+    meshlet.coneAxis = glm::vec3(0, 0, 1);
+    meshlet.coneCutoff = 1;
+
+    const float axisLength = glm::length(axis);
+    if (planes.empty() || axisLength <= std::numeric_limits<float>::min()) return meshlet;
+    axis /= axisLength;
+
+    float minDot = 1;
+    for (const TrianglePlane& plane : planes) minDot = std::min(minDot, glm::dot(plane.normal, axis));
+
+    // a cone wider than ~84 degrees half angle rejects too little to be worth testing
+    if (minDot <= 0.1f) return meshlet;
+
+    // move the apex back along the axis until it is behind every triangle plane
+    float maxT = 0;
+    for (const TrianglePlane& plane : planes)
+        maxT = std::max(maxT, glm::dot(meshlet.center - plane.point, plane.normal) / glm::dot(axis, plane.normal));
+
+    meshlet.coneApex = meshlet.center - axis * maxT;
+    meshlet.coneAxis = axis;
+    meshlet.coneCutoff = std::sqrt(1 - minDot * minDot);
+    return meshlet;
+}
+
+}  // namespace
+
+void MeshOptimizer::optimizeVertexCache(std::vector<IndexFormat>& indices, size_t vertexCount, uint32_t cacheSize) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0) return;
+
+    TriangleAdjacency adjacency(indices, vertexCount);
+
+    std::vector<uint32_t> liveTriangles(adjacency.counts);
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    deadEnd.reserve(indices.size());
+
+    std::vector<IndexFormat> result;
+    result.reserve(indices.size());
+
+    uint32_t timeStamp = cacheSize + 1;
+    uint32_t cursor = 0;
+    int64_t fanningVertex = 0;
+
+    // first vertex that is still referenced by a triangle, -1 when everything is emitted
+    auto skipDeadEnd = [&]() -> int64_t {
+        while (!deadEnd.empty()) {
+            uint32_t v = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveTriangles[v] > 0) return v;
+        }
+        while (cursor < vertexCount) {
+            if (liveTriangles[cursor] > 0) return cursor;
+            cursor++;
+        }
+        return -1;
+    };
+
+    while (fanningVertex >= 0) {
+        candidates.clear();
+
+        // emit all remaining triangles around the fanning vertex
+        const uint32_t begin = adjacency.offsets[fanningVertex];
+        const uint32_t end = begin + adjacency.counts[fanningVertex];
+        for (uint32_t a = begin; a < end; a++) {
+            const uint32_t triangle = adjacency.triangles[a];
+            if (emitted[triangle]) continue;
+
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                const IndexFormat v = indices[triangle * 3 + corner];
+                result.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                liveTriangles[v]--;
+
+                if (timeStamp - cacheTime[v] > cacheSize) cacheTime[v] = timeStamp++;
+            }
+            emitted[triangle] = true;
+        }
+
+        // pick the candidate that stays longest in the cache, but will not be evicted before its fan is emitted
+        int64_t best = -1;
+        int64_t bestPriority = -1;
+        for (uint32_t v : candidates) {
+            if (liveTriangles[v] == 0) continue;
+
+            int64_t priority = 0;
+            if (timeStamp - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize) priority = timeStamp - cacheTime[v];
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                best = v;
+            }
+        }
+
+        fanningVertex = best >= 0 ? best : skipDeadEnd();
+    }
+
+    indices = std::move(result);
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<IndexFormat>& indices) {
+    constexpr IndexFormat UNUSED = std::numeric_limits<IndexFormat>::max();
+
+    std::vector<IndexFormat> remap(vertices.size(), UNUSED);
+    std::vector<Vertex> result;
+    result.reserve(vertices.size());
+
+    for (IndexFormat& index : indices) {
+        if (remap[index] == UNUSED) {
+            remap[index] = static_cast<IndexFormat>(result.size());
+            result.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    vertices = std::move(result);
+}
+
+float MeshOptimizer::simplify(const std::vector<Vertex>& vertices, const std::vector<IndexFormat>& indices,
+                              size_t targetIndexCount, std::vector<IndexFormat>& result) {
+    const size_t vertexCount = vertices.size();
+    const size_t triangleCount = indices.size() / 3;
+    std::vector<IndexFormat> triangles(indices.begin(), indices.begin() + triangleCount * 3);
+
+    // vertices sharing a position (attribute seams) get the same position id
+    std::vector<uint32_t> order(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++) order[v] = v;
+    auto lessPosition = [&](uint32_t l, uint32_t r) {
+        const glm::vec3& a = vertices[l].position;
+        const glm::vec3& b = vertices[r].position;
+        return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+    };
+    std::sort(order.begin(), order.end(), lessPosition);
+
+    std::vector<uint32_t> positionID(vertexCount);
+    std::vector<uint8_t> locked(vertexCount, 0);
+    uint32_t positionCount = 0;
+    for (size_t begin = 0, end; begin < vertexCount; begin = end) {
+        for (end = begin + 1; end < vertexCount && !lessPosition(order[begin], order[end]); end++) {}
+        for (size_t i = begin; i < end; i++) {
+            positionID[order[i]] = positionCount;
+            locked[order[i]] = end - begin > 1;
+        }
+        positionCount++;
+    }
+
+    // open borders and non-manifold edges are locked too
+    std::unordered_map<uint64_t, uint32_t> edgeUseCount;
+    edgeUseCount.reserve(triangles.size());
+    for (size_t i = 0; i < triangles.size(); i++) {
+        uint64_t a = positionID[triangles[i]];
+        uint64_t b = positionID[triangles[i - i % 3 + (i + 1) % 3]];
+        edgeUseCount[std::min(a, b) << 32 | std::max(a, b)]++;
+    }
+    std::vector<uint8_t> lockedPosition(positionCount, 0);
+    for (const auto& [edge, count] : edgeUseCount) {
+        if (count == 2) continue;
+        lockedPosition[edge >> 32] = 1;
+        lockedPosition[edge & 0xFFFFFFFF] = 1;
+    }
+    for (size_t v = 0; v < vertexCount; v++) locked[v] |= lockedPosition[positionID[v]];
+
+    // quadrics per position, triangle fans per vertex
+    std::vector<Quadric> quadrics(positionCount);
+    std::vector<std::vector<uint32_t>> fans(vertexCount);
+    for (uint32_t t = 0; t < triangleCount; t++) {
+        const glm::vec3& a = vertices[triangles[t * 3 + 0]].position;
+        const glm::vec3 n = glm::cross(vertices[triangles[t * 3 + 1]].position - a, vertices[triangles[t * 3 + 2]].position - a);
+        const float area = glm::length(n);
+        for (uint32_t corner = 0; corner < 3; corner++) fans[triangles[t * 3 + corner]].push_back(t);
+        if (area <= std::numeric_limits<float>::min()) continue;
+
+        const Quadric quadric = Quadric::fromPlane(n / area, -glm::dot(n / area, a), area);
+        for (uint32_t corner = 0; corner < 3; corner++) quadrics[positionID[triangles[t * 3 + corner]]] += quadric;
+    }
+
+    // collapses of `from` into its neighbor `to`, outdated entries are skipped by version
+    struct Collapse {
+        double priority;
+        double error;
+        uint32_t from, to;
+        uint32_t fromVersion, toVersion;
+        bool operator>(const Collapse& other) const { return priority > other.priority; }
+    };
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<>> queue;
+    std::vector<uint32_t> version(vertexCount, 0);
+    std::vector<uint8_t> removed(vertexCount, 0);
+    std::vector<uint8_t> deadTriangle(triangleCount, 0);
+
+    auto pushCollapse = [&](uint32_t from, uint32_t to) {
+        if (locked[from] || removed[from] || removed[to]) return;
+        Quadric quadric = quadrics[positionID[from]];
+        quadric += quadrics[positionID[to]];
+        const double error = quadric.error(vertices[to].position);
+
+        // short edges first where the error ties (flat regions), otherwise collapses pile up on one vertex
+        const glm::vec3 edge = vertices[to].position - vertices[from].position;
+        queue.push({error + 1e-3 * glm::dot(edge, edge), error, from, to, version[from], version[to]});
+    };
+    // unique neighbors of v over its live triangles
+    std::vector<uint32_t> neighbors;
+    auto gatherNeighbors = [&](uint32_t v) {
+        neighbors.clear();
+        for (uint32_t t : fans[v]) {
+            if (deadTriangle[t]) continue;
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                const uint32_t u = triangles[t * 3 + corner];
+                if (u != v && std::find(neighbors.begin(), neighbors.end(), u) == neighbors.end()) neighbors.push_back(u);
+            }
+        }
+    };
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        if (locked[v]) continue;
+        gatherNeighbors(v);
+        for (uint32_t u : neighbors) pushCollapse(v, u);
+    }
+
+    size_t indexCount = triangles.size();
+    double maxError = 0;
+    while (indexCount > targetIndexCount && !queue.empty()) {
+        const Collapse collapse = queue.top();
+        queue.pop();
+        if (removed[collapse.from] || removed[collapse.to] || version[collapse.from] != collapse.fromVersion ||
+            version[collapse.to] != collapse.toVersion)
+            continue;
+
+        // the edge must still exist, and no remaining triangle of the fan may flip or touch a seam copy of `to`
+        const glm::vec3& target = vertices[collapse.to].position;
+        bool isConnected = false;
+        bool isValid = true;
+        for (uint32_t t : fans[collapse.from]) {
+            if (deadTriangle[t]) continue;
+
+            glm::vec3 p[3];
+            bool hasTo = false;
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                const uint32_t v = triangles[t * 3 + corner];
+                hasTo |= v == collapse.to;
+                isValid &= v == collapse.to || positionID[v] != positionID[collapse.to];
+                p[corner] = vertices[v].position;
+            }
+            if (hasTo) {
+                isConnected = true;
+                continue;
+            }
+
+            const glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                if (triangles[t * 3 + corner] == collapse.from) p[corner] = target;
+            }
+            isValid &= glm::dot(before, glm::cross(p[1] - p[0], p[2] - p[0])) > 0;
+        }
+        if (!isConnected || !isValid) continue;
+
+        // collapse: triangles on the edge die, the rest of the fan moves to `to`
+        for (uint32_t t : fans[collapse.from]) {
+            if (deadTriangle[t]) continue;
+
+            bool hasTo = false;
+            for (uint32_t corner = 0; corner < 3; corner++) hasTo |= triangles[t * 3 + corner] == collapse.to;
+            if (hasTo) {
+                deadTriangle[t] = 1;
+                indexCount -= 3;
+                continue;
+            }
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                if (triangles[t * 3 + corner] == collapse.from) triangles[t * 3 + corner] = collapse.to;
+            }
+            fans[collapse.to].push_back(t);
+        }
+        fans[collapse.from].clear();
+        std::erase_if(fans[collapse.to], [&](uint32_t t) { return deadTriangle[t]; });
+        removed[collapse.from] = 1;
+
+        quadrics[positionID[collapse.to]] += quadrics[positionID[collapse.from]];
+        maxError = std::max(maxError, collapse.error);
+        version[collapse.to]++;
+
+        // every edge at `to` has a new cost
+        gatherNeighbors(collapse.to);
+        for (uint32_t u : neighbors) {
+            pushCollapse(collapse.to, u);
+            pushCollapse(u, collapse.to);
+        }
+    }
+
+    result.clear();
+    result.reserve(indexCount);
+    for (uint32_t t = 0; t < triangleCount; t++) {
+        if (!deadTriangle[t]) result.insert(result.end(), triangles.begin() + t * 3, triangles.begin() + t * 3 + 3);
+    }
+
+    return static_cast<float>(std::sqrt(maxError));
+}
+
+void MeshOptimizer::buildLodChain(const std::vector<Vertex>& vertices, std::vector<IndexFormat>& indices,
+                                  std::vector<MeshLOD>& lods, uint32_t maxLodCount) {
+    lods.clear();
+    lods.push_back({0, static_cast<uint32_t>(indices.size()), 0, 0, 0});
+
+    std::vector<IndexFormat> source(indices);
+    std::vector<IndexFormat> lod;
+    float error = 0;
+    while (lods.size() < maxLodCount) {
+        const size_t target = source.size() / 2 / 3 * 3;
+        const float lodError = simplify(vertices, source, target, lod);
+
+        // stop when locked vertices keep the level close to the previous one
+        if (lod.empty() || lod.size() > source.size() * 85 / 100) break;
+
+        // errors add up, every level is simplified from the previous one
+        error += lodError;
+        optimizeVertexCache(lod, vertices.size());
+        lods.push_back({static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lod.size()), 0, 0, error});
+        indices.insert(indices.end(), lod.begin(), lod.end());
+        source.swap(lod);
+    }
+}
+
+void MeshOptimizer::buildMeshlets(std::span<const Vertex> vertices, std::span<const IndexFormat> indices,
+                                  std::vector<MeshLOD>& lods, std::vector<Meshlet>& meshlets, uint32_t maxVertices,
+                                  uint32_t maxTriangles) {
+    meshlets.clear();
+
+    // a vertex is in the current meshlet if it was last stamped with the current meshlet index
+    constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> stamp(vertices.size(), NONE);
+    uint32_t current = 0;
+
+    for (uint32_t level = 0; level < lods.size(); level++) {
+        MeshLOD& lod = lods[level];
+        lod.meshletOffset = static_cast<uint32_t>(meshlets.size());
+
+        auto pushMeshlet = [&](uint32_t begin, uint32_t end, uint32_t vertexCount) {
+            meshlets.push_back(computeMeshletBounds(vertices, indices, begin, end, vertexCount));
+            meshlets.back().lod = level;
+            current++;
+        };
+
+        uint32_t begin = lod.indexOffset;
+        uint32_t vertexCount = 0;
+        const uint32_t end = lod.indexOffset + lod.indexCount - lod.indexCount % 3;
+        for (uint32_t i = begin; i < end; i += 3) {
+            uint32_t newVertices = 0;
+            for (uint32_t corner = 0; corner < 3; corner++) newVertices += stamp[indices[i + corner]] != current;
+
+            if (vertexCount + newVertices > maxVertices || (i - begin) / 3 == maxTriangles) {
+                pushMeshlet(begin, i, vertexCount);
+                begin = i;
+                vertexCount = 0;
+            }
+
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                if (stamp[indices[i + corner]] == current) continue;
+                stamp[indices[i + corner]] = current;
+                vertexCount++;
+            }
+        }
+        if (begin < end) pushMeshlet(begin, end, vertexCount);
+
+        lod.meshletCount = static_cast<uint32_t>(meshlets.size()) - lod.meshletOffset;
+    }
+}
+
+MeshOptimizer::VertexCacheStats MeshOptimizer::analyzeVertexCache(const std::vector<IndexFormat>& indices,
+                                                                  size_t vertexCount, uint32_t cacheSize,
+                                                                  CacheModel model) {
+    VertexCacheStats stats;
+    if (indices.empty() || vertexCount == 0) return stats;
+
+    uint32_t misses = 0;
+    if (model == CacheModel::fifo) {
+        // a vertex is cached if fewer than cacheSize vertices were inserted after it
+        std::vector<uint64_t> insertedAt(vertexCount, 0);
+        uint64_t insertCount = cacheSize + 1;
+        for (IndexFormat index : indices) {
+            if (insertCount - insertedAt[index] > cacheSize) {
+                insertedAt[index] = insertCount++;
+                misses++;
+            }
+        }
+    } else {
+        // most recently used first
+        std::vector<IndexFormat> cache;
+        cache.reserve(cacheSize + 1);
+        for (IndexFormat index : indices) {
+            auto it = std::find(cache.begin(), cache.end(), index);
+            if (it == cache.end()) {
+                misses++;
+                cache.insert(cache.begin(), index);
+                if (cache.size() > cacheSize) cache.pop_back();
+            } else {
+                std::rotate(cache.begin(), it, it + 1);
+            }
+        }
+    }
+
+    std::vector<bool> referenced(vertexCount, false);
+    uint32_t referencedCount = 0;
+    for (IndexFormat index : indices) {
+        if (!referenced[index]) {
+            referenced[index] = true;
+            referencedCount++;
+        }
+    }
+
+    stats.transformedVertexCount = misses;
+    stats.acmr = misses / float(indices.size() / 3);
+    stats.atvr = misses / float(referencedCount);
+    return stats;
+}
+
+}  // namespace gpro
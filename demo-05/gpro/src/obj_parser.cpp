@@ -0,0 +1,254 @@
+#include "gpro/obj_parser.hpp"
+
+#include <charconv>
+#include <cstring>
+
+#include "gpro/mapped_file.hpp"
+
+namespace gpro {
+
+namespace {
+
+constexpr size_t MIN_CHUNK_SIZE = 256 * 1024;
+
+struct Chunk {
+    const char *begin = nullptr;
+    const char *end = nullptr;
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
+    std::vector<ObjParser::Corner> corners;
+    std::vector<uint32_t> relativeIndices;  // corner * 3 + attribute of negative indices, resolved on merge
+
+    std::string error;
+};
+
+struct FaceCorner {
+    ObjParser::Corner corner;
+    uint8_t relativeMask;  // bit i -> attribute i is relative to the chunk's own record counts
+};
+
+inline bool isSpace(char c) { return c == ' ' || c == '\t'; }
+
+inline const char *skipSpaces(const char *p, const char *end) {
+    while (p < end && isSpace(*p)) p++;
+    return p;
+}
+
+inline const char *parseFloat(const char *p, const char *end, float& value) {
+    p = skipSpaces(p, end);
+    if (p < end && *p == '+') p++;
+    auto [ptr, ec] = std::from_chars(p, end, value);
+    if (ec == std::errc::result_out_of_range) value = 0.f;  // denormals/overflow are not worth failing a load
+    else if (ec != std::errc()) return nullptr;
+    return ptr;
+}
+
+inline const char *parseFloats(const char *p, const char *end, float *values, uint32_t count) {
+    for (uint32_t i = 0; i < count && p; i++) p = parseFloat(p, end, values[i]);
+    return p;
+}
+
+inline const char *parseIndex(const char *p, const char *end, int32_t& value) {
+    auto [ptr, ec] = std::from_chars(p, end, value);
+    if (ec != std::errc() || value == 0) return nullptr;
+    return ptr;
+}
+
+// converts a one-based or negative obj index into a zero-based index, negative indices stay chunk relative
+inline int32_t resolveIndex(int32_t index, size_t localCount, uint8_t bit, uint8_t& relativeMask) {
+    if (index > 0) return index - 1;
+    relativeMask |= bit;
+    return static_cast<int32_t>(localCount) + index;
+}
+
+const char *parseFace(const char *p, const char *end, Chunk& chunk) {
+    FaceCorner first{}, prev{};
+    uint32_t count = 0;
+
+    while (true) {
+        p = skipSpaces(p, end);
+        if (p >= end || *p == '\r' || *p == '#') break;
+
+        FaceCorner fc{{ObjParser::MISSING, ObjParser::MISSING, ObjParser::MISSING}, 0};
+        int32_t index;
+
+        // v, v/vt, v//vn, v/vt/vn
+        if (!(p = parseIndex(p, end, index))) return nullptr;
+        fc.corner.position = resolveIndex(index, chunk.positions.size(), 1, fc.relativeMask);
+        if (p < end && *p == '/') {
+            p++;
+            if (p < end && *p != '/') {
+                if (!(p = parseIndex(p, end, index))) return nullptr;
+                fc.corner.uv = resolveIndex(index, chunk.uvs.size(), 2, fc.relativeMask);
+            }
+            if (p < end && *p == '/') {
+                p++;
+                if (!(p = parseIndex(p, end, index))) return nullptr;
+                fc.corner.normal = resolveIndex(index, chunk.normals.size(), 4, fc.relativeMask);
+            }
+        }
+
+        // fan triangulation
+        if (count >= 2) {
+            for (const FaceCorner *c : {&first, &prev, &fc}) {
+                uint32_t cornerIndex = static_cast<uint32_t>(chunk.corners.size());
+                for (uint32_t attribute = 0; attribute < 3; attribute++)
+                    if (c->relativeMask & (1 << attribute)) chunk.relativeIndices.push_back(cornerIndex * 3 + attribute);
+                chunk.corners.push_back(c->corner);
+            }
+        }
+        if (count == 0) first = fc;
+        prev = fc;
+        count++;
+    }
+
+    return count >= 3 ? p : nullptr;
+}
+
+void parseChunk(Chunk& chunk) {
+    const char *p = chunk.begin;
+    const char *end = chunk.end;
+
+    while (p < end) {
+        const char *lineEnd = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        if (!lineEnd) lineEnd = end;
+
+        const char *c = skipSpaces(p, lineEnd);
+        const char *ok = c;
+        if (lineEnd - c >= 2 && c[0] == 'v' && isSpace(c[1])) {  // position
+            float v[3];
+            ok = parseFloats(c + 2, lineEnd, v, 3);
+            if (ok) chunk.positions.emplace_back(v[0], v[1], v[2]);
+        } else if (lineEnd - c >= 3 && c[0] == 'v' && c[1] == 't' && isSpace(c[2])) {  // uv, v is optional
+            glm::vec2 vt(0.f);
+            ok = parseFloat(c + 3, lineEnd, vt.x);
+            if (ok) {
+                const char *next = skipSpaces(ok, lineEnd);
+                if (next < lineEnd && *next != '\r') ok = parseFloat(next, lineEnd, vt.y);
+            }
+            if (ok) chunk.uvs.push_back(vt);
+        } else if (lineEnd - c >= 3 && c[0] == 'v' && c[1] == 'n' && isSpace(c[2])) {  // normal
+            float vn[3];
+            ok = parseFloats(c + 3, lineEnd, vn, 3);
+            if (ok) chunk.normals.emplace_back(vn[0], vn[1], vn[2]);
+        } else if (lineEnd - c >= 2 && c[0] == 'f' && isSpace(c[1])) {  // face
+            ok = parseFace(c + 2, lineEnd, chunk);
+        }  // everything else (comments, groups, materials, smoothing) is ignored
+
+        if (!ok) {
+            chunk.error = std::format("malformed record: '{}'", std::string_view(c, lineEnd - c));
+            return;
+        }
+
+        p = lineEnd + 1;
+    }
+}
+
+template <typename Function>
+void forEachChunk(std::vector<Chunk>& chunks, Function&& function) {
+    if (chunks.size() == 1) {
+        function(chunks[0], 0);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(chunks.size());
+    for (size_t i = 0; i < chunks.size(); i++) workers.emplace_back([&, i]() { function(chunks[i], i); });
+    for (auto& worker : workers) worker.join();
+}
+
+}  // namespace
+
+void ObjParser::parse(const std::string& path, Result& out, uint32_t threadCount) {
+    MappedFile file(path);
+    if (!file.isOpen()) throw std::runtime_error(std::format("Failed to open the obj file: '{}'", path));
+
+    try {
+        parse(reinterpret_cast<const char *>(file.data()), file.size(), out, threadCount);
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error(std::format("{}: {}", path, e.what()));
+    }
+}
+
+void ObjParser::parse(const char *data, size_t size, Result& out, uint32_t threadCount) {
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    const size_t chunkCount = std::clamp<size_t>(size / MIN_CHUNK_SIZE, 1, threadCount);
+
+    // split into line-aligned chunks
+    std::vector<Chunk> chunks(chunkCount);
+    const char *end = data + size;
+    const char *p = data;
+    for (size_t i = 0; i < chunkCount; i++) {
+        const char *chunkEnd = i + 1 == chunkCount ? end : std::max(p, data + size * (i + 1) / chunkCount);
+        if (chunkEnd < end) {
+            const char *newline = static_cast<const char *>(std::memchr(chunkEnd, '\n', end - chunkEnd));
+            chunkEnd = newline ? newline + 1 : end;
+        }
+        chunks[i].begin = p;
+        chunks[i].end = chunkEnd;
+        p = chunkEnd;
+    }
+
+    // parse
+    forEachChunk(chunks, [](Chunk& chunk, size_t) { parseChunk(chunk); });
+    for (const auto& chunk : chunks)
+        if (!chunk.error.empty()) throw std::runtime_error(chunk.error);
+
+    // prefix sum over the per-chunk record counts
+    struct Offsets {
+        size_t positions = 0, uvs = 0, normals = 0, corners = 0;
+    };
+    std::vector<Offsets> offsets(chunkCount + 1);
+    for (size_t i = 0; i < chunkCount; i++) {
+        offsets[i + 1].positions = offsets[i].positions + chunks[i].positions.size();
+        offsets[i + 1].uvs = offsets[i].uvs + chunks[i].uvs.size();
+        offsets[i + 1].normals = offsets[i].normals + chunks[i].normals.size();
+        offsets[i + 1].corners = offsets[i].corners + chunks[i].corners.size();
+    }
+    const Offsets& total = offsets[chunkCount];
+
+    out.positions.resize(total.positions);
+    out.uvs.resize(total.uvs);
+    out.normals.resize(total.normals);
+    out.corners.resize(total.corners);
+
+    // merge, resolve chunk relative indices and validate
+    forEachChunk(chunks, [&](Chunk& chunk, size_t i) {
+        const Offsets& base = offsets[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), out.positions.begin() + base.positions);
+        std::copy(chunk.uvs.begin(), chunk.uvs.end(), out.uvs.begin() + base.uvs);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), out.normals.begin() + base.normals);
+
+        Corner *corners = out.corners.data() + base.corners;
+        std::copy(chunk.corners.begin(), chunk.corners.end(), corners);
+        for (uint32_t relative : chunk.relativeIndices) {
+            Corner& corner = corners[relative / 3];
+            switch (relative % 3) {
+                case 0: corner.position += static_cast<int32_t>(base.positions); break;
+                case 1: corner.uv += static_cast<int32_t>(base.uvs); break;
+                case 2: corner.normal += static_cast<int32_t>(base.normals); break;
+            }
+        }
+
+        for (size_t c = 0; c < chunk.corners.size(); c++) {
+            const Corner& corner = corners[c];
+            if (corner.position < 0 || corner.position >= static_cast<int64_t>(total.positions) ||
+                corner.uv < MISSING || corner.uv >= static_cast<int64_t>(total.uvs) || corner.normal < MISSING ||
+                corner.normal >= static_cast<int64_t>(total.normals)) {
+                chunk.error = std::format("face index out of range (triangle {})", (base.corners + c) / 3);
+                break;
+            }
+        }
+
+        // release the chunk memory early, the merged copy is all that is needed
+        std::string error = std::move(chunk.error);
+        chunk = Chunk{};
+        chunk.error = std::move(error);
+    });
+    for (const auto& chunk : chunks)
+        if (!chunk.error.empty()) throw std::runtime_error(chunk.error);
+}
+
+}  // namespace gpro
@@ -0,0 +1,56 @@
+#include "gpro/pass_profiler.hpp"
+
+namespace gpro {
+
+tga::CommandBuffer PassProfiler::beginFrame(uint64_t frameIndex, tga::CommandBuffer cmdBuffer) {
+    m_isProfiling = m_interval > 0 && (frameIndex + 1) % m_interval == 0;  // not the first frame
+    m_passIndex = 0;
+    if (!m_isProfiling) return cmdBuffer;
+    return m_passes.empty() ? tga::CommandBuffer{} : m_passes.front().cmdBuffer;
+}
+
+void PassProfiler::endPass(const char *name, std::optional<tga::CommandRecorder>& cmdRecorder, bool isLastPass) {
+    if (!m_isProfiling) return;
+
+    // the passes of a frame are the same every frame, new ones are added on the first profiled frame
+    if (m_passIndex == m_passes.size()) m_passes.push_back({name});
+    Pass& pass = m_passes[m_passIndex++];
+    pass.cmdBuffer = cmdRecorder->endRecording();
+
+    const auto ts = std::chrono::steady_clock::now();
+    tgai.execute(pass.cmdBuffer);
+    tgai.waitForCompletion(pass.cmdBuffer);
+    pass.samples[m_profiledCount % HISTORY_LENGTH] =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
+
+    if (isLastPass) {
+        m_profiledCount++;
+        return;
+    }
+    cmdRecorder.emplace(tgai, m_passIndex < m_passes.size() ? m_passes[m_passIndex].cmdBuffer : tga::CommandBuffer{});
+}
+
+void PassProfiler::print() const {
+    if (m_profiledCount == 0) return;
+
+    const uint64_t sampleCount = std::min<uint64_t>(m_profiledCount, HISTORY_LENGTH);
+    const uint64_t last = (m_profiledCount - 1) % HISTORY_LENGTH;
+    double totalMs = 0;
+    for (const Pass& pass : m_passes) totalMs += pass.samples[last];
+
+    std::cout << std::format("Cpu-observed pass latency (execute to completion, one submission per pass, every {0} "
+                             "frames, not a gpu query): {1:.3f} ms, over the last {2} profiled frames:\n",
+                             m_interval, totalMs, sampleCount);
+    for (const Pass& pass : m_passes) {
+        double sum = 0, mn = std::numeric_limits<double>::max(), mx = 0;
+        for (uint64_t i = 0; i < sampleCount; i++) {
+            sum += pass.samples[i];
+            mn = std::min(mn, pass.samples[i]);
+            mx = std::max(mx, pass.samples[i]);
+        }
+        std::cout << std::format("    {0:<18} {1:7.3f} ms (avg {2:.3f}, min {3:.3f}, max {4:.3f})\n", pass.name,
+                                 pass.samples[last], sum / sampleCount, mn, mx);
+    }
+}
+
+}  // namespace gpro
@@ -1,13 +1,35 @@
 #include "gpro/renderer.hpp"
 
+#include <random>
+
 #include "gpro/application.hpp"
+#include "gpro/cpu_profiler.hpp"
+#include "gpro/frustum_culler.hpp"
 #include "gpro/utils.hpp"
 
-#define MAX_BATCH_SIZE 10000000
+#define LOD_ERROR_PIXELS 1.0f  // largest projected lod error (in pixels) before a finer lod is picked
+
+#ifndef GPRO_STAGING_COPY_THREADS
+#define GPRO_STAGING_COPY_THREADS 2  // threads that copy a frame's uploads, the render thread included (0: hardware)
+#endif
 
 #define INPUTSET_INDEX_CAM_AND_LIGHT 0     // (s:0, b:0,1) camera + lights
 #define INPUTSET_INDEX_DIFFUSE_MAPS 1      // (s:1, b:0)   diffuse maps
-#define INPUTSET_INDEX_MODELS 2  // (s:2, b:0,1) model matrices + aabbs
+#define INPUTSET_INDEX_MODELS 2  // (s:2, b:0..4) model matrices + instance id maps + aabbs + visible instances
+
+#ifdef GPRO_VIRTUAL_TEXTURES
+#define FRAGMENT_SHADER_NAME "indirect_phong_virtual_frag.spv"
+#else
+#define FRAGMENT_SHADER_NAME "indirect_phong_frag.spv"
+#endif
+
+#ifdef GPRO_COMPACT_VERTICES
+#define VERTEX_SHADER_NAME "indirect_phong_compact_vert.spv"
+#define VERTEX_LAYOUT gpro::Mesh::getCompactVertexLayout()
+#else
+#define VERTEX_SHADER_NAME "indirect_phong_vert.spv"
+#define VERTEX_LAYOUT gpro::Mesh::getVertexLayout()
+#endif
 
 namespace gpro {
 
@@ -24,14 +46,189 @@ Renderer::Renderer() {
 }
 
 void Renderer::init() {
-    m_batchesCPU.resize(1);
+    m_vertexShader = tga::loadShader(gpro::shaderPath(VERTEX_SHADER_NAME), tga::ShaderType::vertex, tgai);
+    m_fragmentShader = tga::loadShader(gpro::shaderPath(FRAGMENT_SHADER_NAME), tga::ShaderType::fragment, tgai);
+    m_instanceCullingComputeShader = tga::loadShader(gpro::shaderPath("instance_culling_comp.spv"), tga::ShaderType::compute, tgai);
+    m_visibleListComputeShader = tga::loadShader(gpro::shaderPath("visible_lists_comp.spv"), tga::ShaderType::compute, tgai);
+    m_clusterCullingComputeShader = tga::loadShader(gpro::shaderPath("cluster_culling_comp.spv"), tga::ShaderType::compute, tgai);
+    m_resetCullingComputeShader = tga::loadShader(gpro::shaderPath("reset_culling_comp.spv"), tga::ShaderType::compute, tgai);
+    m_depthPyramidComputeShader = tga::loadShader(gpro::shaderPath("depth_pyramid_comp.spv"), tga::ShaderType::compute, tgai);
+
+    // workers for the staging copies of recordUploads, none if the render thread copies alone. the copies are bound by
+    // memory bandwidth, more threads only compete with the loader pool and the obj parser
+    const uint32_t stagingCopyThreadCount = GPRO_STAGING_COPY_THREADS > 0
+                                                ? GPRO_STAGING_COPY_THREADS
+                                                : std::max(1u, std::thread::hardware_concurrency());
+    if (stagingCopyThreadCount > 1) m_stagingCopyPool = std::make_unique<ThreadPool>(stagingCopyThreadCount - 1);
+
+    for (auto& frame : m_frames) frame.cullingStatsStaging = tgai.createStagingBuffer({sizeof(CullingStats)});
+    m_cullingStatsBuffer = tgai.createBuffer({tga::BufferUsage::storage, sizeof(CullingStats)});
+
+    // depth pyramid, levels from half resolution down to 1x1
+    const uint32_t width = Application::get().width();
+    const uint32_t height = Application::get().height();
+    uint32_t pyramidLevelCount = 0;
+    size_t pyramidSize = 0;
+    for (uint32_t w = width, h = height; w > 1 || h > 1; pyramidLevelCount++) {
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+        pyramidSize += size_t(w) * h;
+    }
+#ifdef GPRO_OCCLUSION_CULLING
+    DepthCopyHeader depthCopyHeader{width, 1};
+#else
+    DepthCopyHeader depthCopyHeader{width, 0};
+#endif
+    m_depthCopyBuffer =
+        util::createBuffer(tga::BufferUsage::storage, sizeof(DepthCopyHeader) + size_t(width) * height * sizeof(float),
+                           toui8(std::addressof(depthCopyHeader)), sizeof(DepthCopyHeader));
+    m_depthPyramidBuffer =
+        tgai.createBuffer({tga::BufferUsage::storage, std::max<size_t>(pyramidSize, 1) * sizeof(float)});
+    DepthPyramidParams depthPyramidParams{width, height, pyramidLevelCount, 0};
+    m_depthPyramidParamsBuffer =
+        gpro::util::createUniformBuffer(sizeof(DepthPyramidParams), toui8(std::addressof(depthPyramidParams)));
+
+    // object space error * lodErrorScale / view distance = projected error relative to LOD_ERROR_PIXELS
+#ifdef GPRO_OCCLUSION_CULLING
+    const uint32_t firstCullingPhase = 1;
+#else
+    const uint32_t firstCullingPhase = 0;
+#endif
+    m_cullingParams = {
+        height * 0.5f / LOD_ERROR_PIXELS, 0, 0, firstCullingPhase, width, height, pyramidLevelCount, 0, 0};
+    m_cullingParamsBuffer =
+        gpro::util::createUniformBuffer(sizeof(CullingParams), toui8(std::addressof(m_cullingParams)));
+    m_occlusionCullingParamsBuffer =
+        gpro::util::createUniformBuffer(sizeof(CullingParams), toui8(std::addressof(m_cullingParams)));
+
+    // reset, culling and depth pyramid passes. the culling input sets are recreated with the buffers, phase 2 of the
+    // occlusion culling has its own
+    const tga::InputLayout inputLayoutResetCullingPass{{
+        // S0
+        {tga::BindingType::storageBuffer},  // B0 diicmds
+        {tga::BindingType::uniformBuffer},  // B1 culling params
+        {tga::BindingType::storageBuffer},  // B2 occlusion diicmds
+        {tga::BindingType::storageBuffer},  // B3 depth copy
+        {tga::BindingType::storageBuffer},  // B4 culling counters
+        {tga::BindingType::storageBuffer},  // B5 occlusion culling counters
+    }};
+    const tga::InputLayout inputLayoutInstanceCullingPass{{
+        // S0
+        {tga::BindingType::storageBuffer},  // B0 models
+        {tga::BindingType::uniformBuffer},  // B1 camera VP
+        {tga::BindingType::uniformBuffer},  // B2 frustum planes
+        {tga::BindingType::uniformBuffer},  // B3 culling params
+        {tga::BindingType::storageBuffer},  // B4 instance id to mesh id map
+        {tga::BindingType::storageBuffer},  // B5 mesh lods
+        {tga::BindingType::storageBuffer},  // B6 aabbs
+        {tga::BindingType::storageBuffer},  // B7 instance visibility
+        {tga::BindingType::storageBuffer},  // B8 depth pyramid
+        {tga::BindingType::storageBuffer},  // B9 culling stats
+        {tga::BindingType::storageBuffer},  // B10 culling counters
+        {tga::BindingType::storageBuffer},  // B11 survivors
+    }};
+    const tga::InputLayout inputLayoutVisibleListPass{{
+        // S0
+        {tga::BindingType::uniformBuffer},  // B0 culling params
+        {tga::BindingType::storageBuffer},  // B1 draw infos
+        {tga::BindingType::storageBuffer},  // B2 meshlets
+        {tga::BindingType::storageBuffer},  // B3 culling counters
+        {tga::BindingType::storageBuffer},  // B4 diicmds
+    }};
+    const tga::InputLayout inputLayoutClusterCullingPass{{
+        // S0
+        {tga::BindingType::storageBuffer},  // B0 models
+        {tga::BindingType::uniformBuffer},  // B1 camera VP
+        {tga::BindingType::uniformBuffer},  // B2 frustum planes
+        {tga::BindingType::uniformBuffer},  // B3 culling params
+        {tga::BindingType::storageBuffer},  // B4 instance id to mesh id map
+        {tga::BindingType::storageBuffer},  // B5 mesh lods
+        {tga::BindingType::storageBuffer},  // B6 meshlets
+        {tga::BindingType::storageBuffer},  // B7 draw infos
+        {tga::BindingType::storageBuffer},  // B8 instance visibility
+        {tga::BindingType::storageBuffer},  // B9 depth pyramid
+        {tga::BindingType::storageBuffer},  // B10 culling stats
+        {tga::BindingType::storageBuffer},  // B11 culling counters
+        {tga::BindingType::storageBuffer},  // B12 survivors
+        {tga::BindingType::storageBuffer},  // B13 diicmds
+        {tga::BindingType::storageBuffer},  // B14 visible instance ids
+    }};
+    const tga::InputLayout inputLayoutDepthPyramidPass{{
+        // S0
+        {tga::BindingType::storageBuffer},  // B0 depth copy
+        {tga::BindingType::storageBuffer},  // B1 depth pyramid
+        {tga::BindingType::uniformBuffer},  // B2 depth pyramid params
+    }};
+
+    m_resetCullingPass = tgai.createComputePass({m_resetCullingComputeShader, inputLayoutResetCullingPass});
+    m_instanceCullingPass = tgai.createComputePass({m_instanceCullingComputeShader, inputLayoutInstanceCullingPass});
+    m_visibleListPass = tgai.createComputePass({m_visibleListComputeShader, inputLayoutVisibleListPass});
+    m_clusterCullingPass = tgai.createComputePass({m_clusterCullingComputeShader, inputLayoutClusterCullingPass});
+    m_depthPyramidPass = tgai.createComputePass({m_depthPyramidComputeShader, inputLayoutDepthPyramidPass});
+    m_depthPyramidPassInputSet = tgai.createInputSet(
+        {m_depthPyramidPass, {{m_depthCopyBuffer, 0}, {m_depthPyramidBuffer, 1}, {m_depthPyramidParamsBuffer, 2}}, 0});
 
-    m_vertexShader = tga::loadShader(gpro::shaderPath("indirect_phong_vert.spv"), tga::ShaderType::vertex, tgai);
-    m_fragmentShader = tga::loadShader(gpro::shaderPath("indirect_phong_frag.spv"), tga::ShaderType::fragment, tgai);
-    m_frustumCullingComputeShader = tga::loadShader(gpro::shaderPath("frustum_culling_comp.spv"), tga::ShaderType::compute, tgai);
+    // forward render pass. the diffuse map array has a fixed size, so the layout does not depend on the scene
+    const tga::InputLayout inputLayoutForwardPass{
+        {
+            // S0
+            {tga::BindingType::uniformBuffer},  // B0: VP
+            {tga::BindingType::uniformBuffer},  // B1: frustum
+            {tga::BindingType::uniformBuffer},  // B2: lights
+            {tga::BindingType::uniformBuffer},  // B3: time
+            {tga::BindingType::storageBuffer},  // B4: depth copy
+            {tga::BindingType::storageBuffer},  // B5: culling stats (fragment count)
+        },
+        {
+            // S1
+#ifdef GPRO_VIRTUAL_TEXTURES
+            {tga::BindingType::storageBuffer},  // B0: virtual textures
+            {tga::BindingType::storageBuffer},  // B1: page table
+            {tga::BindingType::storageBuffer},  // B2: physical pages
+            {tga::BindingType::storageBuffer},  // B3: feedback
+            {tga::BindingType::uniformBuffer},  // B4: frame stamp
+#else
+            {tga::BindingType::sampler, TextureRegistry::MAX_TEXTURE_COUNT}  // B0: diffuse maps
+#endif
+        },
+        {
+            // S2
+            {tga::BindingType::storageBuffer},  // B0: models
+            {tga::BindingType::storageBuffer},  // B1: instance id to mesh id map
+            {tga::BindingType::storageBuffer},  // B2: aabbs (compact vertex dequantization)
+            {tga::BindingType::storageBuffer},  // B3: instance id to texture id map
+            {tga::BindingType::storageBuffer},  // B4: visible instance ids
+        },
+    };
 
-    m_visibleObjectCountStaging = tgai.createStagingBuffer({sizeof(uint32_t)});
-    m_visibleObjectCountBuffer = tgai.createBuffer({tga::BufferUsage::storage, sizeof(uint32_t)});
+    m_renderPass = tgai.createRenderPass(tga::RenderPassInfo{
+        m_vertexShader,
+        m_fragmentShader,
+        Application::get().window(),
+        {},
+        inputLayoutForwardPass,
+        {tga::ClearOperation::all},
+        {tga::CompareOperation::less},
+        {tga::FrontFace::counterclockwise,
+         tga::CullMode::back}}.setVertexLayout(VERTEX_LAYOUT));
+
+    // occlusion culling phase 2, draws over the first pass. both passes have the same layout and share input sets
+    m_occlusionRenderPass = tgai.createRenderPass(tga::RenderPassInfo{
+        m_vertexShader,
+        m_fragmentShader,
+        Application::get().window(),
+        {},
+        inputLayoutForwardPass,
+        {tga::ClearOperation::none},
+        {tga::CompareOperation::less},
+        {tga::FrontFace::counterclockwise,
+         tga::CullMode::back}}.setVertexLayout(VERTEX_LAYOUT));
+
+#ifdef GPRO_VIRTUAL_TEXTURES
+    m_virtualTextures.init();
+#else
+    m_textureRegistry.init();
+#endif
 }
 
 void Renderer::initCameraData(std::shared_ptr<CameraController>& camera) {
@@ -42,8 +239,127 @@ void Renderer::initCameraData(std::shared_ptr<CameraController>& camera) {
     // camera frustum
     m_frustumStage = camera->getFrustumData();
     m_frustumBuffer = tgai.createBuffer({tga::BufferUsage::uniform, sizeof(Frustum), m_frustumStage});
+
+#ifdef GPRO_VALIDATE_CULLING
+    _validateFrustumCulling(camera->Position());
+#endif
 }
 
+#ifdef GPRO_VALIDATE_CULLING
+void Renderer::_validateFrustumCulling(const glm::vec3& eye) {
+    constexpr uint32_t instanceCount = 1 << 20;
+    const FrustumCuller culler(*static_cast<const Frustum *>(tgai.getMapping(m_frustumStage)));
+
+    // random spheres and boxes around the camera, many of them crossing a frustum plane
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> offset(-200.f, 200.f), size(0.1f, 20.f);
+    std::vector<glm::vec4> spheres(instanceCount);
+    std::vector<AABB> aabbs(instanceCount, AABB{glm::vec3(0), glm::vec3(0)});
+    for (uint32_t i = 0; i < instanceCount; i++) {
+        const glm::vec3 center = eye + glm::vec3(offset(rng), offset(rng), offset(rng));
+        const glm::vec3 extent(size(rng), size(rng), size(rng));
+        spheres[i] = glm::vec4(center, glm::length(extent));
+        aabbs[i] = AABB{center - extent, center + extent};
+    }
+
+    // cpu, simd and one at a time
+    std::vector<uint8_t> sphereVisibility(instanceCount), aabbVisibility(instanceCount);
+    auto ts = std::chrono::steady_clock::now();
+    const size_t visibleSphereCount = culler.cullSpheres(spheres.data(), instanceCount, sphereVisibility.data());
+    const size_t visibleAABBCount = culler.cullAABBs(aabbs.data(), instanceCount, aabbVisibility.data());
+    const double simdMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
+
+    ts = std::chrono::steady_clock::now();
+    uint32_t scalarMismatchCount = 0;
+    for (uint32_t i = 0; i < instanceCount; i++) {
+        scalarMismatchCount += culler.isSphereVisible(spheres[i]) != bool(sphereVisibility[i]);
+        scalarMismatchCount += culler.isAABBVisible(aabbs[i]) != bool(aabbVisibility[i]);
+    }
+    const double scalarMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
+
+    // gpu, the plane tests of the culling pass
+    const size_t visibilitySize = size_t(instanceCount) * sizeof(uint32_t);
+    const tga::Shader shader =
+        tga::loadShader(gpro::shaderPath("culling_validation_comp.spv"), tga::ShaderType::compute, tgai);
+    const tga::InputLayout inputLayout{{
+        // S0
+        {tga::BindingType::uniformBuffer},  // B0 frustum planes
+        {tga::BindingType::storageBuffer},  // B1 spheres
+        {tga::BindingType::storageBuffer},  // B2 aabbs
+        {tga::BindingType::storageBuffer},  // B3 visibility
+        {tga::BindingType::uniformBuffer},  // B4 instance count
+    }};
+    const tga::ComputePass pass = tgai.createComputePass({shader, inputLayout});
+    const tga::Buffer sphereBuffer = util::createBuffer(tga::BufferUsage::storage, spheres.size() * sizeof(glm::vec4),
+                                                        toui8(spheres.data()));
+    const tga::Buffer aabbBuffer =
+        util::createBuffer(tga::BufferUsage::storage, aabbs.size() * sizeof(AABB), toui8(aabbs.data()));
+    const tga::Buffer visibilityBuffer = tgai.createBuffer({tga::BufferUsage::storage, visibilitySize});
+    uint32_t count = instanceCount;
+    const tga::Buffer paramsBuffer = util::createUniformBuffer(sizeof(uint32_t), toui8(std::addressof(count)));
+    const tga::InputSet inputSet = tgai.createInputSet(
+        {pass,
+         {{m_frustumBuffer, 0}, {sphereBuffer, 1}, {aabbBuffer, 2}, {visibilityBuffer, 3}, {paramsBuffer, 4}},
+         0});
+    const tga::StagingBuffer staging = tgai.createStagingBuffer({visibilitySize});
+
+    ts = std::chrono::steady_clock::now();
+    tga::CommandBuffer cmdBuffer = tga::CommandRecorder{tgai}
+                                       .setComputePass(pass)
+                                       .bindInputSet(inputSet)
+                                       .dispatch((instanceCount + 63) / 64, 1, 1)
+                                       .barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::Transfer)
+                                       .bufferDownload(visibilityBuffer, staging, visibilitySize)
+                                       .endRecording();
+    tgai.execute(cmdBuffer);
+    tgai.waitForCompletion(cmdBuffer);
+    const double gpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
+
+    // the gpu may round differently, a mismatch is only an error if it does not flip with a slightly smaller or
+    // larger primitive
+    const uint32_t *gpuVisibility = static_cast<const uint32_t *>(tgai.getMapping(staging));
+    auto isBorderline = [&](uint32_t i, bool isSphere) {
+        constexpr float epsilon = 1e-3f;
+        if (isSphere) {
+            const glm::vec4& sphere = spheres[i];
+            return culler.isSphereVisible({glm::vec3(sphere), sphere.w + epsilon}) !=
+                   culler.isSphereVisible({glm::vec3(sphere), std::max(sphere.w - epsilon, 0.f)});
+        }
+        const AABB& aabb = aabbs[i];
+        return culler.isAABBVisible({aabb.mn - glm::vec3(epsilon), aabb.mx + glm::vec3(epsilon)}) !=
+               culler.isAABBVisible({aabb.mn + glm::vec3(epsilon), aabb.mx - glm::vec3(epsilon)});
+    };
+    uint32_t gpuMismatchCount = 0, borderlineCount = 0;
+    for (uint32_t i = 0; i < instanceCount; i++) {
+        for (bool isSphere : {true, false}) {
+            const bool isCPUVisible = isSphere ? sphereVisibility[i] : aabbVisibility[i];
+            const bool isGPUVisible = gpuVisibility[i] & (isSphere ? 1 : 2);
+            if (isCPUVisible == isGPUVisible) continue;
+            if (isBorderline(i, isSphere))
+                borderlineCount++;
+            else
+                gpuMismatchCount++;
+        }
+    }
+
+    std::cout << std::format("Culling validation ({0} instances): visible spheres {1}, boxes {2}. cpu {3}: {4:.2f} ms, "
+                             "scalar: {5:.2f} ms ({6} mismatches), gpu: {7:.2f} ms with download ({8} mismatches, "
+                             "{9} borderline)\n",
+                             instanceCount, visibleSphereCount, visibleAABBCount, FrustumCuller::simdName(), simdMs,
+                             scalarMs, scalarMismatchCount, gpuMs, gpuMismatchCount, borderlineCount);
+
+    tgai.free(cmdBuffer);
+    tgai.free(staging);
+    tgai.free(inputSet);
+    tgai.free(paramsBuffer);
+    tgai.free(visibilityBuffer);
+    tgai.free(aabbBuffer);
+    tgai.free(sphereBuffer);
+    tgai.free(pass);
+    tgai.free(shader);
+}
+#endif
+
 void Renderer::initLights(std::vector<Light>& lights) {
     m_lightsBuffer = gpro::util::createUniformBuffer(sizeof(Light) * lights.size(), toui8(lights.data()));
 }
@@ -52,234 +368,669 @@ void Renderer::initTime(float time) {
     m_timeBuffer = gpro::util::createUniformBuffer(sizeof(float), toui8(std::addressof(time)));
 }
 
-void Renderer::batch(const SceneObject& so) {
-    auto& batchCPU = m_batchesCPU[m_batchesCPU.size() - 1];
+void Renderer::batch(const SceneObject& so) { m_batchedObjects.push_back(_batch(so)); }
 
-    // get data size (TODO: consider to use index count instead)
-    uint32_t byte = so.mesh.vertices.size() * sizeof(Vertex) + so.mesh.indices.size() * sizeof(IndexFormat);
+void Renderer::replace(uint32_t objectIndex, const SceneObject& so) {
+    // the new ranges are allocated first, so none of them reuses the old ones in this frame
+    BatchedObjectData object = _batch(so);
+    _freeObject(m_batchedObjects[objectIndex]);
+    m_batchedObjects[objectIndex] = object;
+}
 
-    if (byte + batchCPU.byte > MAX_BATCH_SIZE) {
-        _flushBatch(true);
-    }
+Renderer::BatchedObjectData Renderer::_batch(const SceneObject& so) {
+    BatchedObjectData object{};
+    object.diffuseMapID = so.diffuseMapID;
+    object.instanceCount = so.instanceCount;
+    object.triangleCount = so.mesh.lods.empty() ? 0 : so.mesh.lods[0].indexCount / 3;
+    const std::span<const Vertex> vertices = so.mesh.vertexData();  // may point into a mapped cache entry
+    const std::span<const IndexFormat> indices = so.mesh.indexData();
 
-    /// continue to fill current batch (on cpu)
     // vertices
-    batchCPU.vertices.insert(batchCPU.vertices.end(), so.mesh.vertices.begin(), so.mesh.vertices.end());
+    object.vertices = m_vertexPool.allocate(vertices.size());
+#ifdef GPRO_COMPACT_VERTICES
+    if (!so.mesh.compactVertices.empty()) {  // decoded from a compressed cache entry, already in the gpu layout
+        m_vertices.write(object.vertices.offset, so.mesh.compactVertices.data(), object.vertices.count);
+    } else {
+        std::vector<CompactVertex> compactVertices;
+        util::quantizeVertices(vertices, so.boundingBox.mn, so.boundingBox.mx, compactVertices);
+        m_vertices.write(object.vertices.offset, compactVertices.data(), object.vertices.count);
+    }
+#else
+    m_vertices.write(object.vertices.offset, vertices.data(), object.vertices.count);
+#endif
+    m_maxMeshVertexCount = std::max<uint32_t>(m_maxMeshVertexCount, vertices.size());
 
-    // indices
-    batchCPU.indices.insert(batchCPU.indices.end(), so.mesh.indices.begin(), so.mesh.indices.end());
+    // indices, relative to the mesh (diicmd vertex offset)
+    object.indices = m_indexPool.allocate(indices.size());
+    m_indices.write(object.indices.offset, indices.data(), object.indices.count);
 
-    // transform
-    m_models.insert(m_models.end(), so.transforms.begin(), so.transforms.end());
+    // aabb (also the dequantization range of compact vertices)
+    object.meshID = m_meshPool.allocate(1).offset;
+    m_aabbs.write(object.meshID, &so.boundingBox, 1);
 
-    // aabb
-    m_aabbs.emplace_back(so.boundingBox);
+    // meshlets
+    object.meshlets = m_meshletPool.allocate(so.mesh.meshlets.size());
+    m_meshlets.write(object.meshlets.offset, so.mesh.meshlets.data(), object.meshlets.count);
 
-    // draw indexed indirect command
-    //m_diicmds.emplace_back(so.mesh.indices.size(), so.instanceCount, batchCPU.indexOffset, batchCPU.vertexOffset, batchCPU.instanceCount);
-    for(int _ = 0; _ < so.instanceCount; _++) // TODO: remove this to use per mesh diicmd. Current approach makes 1 diicmd per instance 
-    {
-        m_diicmds.emplace_back(so.mesh.indices.size(), 1, batchCPU.indexOffset, batchCPU.vertexOffset, batchCPU.instanceCount + _);
-        m_instanceIDToMeshIDMap.push_back(batchCPU.size);
+    // instances, not visible last frame, so phase 2 of the occlusion culling decides
+    object.instances = m_instancePool.allocate(so.instanceCount);
+    m_models.write(object.instances.offset, so.transforms.data(), object.instances.count);
+    m_instanceIDToMeshIDMap.fill(object.instances.offset, object.instances.count, object.meshID);
+    m_instanceIDToTextureIDMap.fill(object.instances.offset, object.instances.count, so.diffuseMapID);
+    m_instanceVisibility.fill(object.instances.offset, object.instances.count, 0);
+
+    // draw indexed indirect commands, one per meshlet of every lod. the culling passes list the instances that picked
+    // the meshlet's lod and see it
+    object.draws = m_drawPool.allocate(object.meshlets.count);
+    _createDraws(object);
+
+    // lods, with the draws of their meshlets
+    MeshLODs meshLODs{};
+    meshLODs.center = (so.boundingBox.mn + so.boundingBox.mx) * 0.5f;
+    meshLODs.radius = glm::length(so.boundingBox.mx - so.boundingBox.mn) * 0.5f;
+    meshLODs.lodCount = std::min<uint32_t>(so.mesh.lods.size(), MeshOptimizer::MAX_LOD_COUNT);
+    meshLODs.drawOffset = object.draws.offset;
+    for (uint32_t i = 0; i < meshLODs.lodCount; i++) {
+        meshLODs.errors[i] = so.mesh.lods[i].error;
+        meshLODs.meshletOffsets[i] = so.mesh.lods[i].meshletOffset;
+        meshLODs.meshletCounts[i] = so.mesh.lods[i].meshletCount;
+        object.maxLODMeshletCount = std::max(object.maxLODMeshletCount, so.mesh.lods[i].meshletCount);
     }
+    m_meshLODs.write(object.meshID, &meshLODs, 1);
 
-    // increment the offsets
-    batchCPU.vertexOffset += so.mesh.vertices.size();
-    batchCPU.indexOffset += so.mesh.indices.size();
+    m_submittedTriangleCount += uint64_t(so.instanceCount) * object.triangleCount;
+    m_instanceCount += so.instanceCount;
+    m_visibleListSize += uint64_t(so.instanceCount) * object.maxLODMeshletCount;
 
-    // update size and byte
-    batchCPU.byte += byte;
-    batchCPU.size++;
-    batchCPU.instanceCount += so.instanceCount;
+#ifndef GPRO_VIRTUAL_TEXTURES
+    // diffuse map, already in the texture registry
+    m_textureRegistry.retain(so.diffuseMapID);
+#endif
 
-    // diffuse maps
-    batchCPU.diffuseMaps.push_back(so.diffuseMap);
+#ifdef GPRO_VERBOSE
+    std::cout << std::format("Batched a mesh: {0} vertices, {1:.1f} KB vertex data ({2} B/vertex, {3:.1f} KB as floats)\n",
+                             vertices.size(), vertices.size() * sizeof(GPUVertex) / 1024.0, sizeof(GPUVertex),
+                             vertices.size() * sizeof(Vertex) / 1024.0);
+#endif
+    return object;
+}
 
-    _flushBatch(false);
+void Renderer::_freeObject(const BatchedObjectData& object) {
+    // the culling passes skip the freed slots and draws, so the freed draws stay empty until their range is reused.
+    // the frames in flight are ahead of any upload into the reused ranges on the queue
+    m_instanceIDToMeshIDMap.fill(object.instances.offset, object.instances.count, INVALID_MESH_ID);
+    m_drawInfos.fill(object.draws.offset, object.draws.count, DrawInfo{0, INVALID_MESH_ID});
+    m_vertexPool.free(object.vertices);
+    m_indexPool.free(object.indices);
+    m_meshPool.free({object.meshID, 1});
+    m_meshletPool.free(object.meshlets);
+    m_instancePool.free(object.instances);
+    m_drawPool.free(object.draws);
+    m_submittedTriangleCount -= uint64_t(object.instanceCount) * object.triangleCount;
+    m_instanceCount -= object.instanceCount;
+    m_visibleListSize -= uint64_t(object.instanceCount) * object.maxLODMeshletCount;
+
+#ifndef GPRO_VIRTUAL_TEXTURES
+    m_textureRegistry.release(object.diffuseMapID);
+#endif
 }
 
-void Renderer::_flushBatch(bool createNextBatchData) {
-    auto& batchCPU = m_batchesCPU[m_batchesCPU.size() - 1];
-   
-    BatchGPU batch{
-        gpro::util::createVertexBuffer(batchCPU.vertices),              // vertex buffers
-        gpro::util::createIndexBuffer(batchCPU.indices),                // index buffers
-        batchCPU.diffuseMaps,                                           // diffuse maps TODO: do not copy
-        batchCPU.size,                                                  // batch size
-        batchCPU.instanceCount,                                         // total instance count in a batch,
-        0
-    };
+void Renderer::commit() {
+    // free what no frame in flight uses anymore
+    m_releasedInputSets.nextFrame();
 
-    tgai.free(m_modelsBuffer);
-    tgai.free(m_aabbsBuffer);
-    tgai.free(m_diicmdsBuffer);
-    tgai.free(m_instanceIDToMeshIDMapBuffer);
-
-    m_modelsBuffer = gpro::util::createStorageBuffer(sizeof(Transform) * m_models.size(), tga::memoryAccess(m_models));
-    m_aabbsBuffer = gpro::util::createStorageBuffer(sizeof(AABB) * m_aabbs.size(), tga::memoryAccess(m_aabbs));
-    m_diicmdsBuffer = gpro::util::createDrawIndexedIndirectBuffer(m_diicmds);
-    m_instanceIDToMeshIDMapBuffer = gpro::util::createStorageBuffer(sizeof(uint32_t) * m_instanceIDToMeshIDMap.size(), tga::memoryAccess(m_instanceIDToMeshIDMap));
-
-    bool isNewBatch = false;  // true -> new, false -> updated
-    // push the current batch to gpu
-    if (batchCPU.isPushed) {
-        auto& current = m_batchesGPU[m_batchesGPU.size() - 1];
-        tgai.free(current.verticesBuffer);
-        tgai.free(current.indicesBuffer);
-        current = std::move(batch);
-        std::cout << "Updated a pushed batch\n";
-    } else {
-        m_batchesGPU.emplace_back(std::move(batch));
-        batchCPU.isPushed = true;
-        isNewBatch = true;
-        std::cout << "Pushed a batch\n";
+#ifdef GPRO_VERBOSE
+    auto ts = std::chrono::steady_clock::now();
+    const bool hasNewIndices = m_indices.buffer() && m_arena.stats().uploadCount > 0;
+#endif
+
+    // the arena buffers upload their dirty ranges or follow the growth of their pool, the culling buffers grow with
+    // the pools and the visible lists. set 2 and the culling sets only change if a buffer was recreated
+    m_vertices.commit();
+    m_indices.commit();
+    bool isRecreated = false;
+    isRecreated |= m_aabbs.commit();
+    isRecreated |= m_meshLODs.commit();
+    isRecreated |= m_meshlets.commit();
+    isRecreated |= m_models.commit();
+    isRecreated |= m_instanceIDToMeshIDMap.commit();
+    isRecreated |= m_instanceIDToTextureIDMap.commit();
+    isRecreated |= m_instanceVisibility.commit();
+    isRecreated |= m_diicmds.commit();
+    isRecreated |= m_drawInfos.commit();
+    isRecreated |= m_occlusionDiicmds.commit();
+    isRecreated |= _reserveCullingBuffers();
+    if (isRecreated) {
+        _updateRenderPassInputSets();
+        _updateCullingPassInputSets();
+    }
+
+#ifdef GPRO_VERBOSE
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
+
+    // indices are mesh relative (diicmd vertex offset), so 16-bit indices suffice if every mesh has < 65536 vertices.
+    // tga binds index buffers as uint32, so this is reported only
+    if (hasNewIndices && m_maxMeshVertexCount <= std::numeric_limits<uint16_t>::max() + 1u) {
+        std::cout << std::format("16-bit indices possible ({0:.1f} KB -> {1:.1f} KB)\n",
+                                 m_indexPool.size() * sizeof(IndexFormat) / 1024.0,
+                                 m_indexPool.size() * sizeof(uint16_t) / 1024.0);
     }
+    _printArenaStats(ms);
+#endif
 
-    // update the last render pass (or push new one)
-    _updateRenderPass(isNewBatch);
-    _updateFrustumCullingPass();
+    // stats are per frame
+    m_arena.nextFrame();
+    for (ArenaPool *pool : m_pools) pool->resetFrameStats();
+}
 
-    if (!createNextBatchData) return;
+#ifdef GPRO_VERBOSE
+void Renderer::_printArenaStats(double commitMs) {
+    const auto& arenaStats = m_arena.stats();
+    if (arenaStats.uploadCount == 0 && arenaStats.createdBufferCount == 0) return;
 
-    // create new one
-    uint32_t batchIndex = batchCPU.index + 1;
-    m_batchesCPU.emplace_back();
-    m_batchesCPU[m_batchesCPU.size() - 1].index = batchIndex;
+    std::cout << std::format("Arena commit: {0:.1f} KB in {1} uploads, {2} buffers created ({3:.2f} ms)\n",
+                             arenaStats.uploadedBytes / 1024.0, arenaStats.uploadCount, arenaStats.createdBufferCount,
+                             commitMs);
+    for (const ArenaPool *pool : m_pools) {
+        const ArenaPool::Stats stats = pool->stats();
+        std::cout << std::format("    {0}: {1}/{2} used, {3} allocations, {4} frees, {5} free ranges "
+                                 "({6:.1f}% fragmented)\n",
+                                 pool->name(), stats.usedCount, stats.capacity, stats.allocationCount,
+                                 stats.freeCount, stats.freeRangeCount, stats.fragmentation() * 100.f);
+    }
 }
+#endif
 
-void Renderer::render(tga::Window& window) {
-    auto nextFrame = tgai.nextFrame(window);
-    auto cmdRecorder = tga::CommandRecorder{tgai, m_cmdBuffer};
-
-    // frustum culling pass
-    uint32_t* visibleObjectCount = static_cast<uint32_t *>(tgai.getMapping(m_visibleObjectCountStaging));
-    *visibleObjectCount = 0;
-    const uint32_t instanceCount = m_models.size();
-    constexpr auto workGroupSize = 64;
-    auto cmd = tga::CommandRecorder(tgai)
-        .setComputePass(m_frustumCullingPass)
-        .bufferUpload(m_visibleObjectCountStaging, m_visibleObjectCountBuffer, sizeof(uint32_t))
-        .bindInputSet(m_frustumCullingPassInputSet)
-        .dispatch((instanceCount + (workGroupSize - 1)) / workGroupSize, 1, 1)
-        .endRecording();
-    tgai.execute(cmd);
-    tgai.waitForCompletion(cmd);
-
-    auto getResultCmd = tga::CommandRecorder(tgai)
-        .barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::Transfer)
-        .bufferDownload(m_visibleObjectCountBuffer, m_visibleObjectCountStaging, sizeof(uint32_t))
-        .endRecording();
-    tgai.execute(getResultCmd);
-    tgai.waitForCompletion(getResultCmd);
-
-    std::cout << std::format("Visible object count: {0}\n",*visibleObjectCount);
-
-    // update data (TODO: update before culling, currently runs 1 frame behind)
-    cmdRecorder.bufferUpload(m_camStage, m_camBuffer, sizeof(gpro::CamData))
-        .bufferUpload(m_frustumStage, m_frustumBuffer, sizeof(Frustum));
-    
-    // forward render pass
-    for (int i = 0; i < m_renderPasses.size(); i++) {
-        cmdRecorder
-            .setRenderPass(m_renderPasses[i], nextFrame, {0, 0, 0, 1})
-            .bindVertexBuffer(m_batchesGPU[i].verticesBuffer)
-            .bindIndexBuffer(m_batchesGPU[i].indicesBuffer)
-            .bindInputSet(m_inputSets[i][INPUTSET_INDEX_CAM_AND_LIGHT])             // camera + lights
-            .bindInputSet(m_inputSets[i][INPUTSET_INDEX_DIFFUSE_MAPS])              // diffuse maps
-            .bindInputSet(m_inputSets[i][INPUTSET_INDEX_MODELS])                    // model + aabbs
-            .drawIndexedIndirect(m_diicmdsBuffer, m_batchesGPU[i].instanceCount);
+void Renderer::updateInstances(uint32_t objectIndex, const std::vector<Transform>& transforms) {
+    BatchedObjectData& object = m_batchedObjects[objectIndex];
+    const uint32_t instanceCount = transforms.size();
+    if (instanceCount > object.instances.count)
+        _growInstances(object, std::max(instanceCount, object.instances.count * 2));
+
+    // one range from the first to the last changed transform, added instances included
+    Transform *models = m_models.data(object.instances.offset);
+    const uint32_t keptCount = std::min(instanceCount, object.instanceCount);
+    uint32_t first = 0;
+    while (first < keptCount && models[first].transform == transforms[first].transform) first++;
+    uint32_t last = instanceCount;
+    if (instanceCount == keptCount) {
+        while (last > first && models[last - 1].transform == transforms[last - 1].transform) last--;
+    }
+    if (first < last) {
+        std::copy(transforms.begin() + first, transforms.begin() + last, models + first);
+        m_models.markDirty(object.instances.offset + first, last - first);
     }
 
-    m_cmdBuffer = cmdRecorder.endRecording();
-    tgai.execute(m_cmdBuffer);
-    tgai.present(window, nextFrame);
+    // slots that were added or removed, the culling passes skip the free ones
+    const uint32_t changedSlotCount = std::max(instanceCount, object.instanceCount) - keptCount;
+    m_instanceIDToMeshIDMap.fill(object.instances.offset + keptCount, changedSlotCount,
+                                 instanceCount > object.instanceCount ? object.meshID : INVALID_MESH_ID);
+    m_instanceVisibility.fill(object.instances.offset + keptCount, changedSlotCount, 0);
+
+    m_submittedTriangleCount -= uint64_t(object.instanceCount) * object.triangleCount;
+    m_submittedTriangleCount += uint64_t(instanceCount) * object.triangleCount;
+    m_instanceCount += instanceCount - object.instanceCount;
+    m_visibleListSize -= uint64_t(object.instanceCount) * object.maxLODMeshletCount;
+    m_visibleListSize += uint64_t(instanceCount) * object.maxLODMeshletCount;
+    object.instanceCount = instanceCount;
 }
 
-void Renderer::_updateRenderPass(bool isNewRenderPass) {
-    uint32_t index = m_batchesGPU.size() - 1;
-    auto& batch = m_batchesGPU[index];
+void Renderer::_createDraws(const BatchedObjectData& object) {
+    // draw j renders meshlet j. the culling passes allocate its visible list (first instance) every frame
+    tga::DrawIndexedIndirectCommand *diicmds = m_diicmds.data(object.draws.offset);
+    DrawInfo *drawInfos = m_drawInfos.data(object.draws.offset);
+    for (uint32_t j = 0; j < object.meshlets.count; j++) {
+        const Meshlet& meshlet = m_meshlets[object.meshlets.offset + j];
+        diicmds[j] = {meshlet.triangleCount * 3, 0, object.indices.offset + meshlet.indexOffset,
+                      static_cast<int32_t>(object.vertices.offset), 0};
+        drawInfos[j] = {object.meshlets.offset + j, object.meshID};
+    }
+    std::copy_n(diicmds, object.draws.count, m_occlusionDiicmds.data(object.draws.offset));
+    m_diicmds.markDirty(object.draws.offset, object.draws.count);
+    m_occlusionDiicmds.markDirty(object.draws.offset, object.draws.count);
+    m_drawInfos.markDirty(object.draws.offset, object.draws.count);
+}
 
-    // input layout
-    const tga::InputLayout inputLayoutForwardPass{
-        {
-            // S0
-            {tga::BindingType::uniformBuffer},  // B0: VP
-            {tga::BindingType::uniformBuffer},  // B1: frustum
-            {tga::BindingType::uniformBuffer},  // B2: lights
-            {tga::BindingType::uniformBuffer},  // B3: time
-        },
-        {
-            // S1
-            {tga::BindingType::sampler, (uint32_t)batch.diffuseMaps.size()}  // B0: diffuse maps
-        },
-        {
-            // S2
-            {tga::BindingType::storageBuffer},  // B0: models
-            {tga::BindingType::storageBuffer},  // B1: instance id to mesh id map
-        },
-    };
+void Renderer::_growInstances(BatchedObjectData& object, uint32_t instanceCapacity) {
+    // a new range, the old one goes back to the free list. the draws do not depend on the instance slots
+    const ArenaPool::Range instances = m_instancePool.allocate(instanceCapacity);
 
-    // render pass
-    tga::RenderPass renderPass = tgai.createRenderPass(tga::RenderPassInfo{
-        m_vertexShader,
-        m_fragmentShader,
-        Application::get().window(),
-        {},
-        inputLayoutForwardPass,
-        {tga::ClearOperation::all},
-        {tga::CompareOperation::less},
-        {tga::FrontFace::counterclockwise,
-         tga::CullMode::back}}.setVertexLayout(gpro::Mesh::getVertexLayout()));
+    // the used slots move, the added ones start free
+    Transform *models = m_models.data(0);
+    std::copy_n(models + object.instances.offset, object.instanceCount, models + instances.offset);
+    m_models.markDirty(instances.offset, object.instanceCount);
+    m_instanceIDToMeshIDMap.fill(instances.offset, object.instanceCount, object.meshID);
+    m_instanceIDToMeshIDMap.fill(instances.offset + object.instanceCount, instanceCapacity - object.instanceCount,
+                                 INVALID_MESH_ID);
+    m_instanceIDToTextureIDMap.fill(instances.offset, instanceCapacity, object.diffuseMapID);
+    m_instanceVisibility.fill(instances.offset, instanceCapacity, 0);
 
-    // input sets - camera, light, time
-    std::vector<tga::InputSet> inputSetsRenderPass{
-        tgai.createInputSet({renderPass,
-                             {{m_camBuffer, 0}, {m_frustumBuffer, 1}, {m_lightsBuffer, 2}, {m_timeBuffer, 3}},
-                             INPUTSET_INDEX_CAM_AND_LIGHT}),
-    };
+    // the old range is skipped by the culling passes until it is reused
+    m_instanceIDToMeshIDMap.fill(object.instances.offset, object.instances.count, INVALID_MESH_ID);
+    m_instancePool.free(object.instances);
+    object.instances = instances;
+}
+
+void Renderer::render(tga::Window& window) {
+    // models are loaded in the background, nothing to draw before the first one arrives (batch allocates the draws)
+    if (m_drawPool.size() == 0) return;
+    GPRO_ZONE("Renderer::render");
 
-    // input sets - diffuse maps
+    // the cpu runs up to FRAMES_IN_FLIGHT frames ahead of the gpu. only the frame that used this slot last has to be
+    // complete before its command buffer, staging buffers and stats are reused
+    const uint32_t frameSlot = m_frameIndex % FRAMES_IN_FLIGHT;
+    FrameResources& frame = m_frames[frameSlot];
+    FrameTiming timing;
+    auto ts = std::chrono::steady_clock::now();
+    if (m_frameIndex > 0)  // scene update and loading on the render thread since the last frame
+        timing.updateMs = std::chrono::duration<double, std::milli>(ts - m_lastRenderEnd).count();
+    double gpuLatencyMs = 0;
+    if (frame.cmdBuffer) {
+        GPRO_ZONE("wait for frame slot");
+        tgai.waitForCompletion(frame.cmdBuffer);
+        gpuLatencyMs =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame.submitTime).count();
+    }
+    timing.waitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
+    if (frame.isPending) {
+        // a snapshot every STATS_INTERVAL frames, a line per frame would flood the console
+        if ((frame.frameIndex + 1) % STATS_INTERVAL == 0) _printCullingStats(frame);
+        _addFrameTiming(frame.timing, gpuLatencyMs);
+    }
+    frame.isPending = false;
+
+    // objects batched since the last frame
+    ts = std::chrono::steady_clock::now();
     {
-        tga::InputSetInfo info{renderPass, {}, INPUTSET_INDEX_DIFFUSE_MAPS};
-        for (int i = 0; i < batch.diffuseMaps.size(); i++) {
-            info.bindings.emplace_back(batch.diffuseMaps[i], 0, i);
-        }
-        inputSetsRenderPass.emplace_back(tgai.createInputSet(info));
+        GPRO_ZONE("commit");
+        commit();
+#ifndef GPRO_VIRTUAL_TEXTURES
+        // textures added since the last frame
+        m_textureRegistry.update(m_renderPass, INPUTSET_INDEX_DIFFUSE_MAPS);
+#endif
     }
+    timing.commitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
 
-    // input sets - model matrices, instance id to mesh id map
+    ts = std::chrono::steady_clock::now();
+    uint32_t nextFrame;
     {
-        tga::InputSetInfo info{renderPass, {}, INPUTSET_INDEX_MODELS};
-        info.bindings = {{m_modelsBuffer, 0}, {m_instanceIDToMeshIDMapBuffer,1}};
-        inputSetsRenderPass.emplace_back(tgai.createInputSet(info));
+        GPRO_ZONE("nextFrame");
+        nextFrame = tgai.nextFrame(window);
     }
+    timing.acquireMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
 
-    if (isNewRenderPass) {
-        m_renderPasses.emplace_back(std::move(renderPass));
-        m_inputSets.emplace_back(std::move(inputSetsRenderPass));
+    // a profiled frame submits its passes one by one to an idle gpu, the frames in flight have to be done before
+    const tga::CommandBuffer cmdBuffer = m_passProfiler.beginFrame(m_frameIndex, frame.cmdBuffer);
+    if (m_passProfiler.isProfiling()) {
+        for (const auto& otherFrame : m_frames)
+            if (otherFrame.cmdBuffer) tgai.waitForCompletion(otherFrame.cmdBuffer);
+    }
+
+    ts = std::chrono::steady_clock::now();
+    std::optional<tga::CommandRecorder> cmdRecorder;  // a new one per pass in profiled frames
+    cmdRecorder.emplace(tgai, cmdBuffer);
+
+    // reset, instance culling and visible list passes, one invocation per draw/pixel/counter, instance slot and draw.
+    // work groups are spread over y to stay below the dispatch size limit of x. tga has no indirect dispatch, so the
+    // cluster pass cannot be sized by the survivors, its work groups loop over them instead
+    auto workGroupCounts = [](uint32_t invocationCount) {
+        constexpr uint32_t workGroupSize = 64;
+        constexpr uint32_t maxWorkGroupCountX = 65535;
+        const uint32_t workGroupCount = (invocationCount + (workGroupSize - 1)) / workGroupSize;
+        const uint32_t workGroupCountX = std::min(workGroupCount, maxWorkGroupCountX);
+        return glm::uvec2(workGroupCountX,
+                          workGroupCountX ? (workGroupCount + (workGroupCountX - 1)) / workGroupCountX : 0);
+    };
+    const uint32_t drawCount = m_drawPool.size();
+    const uint32_t instanceSlotCount = m_instancePool.size();
+    const uint32_t pixelCount = m_cullingParams.screenWidth * m_cullingParams.screenHeight;
+    const uint32_t counterCount = 2 + m_meshPool.size() * MeshOptimizer::MAX_LOD_COUNT;
+    const glm::uvec2 resetWorkGroupCounts = workGroupCounts(std::max({drawCount, pixelCount, counterCount}));
+    const glm::uvec2 instanceWorkGroupCounts = workGroupCounts(instanceSlotCount);
+    const glm::uvec2 drawWorkGroupCounts = workGroupCounts(drawCount);
+    const uint32_t clusterWorkGroupCount = std::clamp(instanceSlotCount, 1u, MAX_CLUSTER_CULLING_WORK_GROUPS);
+    m_cullingParams.drawCount = drawCount;
+    m_cullingParams.instanceSlotCount = instanceSlotCount;
+    m_cullingParams.meshCount = m_meshPool.size();
+    m_cullingParams.visibleListCapacity = m_visibleListCapacity;
+    CullingParams occlusionCullingParams = m_cullingParams;
+    occlusionCullingParams.phase = 2;
+    const CullingStats cullingStats{};
+    const float time = Application::get().time();
+
+    // the frames in flight are ahead of this one on the queue. their draws and downloads have to be done before this
+    // frame overwrites the buffers they read. culling and drawing are one submission (one per pass in profiled frames),
+    // the draws wait for the culling pass on the gpu only.
+    // the camera, frustum and time go into the command buffer itself, so every frame in flight has its own copy
+    cmdRecorder
+        ->barrier(tga::PipelineStage::FragmentShader, tga::PipelineStage::Transfer)
+        .barrier(tga::PipelineStage::Transfer, tga::PipelineStage::Transfer)
+        .inlineBufferUpdate(m_cullingParamsBuffer, &m_cullingParams, sizeof(CullingParams))
+        .inlineBufferUpdate(m_occlusionCullingParamsBuffer, &occlusionCullingParams, sizeof(CullingParams))
+        .inlineBufferUpdate(m_cullingStatsBuffer, &cullingStats, sizeof(CullingStats))
+        .inlineBufferUpdate(m_camBuffer, tgai.getMapping(m_camStage), sizeof(CamData))
+        .inlineBufferUpdate(m_frustumBuffer, tgai.getMapping(m_frustumStage), sizeof(Frustum))
+        .inlineBufferUpdate(m_timeBuffer, &time, sizeof(float));
+    // committed and edited ranges
+    const auto uploadTs = std::chrono::steady_clock::now();
+    timing.uploadedBytes = m_arena.recordUploads(*cmdRecorder, frameSlot, m_stagingCopyPool.get());
+    timing.uploadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - uploadTs).count();
+
+#ifdef GPRO_VIRTUAL_TEXTURES
+    // pages requested by the last frames
+    m_virtualTextures.update(*cmdRecorder, m_renderPass, INPUTSET_INDEX_DIFFUSE_MAPS, frameSlot);
+    const tga::InputSet diffuseMapsInputSet = m_virtualTextures.inputSet();
+#else
+    const tga::InputSet diffuseMapsInputSet = m_textureRegistry.inputSet();
+#endif
+    m_passProfiler.endPass("uploads", cmdRecorder);
+
+    cmdRecorder
+        ->barrier(tga::PipelineStage::Transfer, tga::PipelineStage::ComputeShader)
+        .setComputePass(m_resetCullingPass)
+        .bindInputSet(m_resetCullingPassInputSet)
+        .dispatch(resetWorkGroupCounts.x, resetWorkGroupCounts.y, 1);
+    m_passProfiler.endPass("reset culling", cmdRecorder);
+
+    // instances, then the visible lists of the draws they picked, then the clusters of the surviving instances
+    auto recordCulling = [&](tga::InputSet instanceInputSet, tga::InputSet visibleListInputSet,
+                             tga::InputSet clusterInputSet) {
+        cmdRecorder
+            ->barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader)
+            .setComputePass(m_instanceCullingPass)
+            .bindInputSet(instanceInputSet)
+            .dispatch(instanceWorkGroupCounts.x, instanceWorkGroupCounts.y, 1)
+            .barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader)
+            .setComputePass(m_visibleListPass)
+            .bindInputSet(visibleListInputSet)
+            .dispatch(drawWorkGroupCounts.x, drawWorkGroupCounts.y, 1)
+            .barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader)
+            .setComputePass(m_clusterCullingPass)
+            .bindInputSet(clusterInputSet)
+            .dispatch(clusterWorkGroupCount, 1, 1)
+            .barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::DrawIndirect)    // instance counts
+            .barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::VertexShader);  // visible instance ids
+    };
+    recordCulling(m_instanceCullingPassInputSet, m_visibleListPassInputSet, m_clusterCullingPassInputSet);
+    m_passProfiler.endPass("culling", cmdRecorder);
+
+    // forward render pass, phase 1 of the occlusion culling if enabled
+    cmdRecorder
+        ->setRenderPass(m_renderPass, nextFrame, {0, 0, 0, 1})
+        .bindInputSet(m_camAndLightInputSet)                // camera + lights + depth copy
+        .bindInputSet(diffuseMapsInputSet)                  // diffuse maps
+        .bindInputSet(m_modelsInputSet)                     // models + aabbs + texture ids + visible instances
+        .bindVertexBuffer(m_vertices.buffer())              // every mesh, sub-allocated
+        .bindIndexBuffer(m_indices.buffer())
+        .drawIndexedIndirect(m_diicmds.buffer(), drawCount);
+    m_passProfiler.endPass("forward", cmdRecorder);
+
+#ifdef GPRO_OCCLUSION_CULLING
+    // depth pyramid of the first pass, one level after the other
+    cmdRecorder
+        ->barrier(tga::PipelineStage::FragmentShader, tga::PipelineStage::ComputeShader)
+        .setComputePass(m_depthPyramidPass)
+        .bindInputSet(m_depthPyramidPassInputSet);
+    constexpr size_t levelOffset = offsetof(DepthPyramidParams, level);
+    for (uint32_t level = 0; level < m_cullingParams.pyramidLevelCount; level++) {
+        const uint32_t levelWidth = std::max(1u, (m_cullingParams.screenWidth + (2u << level) - 1) >> (level + 1));
+        const uint32_t levelHeight = std::max(1u, (m_cullingParams.screenHeight + (2u << level) - 1) >> (level + 1));
+        cmdRecorder
+            ->barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::Transfer)
+            .inlineBufferUpdate(m_depthPyramidParamsBuffer, &level, sizeof(uint32_t), levelOffset)
+            .barrier(tga::PipelineStage::Transfer, tga::PipelineStage::ComputeShader)
+            .dispatch((levelWidth + 7) / 8, (levelHeight + 7) / 8, 1);
+    }
+    m_passProfiler.endPass("depth pyramid", cmdRecorder);
+
+    // phase 2: the clusters that pass the depth pyramid and were not drawn by the first pass
+    recordCulling(m_occlusionInstanceCullingPassInputSet, m_occlusionVisibleListPassInputSet,
+                  m_occlusionClusterCullingPassInputSet);
+    m_passProfiler.endPass("occlusion culling", cmdRecorder);
+    cmdRecorder
+        ->setRenderPass(m_occlusionRenderPass, nextFrame)
+        .bindInputSet(m_camAndLightInputSet)
+        .bindInputSet(diffuseMapsInputSet)
+        .bindInputSet(m_occlusionModelsInputSet)
+        .bindVertexBuffer(m_vertices.buffer())
+        .bindIndexBuffer(m_indices.buffer())
+        .drawIndexedIndirect(m_occlusionDiicmds.buffer(), drawCount);
+    m_passProfiler.endPass("occlusion forward", cmdRecorder);
+#endif
+
+    // culling and fragment stats, read when the slot comes around again
+    cmdRecorder
+        ->barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::Transfer)
+        .barrier(tga::PipelineStage::FragmentShader, tga::PipelineStage::Transfer)
+        .bufferDownload(m_cullingStatsBuffer, frame.cullingStatsStaging, sizeof(CullingStats));
+#ifdef GPRO_VIRTUAL_TEXTURES
+    m_virtualTextures.downloadFeedback(*cmdRecorder, frameSlot);
+#endif
+    frame.isPending = true;
+    frame.frameIndex = m_frameIndex;
+    frame.drawCount = drawCount;
+    frame.instanceCount = m_instanceCount;
+    frame.submittedTriangleCount = m_submittedTriangleCount;
+    timing.batchCount = static_cast<uint32_t>(m_batchedObjects.size());
+
+    // a profiled frame submits its last pass here and has no command buffer of its own, the slot's last one is
+    // complete. its record time includes the latency of every pass
+    if (m_passProfiler.isProfiling()) {
+        m_passProfiler.endPass("readback", cmdRecorder, true);
+        m_passProfiler.print();
     } else {
-        m_inputSets[index].clear();
-        m_renderPasses[index] = std::move(renderPass);
-        m_inputSets[index] = std::move(inputSetsRenderPass);
+        frame.cmdBuffer = cmdRecorder->endRecording();
     }
+    timing.recordMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
+
+    ts = std::chrono::steady_clock::now();
+    frame.submitTime = ts;
+    {
+        GPRO_ZONE("execute and present");
+        if (!m_passProfiler.isProfiling()) tgai.execute(frame.cmdBuffer);
+        tgai.present(window, nextFrame);
+    }
+    timing.submitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
+    frame.timing = timing;
+    m_frameIndex++;
+    m_lastRenderEnd = std::chrono::steady_clock::now();
 }
 
-void Renderer::_updateFrustumCullingPass() {
-    const tga::InputLayout inputLayout{{
-        // S0
-        {tga::BindingType::storageBuffer},  // B0 models
-        {tga::BindingType::storageBuffer},  // B1 aabbs
-        {tga::BindingType::uniformBuffer},  // B2 camera VP
-        {tga::BindingType::storageBuffer},  // B3 instance id to mesh id map
-        {tga::BindingType::storageBuffer},  // B4 visible object count (writeonly)
-        {tga::BindingType::storageBuffer},  // B5 diicmds (writeonly)
-    }};
+void Renderer::_addFrameTiming(const FrameTiming& timing, double gpuLatencyMs) {
+    // the cpu overlaps the gpu as long as it does not wait for it
+    const double cpuMs = timing.updateMs + timing.commitMs + timing.acquireMs + timing.recordMs + timing.submitMs;
+    FrameTimingTotals& totals = m_timingTotals;
+    totals.sum.updateMs += timing.updateMs;
+    totals.sum.waitMs += timing.waitMs;
+    totals.sum.commitMs += timing.commitMs;
+    totals.sum.acquireMs += timing.acquireMs;
+    totals.sum.recordMs += timing.recordMs;
+    totals.sum.submitMs += timing.submitMs;
+    totals.sum.uploadMs += timing.uploadMs;
+    totals.sum.uploadedBytes += timing.uploadedBytes;
+    totals.sum.batchCount = timing.batchCount;  // the last
+    totals.gpuLatencyMs += gpuLatencyMs;
+    totals.maxCpuMs = std::max(totals.maxCpuMs, cpuMs);
+    totals.maxWaitMs = std::max(totals.maxWaitMs, timing.waitMs);
+    totals.frameCount++;
+    if (timing.uploadedBytes > 0) totals.uploadFrameCount++;
+    if (totals.frameCount < STATS_INTERVAL) return;
 
-    m_frustumCullingPass = tgai.createComputePass({m_frustumCullingComputeShader, inputLayout});
+    const FrameTiming& sum = totals.sum;
+    const double n = totals.frameCount;
+    const double cpuSumMs = sum.updateMs + sum.commitMs + sum.acquireMs + sum.recordMs + sum.submitMs;
+    std::cout << std::format("Frame timing over {0} frames ({1} in flight), avg: cpu {2:.2f} ms (max {3:.2f}, "
+                             "update {4:.2f}, commit {5:.2f}, acquire {6:.2f}, record {7:.2f}, submit {8:.2f}), "
+                             "waited for the gpu {9:.2f} ms (max {10:.2f}), gpu done <= {11:.2f} ms after submit\n",
+                             totals.frameCount, FRAMES_IN_FLIGHT, cpuSumMs / n, totals.maxCpuMs, sum.updateMs / n,
+                             sum.commitMs / n, sum.acquireMs / n, sum.recordMs / n, sum.submitMs / n, sum.waitMs / n,
+                             totals.maxWaitMs, totals.gpuLatencyMs / n);
+    // staging copies against the batch and thread count. the draws are one indirect call whatever the batch count,
+    // the uploads of newly batched objects are what grows with it
+    if (totals.uploadFrameCount > 0) {
+        const uint32_t stagingCopyThreadCount = m_stagingCopyPool ? m_stagingCopyPool->threadCount() + 1 : 1;
+        std::cout << std::format("    staging copies: {0} batches, {1} frames uploaded {2:.1f} KB in {3:.2f} ms on {4} "
+                                 "threads\n",
+                                 sum.batchCount, totals.uploadFrameCount, sum.uploadedBytes / 1024.0, sum.uploadMs,
+                                 stagingCopyThreadCount);
+    }
+    totals = {};
+}
 
-    m_frustumCullingPassInputSet = tgai.createInputSet(
-        {m_frustumCullingPass,
-         {{m_modelsBuffer, 0}, {m_aabbsBuffer, 1}, {m_camBuffer, 2}, {m_instanceIDToMeshIDMapBuffer, 3}, {m_visibleObjectCountBuffer, 4}, {m_diicmdsBuffer, 5}},
-         0});
+void Renderer::_printCullingStats(const FrameResources& frame) {
+    const CullingStats *cullingStats = static_cast<const CullingStats *>(tgai.getMapping(frame.cullingStatsStaging));
+    std::string lodTriangleCounts;
+    for (uint32_t count : cullingStats->lodTriangleCounts) lodTriangleCounts += std::format(" {}", count);
+    std::cout << std::format("Visible instances: {0}/{1}, clusters: {2} ({3} occluded, {4} dropped), draws: {5}, "
+                             "triangles visible/submitted: {6}/{7} ({8:.1f}%), per lod:{9}, fragments: {10} "
+                             "(frame {11}), frame: {12:.2f} ms\n",
+                             cullingStats->visibleInstanceCount, frame.instanceCount,
+                             cullingStats->visibleClusterCount, cullingStats->occludedClusterCount,
+                             cullingStats->droppedClusterCount, frame.drawCount, cullingStats->visibleTriangleCount,
+                             frame.submittedTriangleCount,
+                             100.0 * cullingStats->visibleTriangleCount /
+                                 std::max<uint64_t>(1, frame.submittedTriangleCount),
+                             lodTriangleCounts, cullingStats->fragmentCount, frame.frameIndex,
+                             Application::get().deltaTime() * 1000.0);
+}
+
+void Renderer::_updateRenderPassInputSets() {
+    // input sets - camera, light, time
+    if (!m_camAndLightInputSet) {
+        m_camAndLightInputSet = tgai.createInputSet({m_renderPass,
+                                                     {{m_camBuffer, 0},
+                                                      {m_frustumBuffer, 1},
+                                                      {m_lightsBuffer, 2},
+                                                      {m_timeBuffer, 3},
+                                                      {m_depthCopyBuffer, 4},
+                                                      {m_cullingStatsBuffer, 5}},
+                                                     INPUTSET_INDEX_CAM_AND_LIGHT});
+    }
+
+    // input sets - model matrices, instance id to mesh/texture id maps, aabbs, visible instance ids
+    tga::InputSetInfo info{m_renderPass, {}, INPUTSET_INDEX_MODELS};
+    info.bindings = {{m_models.buffer(), 0},
+                     {m_instanceIDToMeshIDMap.buffer(), 1},
+                     {m_aabbs.buffer(), 2},
+                     {m_instanceIDToTextureIDMap.buffer(), 3},
+                     {m_visibleInstanceIDsBuffer, 4}};
+    m_releasedInputSets.release(m_modelsInputSet);
+    m_modelsInputSet = tgai.createInputSet(info);
+
+    // the same for occlusion culling phase 2, with its visible instances
+    info.bindings.back() = {m_occlusionVisibleInstanceIDsBuffer, 4};
+    m_releasedInputSets.release(m_occlusionModelsInputSet);
+    m_occlusionModelsInputSet = tgai.createInputSet(info);
+}
+
+bool Renderer::_reserveCullingBuffers() {
+    // gpu-only, replaced buffers are freed once no frame in flight uses them
+    auto recreate = [&](tga::Buffer& buffer, size_t size) {
+        m_arena.release(buffer);
+        buffer = tgai.createBuffer({tga::BufferUsage::storage, size});
+    };
+    bool isRecreated = false;
+
+    // counters and survivors follow the mesh and instance pools
+    if (m_meshPool.capacity() > m_cullingMeshCapacity) {
+        m_cullingMeshCapacity = m_meshPool.capacity();
+        const size_t size = (2 + size_t(m_cullingMeshCapacity) * MeshOptimizer::MAX_LOD_COUNT) * sizeof(uint32_t);
+        recreate(m_cullingCountersBuffer, size);
+        recreate(m_occlusionCullingCountersBuffer, size);
+        isRecreated = true;
+    }
+    if (m_instancePool.capacity() > m_survivorCapacity) {
+        m_survivorCapacity = m_instancePool.capacity();
+        recreate(m_survivorsBuffer, size_t(m_survivorCapacity) * sizeof(glm::uvec2));
+        recreate(m_occlusionSurvivorsBuffer, size_t(m_survivorCapacity) * sizeof(glm::uvec2));
+        isRecreated = true;
+    }
+
+    // the visible lists at most need an entry per instance and meshlet of its largest lod. they grow geometrically
+    // up to the budget, past it the draws that do not fit drop their clusters for the frame
+    if (m_visibleListCapacity == 0 ||
+        (m_visibleListSize > m_visibleListCapacity && m_visibleListCapacity < MAX_VISIBLE_LIST_CAPACITY)) {
+        m_visibleListCapacity = static_cast<uint32_t>(std::min<uint64_t>(
+            std::max({m_visibleListSize, uint64_t(m_visibleListCapacity) * 2, uint64_t(1) << 16}),
+            MAX_VISIBLE_LIST_CAPACITY));
+        recreate(m_visibleInstanceIDsBuffer, size_t(m_visibleListCapacity) * sizeof(uint32_t));
+        recreate(m_occlusionVisibleInstanceIDsBuffer, size_t(m_visibleListCapacity) * sizeof(uint32_t));
+        isRecreated = true;
+    }
+    return isRecreated;
+}
+
+void Renderer::_updateCullingPassInputSets() {
+    m_releasedInputSets.release(m_resetCullingPassInputSet);
+    m_resetCullingPassInputSet = tgai.createInputSet({m_resetCullingPass,
+                                                      {{m_diicmds.buffer(), 0},
+                                                       {m_cullingParamsBuffer, 1},
+                                                       {m_occlusionDiicmds.buffer(), 2},
+                                                       {m_depthCopyBuffer, 3},
+                                                       {m_cullingCountersBuffer, 4},
+                                                       {m_occlusionCullingCountersBuffer, 5}},
+                                                      0});
+
+    // occlusion culling phase 2 has its own params, counters, survivors, draws and visible lists
+    tga::InputSetInfo info{m_instanceCullingPass, {}, 0};
+    info.bindings = {{m_models.buffer(), 0},
+                     {m_camBuffer, 1},
+                     {m_frustumBuffer, 2},
+                     {m_cullingParamsBuffer, 3},
+                     {m_instanceIDToMeshIDMap.buffer(), 4},
+                     {m_meshLODs.buffer(), 5},
+                     {m_aabbs.buffer(), 6},
+                     {m_instanceVisibility.buffer(), 7},
+                     {m_depthPyramidBuffer, 8},
+                     {m_cullingStatsBuffer, 9},
+                     {m_cullingCountersBuffer, 10},
+                     {m_survivorsBuffer, 11}};
+    m_releasedInputSets.release(m_instanceCullingPassInputSet);
+    m_instanceCullingPassInputSet = tgai.createInputSet(info);
+    info.bindings[3] = {m_occlusionCullingParamsBuffer, 3};
+    info.bindings[10] = {m_occlusionCullingCountersBuffer, 10};
+    info.bindings[11] = {m_occlusionSurvivorsBuffer, 11};
+    m_releasedInputSets.release(m_occlusionInstanceCullingPassInputSet);
+    m_occlusionInstanceCullingPassInputSet = tgai.createInputSet(info);
+
+    info = {m_visibleListPass, {}, 0};
+    info.bindings = {{m_cullingParamsBuffer, 0},
+                     {m_drawInfos.buffer(), 1},
+                     {m_meshlets.buffer(), 2},
+                     {m_cullingCountersBuffer, 3},
+                     {m_diicmds.buffer(), 4}};
+    m_releasedInputSets.release(m_visibleListPassInputSet);
+    m_visibleListPassInputSet = tgai.createInputSet(info);
+    info.bindings[0] = {m_occlusionCullingParamsBuffer, 0};
+    info.bindings[3] = {m_occlusionCullingCountersBuffer, 3};
+    info.bindings[4] = {m_occlusionDiicmds.buffer(), 4};
+    m_releasedInputSets.release(m_occlusionVisibleListPassInputSet);
+    m_occlusionVisibleListPassInputSet = tgai.createInputSet(info);
+
+    info = {m_clusterCullingPass, {}, 0};
+    info.bindings = {{m_models.buffer(), 0},
+                     {m_camBuffer, 1},
+                     {m_frustumBuffer, 2},
+                     {m_cullingParamsBuffer, 3},
+                     {m_instanceIDToMeshIDMap.buffer(), 4},
+                     {m_meshLODs.buffer(), 5},
+                     {m_meshlets.buffer(), 6},
+                     {m_drawInfos.buffer(), 7},
+                     {m_instanceVisibility.buffer(), 8},
+                     {m_depthPyramidBuffer, 9},
+                     {m_cullingStatsBuffer, 10},
+                     {m_cullingCountersBuffer, 11},
+                     {m_survivorsBuffer, 12},
+                     {m_diicmds.buffer(), 13},
+                     {m_visibleInstanceIDsBuffer, 14}};
+    m_releasedInputSets.release(m_clusterCullingPassInputSet);
+    m_clusterCullingPassInputSet = tgai.createInputSet(info);
+    info.bindings[3] = {m_occlusionCullingParamsBuffer, 3};
+    info.bindings[11] = {m_occlusionCullingCountersBuffer, 11};
+    info.bindings[12] = {m_occlusionSurvivorsBuffer, 12};
+    info.bindings[13] = {m_occlusionDiicmds.buffer(), 13};
+    info.bindings[14] = {m_occlusionVisibleInstanceIDsBuffer, 14};
+    m_releasedInputSets.release(m_occlusionClusterCullingPassInputSet);
+    m_occlusionClusterCullingPassInputSet = tgai.createInputSet(info);
 }
-}  // namespace gpro
\ No newline at end of file
+}  // namespace gpro
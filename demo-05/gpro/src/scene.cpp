@@ -20,6 +20,18 @@ void Scene::addSceneObject(const SceneObject& so) {  // TODO: add move
     Renderer::get().batch(so);
 }
 
+void Scene::updateSceneObject(uint32_t index, std::vector<Transform> transforms) {
+    SceneObject& so = m_sceneObjects[index];
+    so.transforms = std::move(transforms);
+    so.instanceCount = so.transforms.size();
+    Renderer::get().updateInstances(index, so.transforms);
+}
+
+void Scene::replaceSceneObject(uint32_t index, const SceneObject& so) {
+    m_sceneObjects[index] = so;
+    Renderer::get().replace(index, so);
+}
+
 void Scene::onUpdate() { m_camera->update(Application::get().deltaTime()); }
 
 }  // namespace gpro
\ No newline at end of file
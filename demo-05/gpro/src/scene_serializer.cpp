@@ -6,21 +6,40 @@
 
 #include <filesystem>
 
+#include "gpro/cpu_profiler.hpp"
 #include "gpro/file.hpp"
+#include "gpro/mesh_cache.hpp"
+#include "gpro/mesh_codec.hpp"
+#include "gpro/mesh_optimizer.hpp"
 #include "gpro/utils.hpp"
 #include "tga/tga_utils.hpp"
 
+#define MAX_MODELS_PER_FRAME 16  // models handed to the scene per frame, the renderer commits them together
+#define MAX_INSTANCE_COUNT (1 << 20)  // per model, a typo must not reserve gigabytes of transforms
+
 namespace gpro {
 
-SceneSerializer::SceneSerializer(std::shared_ptr<Scene> scene) : m_scene(scene) {
-    m_lastUpdateTime = std::chrono::time_point<std::chrono::file_clock>::min();
-}
+SceneSerializer::SceneSerializer(std::shared_ptr<Scene> scene)
+    : m_scene(scene),
+      m_fileWatcher({gpro::resourcePath("models"), gpro::resourcePath("textures")}, {".yaml", ".obj", ".png"}) {}
 
-bool SceneSerializer::deserialize() { return _deserializeModels(); }
+SceneSerializer::~SceneSerializer() { m_threadPool.stop(); }
+
+bool SceneSerializer::deserialize() {
+    if (!m_isScanned) {
+        m_isScanned = true;
+        return _deserializeModels();
+    }
+
+    // only the files that changed, nothing to do for an idle scene
+    bool hasDeserializedModels = false;
+    FileEvent event;
+    while (m_fileWatcher.tryPop(event)) hasDeserializedModels |= _onFileEvent(event);
+    return hasDeserializedModels;
+}
 
 bool SceneSerializer::_deserializeModels() {
     bool hasDeserializedModels = false;
-    bool hasUpdatedModel = false;
 
     // check if the models folder exist
     const std::string modelsFolderPath = gpro::resourcePath("models");
@@ -29,62 +48,225 @@ bool SceneSerializer::_deserializeModels() {
         return false;
     }
 
-    // check the last modification times of the model config files
+    // load every model config that is not in the scene yet
     for (const auto& entry : std::filesystem::directory_iterator(modelsFolderPath)) {
-        if (entry.is_regular_file()) {
-            // Get the file name
-            std::string configFileName = entry.path().filename().string();
-
-            if (configFileName.length() < 5 || configFileName.substr(configFileName.length() - 5) != ".yaml") continue;
-
-            // get model name
-            std::string modelName = configFileName.substr(0, configFileName.length() - 5);  // assumes model_name.yaml
-
-            // check the last write time of the file or a new added file
-            const std::filesystem::file_time_type fileTime = std::filesystem::last_write_time(entry.path());
-            auto ftime = std::chrono::time_point_cast<std::chrono::system_clock::duration>(fileTime);
-            auto it = m_modelNameToSceneObject.find(modelName);
-            if (it != m_modelNameToSceneObject.end() && ftime < m_lastUpdateTime) continue;
-
-            // load model data
-            YAML::Node n_model;  // TODO: check if corresponding texture and model file exist, before loading the yaml
-            if (!_loadYAML(entry.path().string(), n_model)) continue;
-
-            if (it == m_modelNameToSceneObject.end()) {  // add new model data
-                bool result = _deserializeModel(modelName, n_model);
-                if (result) hasDeserializedModels = true;
-            } else  // update existing model data
-            {
-                /*
-                std::cout << "Scene updated\n";
-                glm::vec3 position;
-                float scale;
-                uint32_t instanceCount;
-                if (!_deserializeModelConfig(n_model, transform, instanceCount)) continue;
-
-                uint32_t sceneObjectIndex = it->second;
-                auto& sceneObject = m_scene->m_sceneObjects[sceneObjectIndex];
-
-                sceneObject.transforms.reserve(instanceCount);
-                for(int i = 0; i < instanceCount; i++)
-                {
-                    Transform t = transform;
-                    sceneObject.transforms.emplace_back(transform);
-                }
-                sceneObject.instanceCount = instanceCount;
-
-                hasUpdatedModel = true;
-                */
+        if (!entry.is_regular_file() || entry.path().extension() != ".yaml") continue;
+        hasDeserializedModels |= _requestModel(entry.path().stem().string());  // assumes model_name.yaml
+    }
+
+    return hasDeserializedModels;
+}
+
+bool SceneSerializer::_rescanModels() {
+    // the loads in flight may have read files that changed since, they load again once they are done
+    for (const std::string& modelName : m_pendingModels) m_staleModels[modelName] = true;
+
+    bool hasDeserializedModels = false;
+    for (const auto& [modelName, objectIndex] : m_modelNameToSceneObject) {
+        if (m_pendingModels.contains(modelName)) continue;
+
+        const std::string modelPath = gpro::resourcePath(std::format("models/{}.obj", modelName));
+        const std::string modelConfigPath = gpro::resourcePath(std::format("models/{}.yaml", modelName));
+        const std::string modelDiffusePath = gpro::resourcePath(std::format("textures/{}.png", modelName));
+        if (!std::filesystem::exists(modelConfigPath) || !std::filesystem::exists(modelPath)) {
+            _hideModel(modelName);
+            continue;
+        }
+
+        // the files the model was loaded from, a missing diffuse map keeps its texture
+        const ModelFileTimes& fileTimes = m_modelFileTimes[modelName];
+        std::error_code ec;
+        const bool isMeshChanged = std::filesystem::last_write_time(modelPath, ec) != fileTimes.mesh;
+        const auto diffuseMapTime = std::filesystem::last_write_time(modelDiffusePath, ec);
+        const bool isDiffuseMapChanged = !ec && diffuseMapTime != fileTimes.diffuseMap;
+        if (isMeshChanged || isDiffuseMapChanged)
+            hasDeserializedModels |= _reloadModel(modelName, isDiffuseMapChanged);
+        else
+            _updateModel(modelName);
+    }
+
+    // and the models that are not in the scene yet
+    hasDeserializedModels |= _deserializeModels();
+    return hasDeserializedModels;
+}
+
+bool SceneSerializer::_onFileEvent(const FileEvent& event) {
+    if (event.type == FileEvent::Type::rescan) return _rescanModels();
+
+    // models/<name>.yaml, models/<name>.obj and textures/<name>.png all belong to the model <name>
+    const std::filesystem::path path(event.path);
+    const std::string modelName = path.stem().string();
+    const bool isModelInScene = m_modelNameToSceneObject.contains(modelName);
+
+    // a removed diffuse map keeps its texture, the model can still be drawn
+    if (event.type == FileEvent::Type::removed && path.extension() == ".png") return false;
+
+    // the load in flight may have read the old files, the model loads again once it is done (and is hidden then if
+    // its files are gone)
+    if (m_pendingModels.contains(modelName)) {
+        m_staleModels[modelName] |= path.extension() == ".png";
+        return false;
+    }
+
+    if (event.type == FileEvent::Type::removed) {
+        if (isModelInScene) _hideModel(modelName);
+        return false;
+    }
+
+    // the config only moves the instances, a changed mesh or diffuse map loads the model again
+    if (isModelInScene) {
+        if (path.extension() == ".yaml") {
+            _updateModel(modelName);
+            return false;
+        }
+        return _reloadModel(modelName, path.extension() == ".png");
+    }
+
+    // a new model, or one that could not be loaded before
+    return _requestModel(modelName);
+}
+
+bool SceneSerializer::_requestModel(const std::string& modelName) {
+    if (m_modelNameToSceneObject.contains(modelName) || m_pendingModels.contains(modelName)) return false;
+    if (!std::filesystem::exists(gpro::resourcePath(std::format("models/{}.yaml", modelName)))) return false;
+
+    if (m_pendingModels.empty()) m_sceneLoadStartTime = std::chrono::steady_clock::now();
+    m_pendingModels.insert(modelName);
+    _loadModelAsync(modelName);
+    return true;
+}
+
+void SceneSerializer::_updateModel(const std::string& modelName) {
+    auto ts = std::chrono::steady_clock::now();
+
+    // load model data
+    YAML::Node n_model;
+    if (!_loadYAML(gpro::resourcePath(std::format("models/{}.yaml", modelName)), n_model)) return;
+
+    // the mesh and diffuse map settings only apply when the model is loaded
+    glm::vec3 position;
+    float scale;
+    uint32_t instanceCount;
+    bool optimizeMesh;
+    TextureCache::Encoding diffuseEncoding;
+    if (!_deserializeModelConfig(n_model, position, scale, instanceCount, optimizeMesh, diffuseEncoding)) return;
+
+    // the renderer patches the instances that changed
+    std::vector<Transform> transforms;
+    _createTransforms(position, scale, instanceCount, transforms);
+    m_scene->updateSceneObject(m_modelNameToSceneObject[modelName], std::move(transforms));
+
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - ts).count();
+    std::cout << std::format("updated model: {0} ({1} instances, {2:.1f} us)\n", modelName, instanceCount, us);
+}
+
+bool SceneSerializer::_reloadModel(const std::string& modelName, bool reloadDiffuseMap) {
+    // the load in flight may have read the old files
+    if (m_pendingModels.contains(modelName)) {
+        m_staleModels[modelName] |= reloadDiffuseMap;
+        return false;
+    }
+    if (!std::filesystem::exists(gpro::resourcePath(std::format("models/{}.yaml", modelName))) ||
+        !std::filesystem::exists(gpro::resourcePath(std::format("models/{}.obj", modelName)))) {
+        if (m_modelNameToSceneObject.contains(modelName)) _hideModel(modelName);
+        return false;
+    }
+
+    // the loader keeps a path's texture until it is invalidated, the model's load requests it again
+    if (reloadDiffuseMap) m_textureLoader.invalidate(gpro::resourcePath(std::format("textures/{}.png", modelName)));
+
+    if (m_pendingModels.empty()) m_sceneLoadStartTime = std::chrono::steady_clock::now();
+    m_pendingModels.insert(modelName);
+    _loadModelAsync(modelName);
+    return true;
+}
+
+void SceneSerializer::_hideModel(const std::string& modelName) {
+    // no instances, the scene object keeps its index and its mesh until the files are back (a config update or a
+    // reload shows it again)
+    m_scene->updateSceneObject(m_modelNameToSceneObject[modelName], {});
+    std::cout << std::format("removed model: {} (hidden)\n", modelName);
+}
+
+void SceneSerializer::processLoadedModels() {
+    // textures first, every one that finished decoding is uploaded in this frame
+    m_textureLoader.processLoaded();
+
+    // models wait for their diffuse map
+    ModelAsset loaded;
+    while (m_loadedModels.tryPop(loaded)) m_waitingModels.push_back(std::move(loaded));
+
+    int addedCount = 0;
+    for (auto it = m_waitingModels.begin(); it != m_waitingModels.end() && addedCount < MAX_MODELS_PER_FRAME;) {
+        ModelAsset& asset = *it;
+        uint32_t diffuseMapID;
+        const bool hasDiffuseMap = asset.isLoaded && m_textureLoader.find(asset.diffusePath, diffuseMapID);
+        if (asset.isLoaded && !hasDiffuseMap && m_textureLoader.isPending(asset.diffusePath)) {
+            ++it;
+            continue;
+        }
+
+        m_pendingModels.erase(asset.name);
+        if (hasDiffuseMap) {
+            // only the mesh uploads are left for the render thread
+            auto ts = std::chrono::steady_clock::now();
+            SceneObject so{
+                std::move(asset.mesh),
+                std::move(asset.transforms), asset.instanceCount,
+                diffuseMapID,
+                std::move(asset.boundingBox)
+            };
+            auto objectIt = m_modelNameToSceneObject.find(asset.name);
+            const bool isReload = objectIt != m_modelNameToSceneObject.end();
+            if (isReload) {
+                m_scene->replaceSceneObject(objectIt->second, so);
+            } else {
+                m_scene->addSceneObject(so);
+                m_modelNameToSceneObject.insert(std::make_pair(asset.name, m_scene->m_sceneObjects.size() - 1));
             }
+            m_modelFileTimes[asset.name] = asset.fileTimes;
+            addedCount++;
+
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
+            std::cout << std::format("{0} model: {1} (loaded in {2:.2f} ms off the render thread, {3:.2f} ms on it)\n",
+                                     isReload ? "reloaded" : "added new", asset.name, asset.loadMs, ms);
+        } else if (asset.isLoaded) {
+            std::cerr << std::format("Failed to load the diffuse map of model '{0}': {1}\n", asset.name,
+                                     asset.diffusePath);
+        }
+        const std::string modelName = std::move(asset.name);
+        it = m_waitingModels.erase(it);
+        if (auto stale = m_staleModels.extract(modelName)) _reloadModel(modelName, stale.mapped());
+
+        if (m_pendingModels.empty()) {
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                                  m_sceneLoadStartTime).count();
+            std::cout << std::format("loaded scene: {0} models in {1:.2f} ms ({2} worker threads)\n",
+                                     m_scene->m_sceneObjects.size(), ms, m_threadPool.threadCount());
         }
     }
+}
 
-    if (hasDeserializedModels || hasUpdatedModel) m_lastUpdateTime = std::chrono::file_clock::now();
+AsyncTask SceneSerializer::_loadModelAsync(std::string modelName) {
+    // the rest runs on a worker
+    co_await m_threadPool.schedule();
+    GPRO_ZONE("load model");
 
-    return hasDeserializedModels;
+    auto ts = std::chrono::steady_clock::now();
+    ModelAsset asset;
+    asset.name = modelName;
+    try {
+        asset.isLoaded = _loadModel(modelName, asset);
+    } catch (const std::exception& e) {
+        std::cerr << std::format("Failed to load model '{0}': {1}\n", modelName, e.what());
+    }
+    asset.loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
+
+    // failed loads are handed over too, so the model can be retried
+    m_loadedModels.push(std::move(asset));
 }
 
-bool SceneSerializer::_deserializeModel(const std::string& modelName, const YAML::Node& data) {
+bool SceneSerializer::_loadModel(const std::string& modelName, ModelAsset& asset) {
     // try to get paths
     std::string modelPath = gpro::resourcePath(std::format("models/{}.obj", modelName));
     std::string modelConfigPath = gpro::resourcePath(std::format("models/{}.yaml", modelName));
@@ -93,54 +275,146 @@ bool SceneSerializer::_deserializeModel(const std::string& modelName, const YAML
         !std::filesystem::exists(modelDiffusePath))
         return false;
 
+    // before reading, a rescan compares them with the files on disk
+    std::error_code ec;
+    asset.fileTimes.mesh = std::filesystem::last_write_time(modelPath, ec);
+    asset.fileTimes.diffuseMap = std::filesystem::last_write_time(modelDiffusePath, ec);
+
     // try to load config
     YAML::Node n_modelConfig;
     if (!_loadYAML(modelConfigPath, n_modelConfig)) return false;
 
-    // create scene object
-    Mesh mesh;
     glm::vec3 position;
     float scale;
-    uint32_t instanceCount;
-
-    // load mesh
-    util::loadObj(modelPath, mesh.vertices, mesh.indices);
+    bool optimizeMesh;
+    TextureCache::Encoding diffuseEncoding;
 
     // load config
-    if (!_deserializeModelConfig(n_modelConfig, position, scale, instanceCount)) return false;
+    if (!_deserializeModelConfig(n_modelConfig, position, scale, asset.instanceCount, optimizeMesh, diffuseEncoding))
+        return false;
 
-    std::vector<Transform> transforms;
+    // the diffuse map decodes on another worker while the mesh loads, shared maps are loaded once
+    asset.diffusePath = modelDiffusePath;
+    m_textureLoader.request(modelDiffusePath, diffuseEncoding);
+
+    // load mesh, with its lods and meshlets
+    asset.boundingBox = _loadMesh(modelPath, optimizeMesh, asset.mesh);
+
+    _createTransforms(position, scale, asset.instanceCount, asset.transforms);
+
+    return true;
+}
+
+void SceneSerializer::_createTransforms(const glm::vec3& position, float scale, uint32_t instanceCount,
+                                        std::vector<Transform>& transforms) {
     transforms.reserve(instanceCount);
-    for (int i = 0; i < instanceCount; i++) {
+    for (uint32_t i = 0; i < instanceCount; i++) {
         transforms.emplace_back(
             position + (float)i * glm::vec3(3, 0, 0),
             glm::vec3(0),
             glm::vec3(scale));
     }
+}
 
+AABB SceneSerializer::_loadMesh(const std::string& modelPath, bool optimize, Mesh& mesh) {
+    auto ts = std::chrono::steady_clock::now();
+    uint32_t cacheFlags = optimize ? MeshCache::OPTIMIZED : MeshCache::NONE;
+#ifdef GPRO_COMPACT_VERTICES
+    cacheFlags |= MeshCache::COMPRESSED;
+#endif
+
+    // warm path: the final arrays stay in the mapped cache entry, or are decoded straight out of it
+    MeshCache::MappedMesh cached;
+    if (MeshCache::load(modelPath, cacheFlags, cached)) {
+        auto tsUnpack = std::chrono::steady_clock::now();
+        if (MeshCache::unpack(cached, mesh)) {
+            auto te = std::chrono::steady_clock::now();
+            double ms = std::chrono::duration<double, std::milli>(te - ts).count();
+            std::cout << std::format("loaded mesh from cache: {0} ({1:.2f} ms)\n", modelPath, ms);
+
+            if (cacheFlags & MeshCache::COMPRESSED) {
+                const size_t rawSize =
+                    cached.vertexCount * sizeof(CompactVertex) + cached.indexCount * sizeof(IndexFormat);
+                const size_t storedSize = cached.vertexSize + cached.indexSize;
+                const double seconds = std::chrono::duration<double>(te - tsUnpack).count();
+                std::cout << std::format("    compressed {0} -> {1} bytes ({2:.2f}x), decoded at {3:.2f} GB/s ({4})\n",
+                                         rawSize, storedSize, double(rawSize) / std::max<size_t>(1, storedSize),
+                                         rawSize / std::max(seconds, 1e-9) / 1e9, MeshCodec::decoderName());
+            }
+            return cached.boundingBox;
+        }
+        std::cerr << std::format("Corrupt mesh cache entry, reloading: '{}'\n", modelPath);
+        mesh = Mesh{};
+    }
+
+    // cold path: parse the obj and write a cache entry for the next load
+    util::loadObj(modelPath, mesh.vertices, mesh.indices);
+    if (optimize) _optimizeMesh(modelPath, mesh);
+    _buildLods(modelPath, mesh);
     AABB aabb = AABB::calculateBoundingBox(mesh.vertices);
-    // add the scene object to the scene
-    m_scene->addSceneObject({
-        std::move(mesh),
-        std::move(transforms), instanceCount,
-        tga::loadTexture(modelDiffusePath, tga::Format::r8g8b8a8_srgb, tga::SamplerMode::linear, tgai, true),
-        std::move(aabb)
-    });
-    m_modelNameToSceneObject.insert(
-        std::make_pair<std::string, uint32_t>(std::string(modelName), m_scene->m_sceneObjects.size() - 1));
-    std::cout << std::format("added new model: {0}\n", modelName);
 
-    return true;
+    // clusters for gpu culling, built from the final index order of every lod
+    MeshOptimizer::buildMeshlets(mesh.vertices, mesh.indices, mesh.lods, mesh.meshlets);
+    std::cout << std::format("built meshlets: {0} ({1:.1f} triangles/meshlet)\n", mesh.meshlets.size(),
+                             mesh.indices.size() / 3.0 / std::max<size_t>(1, mesh.meshlets.size()));
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
+    std::cout << std::format("loaded mesh from obj: {0} ({1:.2f} ms)\n", modelPath, ms);
+
+    if (!MeshCache::store(modelPath, cacheFlags, mesh.vertices, mesh.indices, mesh.lods, mesh.meshlets, aabb))
+        std::cerr << std::format("Failed to write the mesh cache entry for: '{}'\n", modelPath);
+
+    return aabb;
+}
+
+void SceneSerializer::_optimizeMesh(const std::string& modelPath, Mesh& mesh) {
+    using CacheModel = MeshOptimizer::CacheModel;
+    constexpr uint32_t lruCacheSize = 32;
+
+    auto fifoBefore = MeshOptimizer::analyzeVertexCache(mesh.indices, mesh.vertices.size());
+    auto lruBefore = MeshOptimizer::analyzeVertexCache(mesh.indices, mesh.vertices.size(), lruCacheSize, CacheModel::lru);
+
+    auto ts = std::chrono::steady_clock::now();
+    MeshOptimizer::optimizeVertexCache(mesh.indices, mesh.vertices.size());
+    MeshOptimizer::optimizeVertexFetch(mesh.vertices, mesh.indices);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
+
+    auto fifoAfter = MeshOptimizer::analyzeVertexCache(mesh.indices, mesh.vertices.size());
+    auto lruAfter = MeshOptimizer::analyzeVertexCache(mesh.indices, mesh.vertices.size(), lruCacheSize, CacheModel::lru);
+
+    std::cout << std::format("optimized mesh: {0} ({1:.2f} ms)\n", modelPath, ms)
+              << std::format("    fifo{0}: acmr {1:.3f} -> {2:.3f}, atvr {3:.3f} -> {4:.3f}\n",
+                             MeshOptimizer::DEFAULT_CACHE_SIZE, fifoBefore.acmr, fifoAfter.acmr, fifoBefore.atvr,
+                             fifoAfter.atvr)
+              << std::format("    lru{0}: acmr {1:.3f} -> {2:.3f}, atvr {3:.3f} -> {4:.3f}\n", lruCacheSize,
+                             lruBefore.acmr, lruAfter.acmr, lruBefore.atvr, lruAfter.atvr);
+}
+
+void SceneSerializer::_buildLods(const std::string& modelPath, Mesh& mesh) {
+    auto ts = std::chrono::steady_clock::now();
+    MeshOptimizer::buildLodChain(mesh.vertices, mesh.indices, mesh.lods);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
+
+    std::cout << std::format("built lods: {0} ({1:.2f} ms)\n", modelPath, ms);
+    for (size_t i = 0; i < mesh.lods.size(); i++)
+        std::cout << std::format("    lod{0}: {1} triangles, error {2:.4f}\n", i, mesh.lods[i].indexCount / 3,
+                                 mesh.lods[i].error);
 }
 
 bool SceneSerializer::_deserializeModelConfig(const YAML::Node& data, glm::vec3& position, float& scale,
-                                              uint32_t& instanceCount) {
+                                              uint32_t& instanceCount, bool& optimizeMesh,
+                                              TextureCache::Encoding& diffuseEncoding) {
     bool isDeserialized = true;
 
     try {
-        // deserialize instance count
+        // deserialize instance count, wide enough that a negative or huge count is seen and not wrapped
         auto n_instanceCount = data["instance_count"];
-        instanceCount = !n_instanceCount ? 1 : n_instanceCount.as<int32_t>();
+        const int64_t count = !n_instanceCount ? 1 : n_instanceCount.as<int64_t>();
+        if (count < 0 || count > MAX_INSTANCE_COUNT) {
+            std::cerr << std::format("Error: instance_count {0} is not in [0, {1}]\n", count, MAX_INSTANCE_COUNT);
+            return false;
+        }
+        instanceCount = static_cast<uint32_t>(count);
 
         // deserialize position
         auto n_position = data["position"];
@@ -159,7 +433,21 @@ bool SceneSerializer::_deserializeModelConfig(const YAML::Node& data, glm::vec3&
         auto n_scale = data["scale"];
         scale = !n_scale ? 1.0f : n_scale.as<float>();
 
-    } catch (YAML::RepresentationException e) {
+        // deserialize mesh optimization toggle
+        auto n_optimizeMesh = data["optimize_mesh"];
+        optimizeMesh = !n_optimizeMesh ? true : n_optimizeMesh.as<bool>();
+
+        // deserialize diffuse map compression: none, bc1 or bc7
+        auto n_diffuseCompression = data["diffuse_compression"];
+        const std::string diffuseCompression = !n_diffuseCompression ? "none" : n_diffuseCompression.as<std::string>();
+        if (diffuseCompression == "bc1")
+            diffuseEncoding = TextureCache::Encoding::bc1;
+        else if (diffuseCompression == "bc7")
+            diffuseEncoding = TextureCache::Encoding::bc7;
+        else
+            diffuseEncoding = TextureCache::Encoding::rgba8;
+
+    } catch (const YAML::Exception& e) {
         isDeserialized = false;
     }
 
@@ -170,8 +458,8 @@ bool SceneSerializer::_loadYAML(const std::string& path, YAML::Node& data) {
     bool isLoaded = true;
     try {
         data = YAML::LoadFile(path);
-    } catch (YAML::ParserException e) {
-        std::cerr << std::format("Failed to load or parse a file: '{}'\n", path) << std::endl;
+    } catch (const YAML::Exception& e) {  // BadFile, ParserException, ...
+        std::cerr << std::format("Failed to load or parse a file: '{0}': {1}\n", path, e.what());
         isLoaded = false;
     }
 
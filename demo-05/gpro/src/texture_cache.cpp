@@ -0,0 +1,166 @@
+#include "gpro/texture_cache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "gpro/file.hpp"
+#include "gpro/texture_encoder.hpp"
+#include "gpro/utils.hpp"
+
+namespace gpro {
+
+static constexpr uint64_t s_dataAlignment = 16;
+
+std::string TextureCache::entryPath(const std::string& sourcePath) {
+    const std::string absolutePath = std::filesystem::absolute(sourcePath).generic_string();
+    const uint64_t key = util::hashBytes(reinterpret_cast<const uint8_t *>(absolutePath.data()), absolutePath.size());
+    return gpro::cachePath(std::format("textures/{:016x}.texture", key));
+}
+
+const char *TextureCache::encodingName(Encoding encoding) {
+    switch (encoding) {
+        case Encoding::bc1: return "bc1";
+        case Encoding::bc7: return "bc7";
+        default: return "rgba8";
+    }
+}
+
+uint32_t TextureCache::pageCount(uint32_t width, uint32_t height, uint32_t pageSize) {
+    return ((width + pageSize - 1) / pageSize) * ((height + pageSize - 1) / pageSize);
+}
+
+// rows -> pageSize^2 pages, row-major, edge pages padded by repeating the last row/column
+static std::vector<uint8_t> toPages(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height,
+                                    uint32_t pageSize) {
+    const uint32_t pagesX = (width + pageSize - 1) / pageSize;
+    const size_t pageBytes = size_t(pageSize) * pageSize * 4;
+    std::vector<uint8_t> pages(TextureCache::pageCount(width, height, pageSize) * pageBytes);
+
+    uint8_t *dst = pages.data();
+    for (uint32_t page = 0; page < pages.size() / pageBytes; page++) {
+        const uint32_t x0 = (page % pagesX) * pageSize;
+        const uint32_t y0 = (page / pagesX) * pageSize;
+        for (uint32_t y = 0; y < pageSize; y++, dst += pageSize * 4) {
+            const uint8_t *row = rgba.data() + size_t(std::min(y0 + y, height - 1)) * width * 4;
+            const uint32_t copyWidth = std::min(pageSize, width - x0);
+            std::memcpy(dst, row + size_t(x0) * 4, copyWidth * 4);
+            for (uint32_t x = copyWidth; x < pageSize; x++) std::memcpy(dst + x * 4, row + (width - 1) * 4, 4);
+        }
+    }
+    return pages;
+}
+
+bool TextureCache::load(const std::string& sourcePath, Encoding encoding, bool isSRGB, uint32_t pageSize,
+                        MappedTexture& out) {
+    MappedFile file(entryPath(sourcePath));
+    if (!file.isOpen() || file.size() < sizeof(Header)) return false;
+
+    Header header;
+    std::memcpy(&header, file.data(), sizeof(Header));
+
+    // format checks
+    if (header.magic != MAGIC || header.version != VERSION || header.encoding != encoding ||
+        header.isSRGB != static_cast<uint32_t>(isSRGB) || header.pageSize != pageSize || header.levelCount == 0)
+        return false;
+
+    if (!util::isInFile(sizeof(Header), header.sourcePathLength, file.size())) return false;
+    const uint64_t levelTableOffset = util::alignUp(sizeof(Header) + header.sourcePathLength, s_dataAlignment);
+    if (!util::isArrayInFile(levelTableOffset, header.levelCount, sizeof(LevelHeader), file.size())) return false;
+
+    // key checks: path, then write time + size, falling back to the content hash for touched files
+    const std::string absolutePath = std::filesystem::absolute(sourcePath).generic_string();
+    const std::string_view storedPath(reinterpret_cast<const char *>(file.data() + sizeof(Header)),
+                                      header.sourcePathLength);
+    if (storedPath != absolutePath) return false;
+    if (!util::isFileUnchanged(sourcePath, header.sourceWriteTime, header.sourceSize, header.sourceHash)) return false;
+
+    out.levels.clear();
+    out.levels.reserve(header.levelCount);
+    for (uint32_t i = 0; i < header.levelCount; i++) {
+        LevelHeader level;
+        std::memcpy(&level, file.data() + levelTableOffset + i * sizeof(LevelHeader), sizeof(LevelHeader));
+        if (!util::isInFile(level.offset, level.size, file.size())) return false;
+        out.levels.push_back({level.width, level.height, file.data() + level.offset, level.size});
+    }
+    out.encoding = header.encoding;
+    out.pageSize = header.pageSize;
+    out.file = std::move(file);
+
+    return true;
+}
+
+bool TextureCache::store(const std::string& sourcePath, Encoding encoding, bool isSRGB, uint32_t pageSize,
+                         const tga::Image& image) {
+    if (image.components != 4 || (pageSize > 0 && encoding != Encoding::rgba8)) return false;
+
+    Header header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.encoding = encoding;
+    header.isSRGB = isSRGB;
+    header.width = image.width;
+    header.height = image.height;
+    header.pageSize = pageSize;
+    if (!util::fileStamp(sourcePath, header.sourceWriteTime, header.sourceSize)) return false;
+    if (!util::hashFile(sourcePath, header.sourceHash)) return false;
+
+    // mips + encoding
+    std::vector<TextureEncoder::Level> levels =
+        TextureEncoder::buildMipChain(image.data.data(), image.width, image.height, isSRGB);
+    for (auto& level : levels) {
+        if (encoding == Encoding::bc1)
+            level.data = TextureEncoder::encodeBC1(level.data.data(), level.width, level.height);
+        else if (encoding == Encoding::bc7)
+            level.data = TextureEncoder::encodeBC7(level.data.data(), level.width, level.height);
+        else if (pageSize > 0)
+            level.data = toPages(level.data, level.width, level.height, pageSize);
+    }
+
+    const std::string absolutePath = std::filesystem::absolute(sourcePath).generic_string();
+    header.sourcePathLength = absolutePath.size();
+    header.levelCount = static_cast<uint32_t>(levels.size());
+
+    const uint64_t levelTableOffset = util::alignUp(sizeof(Header) + absolutePath.size(), s_dataAlignment);
+    std::vector<LevelHeader> levelHeaders;
+    uint64_t offset = util::alignUp(levelTableOffset + levels.size() * sizeof(LevelHeader), s_dataAlignment);
+    for (const auto& level : levels) {
+        levelHeaders.push_back({level.width, level.height, offset, level.data.size()});
+        offset = util::alignUp(offset + level.data.size(), s_dataAlignment);
+    }
+
+    // write to a temporary file first, so a half-written entry is never picked up
+    const std::string path = entryPath(sourcePath);
+    const std::string tmpPath = path + ".tmp";
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    {
+        std::ofstream stream(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!stream) return false;
+
+        const char padding[s_dataAlignment] = {};
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+        stream.write(absolutePath.data(), absolutePath.size());
+        stream.write(padding, levelTableOffset - sizeof(Header) - absolutePath.size());
+        stream.write(reinterpret_cast<const char *>(levelHeaders.data()), levelHeaders.size() * sizeof(LevelHeader));
+
+        uint64_t position = levelTableOffset + levelHeaders.size() * sizeof(LevelHeader);
+        for (size_t i = 0; i < levels.size(); i++) {
+            stream.write(padding, levelHeaders[i].offset - position);
+            stream.write(reinterpret_cast<const char *>(levels[i].data.data()), levels[i].data.size());
+            position = levelHeaders[i].offset + levels[i].data.size();
+        }
+        if (!stream) return false;
+    }
+
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+
+    return true;
+}
+
+}  // namespace gpro
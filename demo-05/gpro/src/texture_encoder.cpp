@@ -0,0 +1,554 @@
+#include "gpro/texture_encoder.hpp"
+
+#include <array>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define GPRO_ENCODER_SSE
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#define GPRO_ENCODER_NEON
+#include <arm_neon.h>
+#endif
+
+namespace gpro {
+
+namespace {
+
+// the mip chain is filtered in 16-bit: linear light for srgb color, plain unorm otherwise
+struct LinearTables {
+    std::array<uint16_t, 256> srgbToLinear;
+    std::array<uint8_t, 4096> linearToSRGB;  // indexed by the top 12 bits
+
+    LinearTables() {
+        for (uint32_t i = 0; i < 256; i++) {
+            const float c = i / 255.f;
+            const float l = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            srgbToLinear[i] = static_cast<uint16_t>(std::round(l * 65535.f));
+        }
+        for (uint32_t i = 0; i < 4096; i++) {
+            const float l = (i + 0.5f) / 4096.f;
+            const float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.f / 2.4f) - 0.055f;
+            linearToSRGB[i] = static_cast<uint8_t>(std::round(std::clamp(c, 0.f, 1.f) * 255.f));
+        }
+    }
+};
+
+const LinearTables& linearTables() {
+    static const LinearTables tables;
+    return tables;
+}
+
+struct Level16 {
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint16_t> data;  // rgba16
+};
+
+// rgba8 -> rgba16 (v * 257), srgb color is then replaced through the table
+void widenRow(const uint8_t *rgba, size_t count, bool isSRGB, uint16_t *out) {
+    size_t i = 0;
+#if defined(GPRO_ENCODER_SSE)
+    for (; i + 16 <= count; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgba + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_unpacklo_epi8(v, v));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 8), _mm_unpackhi_epi8(v, v));
+    }
+#elif defined(GPRO_ENCODER_NEON)
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16_t v = vld1q_u8(rgba + i);
+        vst1q_u8(reinterpret_cast<uint8_t *>(out + i), vzip1q_u8(v, v));
+        vst1q_u8(reinterpret_cast<uint8_t *>(out + i + 8), vzip2q_u8(v, v));
+    }
+#endif
+    for (; i < count; i++) out[i] = static_cast<uint16_t>(rgba[i] * 257);
+    if (!isSRGB) return;
+
+    const auto& tables = linearTables();
+    for (size_t i = 0; i < count; i += 4) {
+        out[i] = tables.srgbToLinear[rgba[i]];
+        out[i + 1] = tables.srgbToLinear[rgba[i + 1]];
+        out[i + 2] = tables.srgbToLinear[rgba[i + 2]];
+    }
+}
+
+TextureEncoder::Level toLevel8(const Level16& level16, bool isSRGB) {
+    const auto& tables = linearTables();
+    TextureEncoder::Level level{level16.width, level16.height, std::vector<uint8_t>(level16.data.size())};
+    const uint16_t *src = level16.data.data();
+    uint8_t *out = level.data.data();
+    const size_t count = level.data.size();
+
+    // round(v / 257) as (t - (t >> 8)) >> 8 with t = v + 128, saturated
+    size_t i = 0;
+#if defined(GPRO_ENCODER_SSE)
+    const __m128i half = _mm_set1_epi16(128);
+    for (; i + 16 <= count; i += 16) {
+        __m128i t0 = _mm_adds_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)), half);
+        __m128i t1 = _mm_adds_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 8)), half);
+        t0 = _mm_srli_epi16(_mm_sub_epi16(t0, _mm_srli_epi16(t0, 8)), 8);
+        t1 = _mm_srli_epi16(_mm_sub_epi16(t1, _mm_srli_epi16(t1, 8)), 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(t0, t1));
+    }
+#elif defined(GPRO_ENCODER_NEON)
+    const uint16x8_t half = vdupq_n_u16(128);
+    for (; i + 16 <= count; i += 16) {
+        uint16x8_t t0 = vqaddq_u16(vld1q_u16(src + i), half);
+        uint16x8_t t1 = vqaddq_u16(vld1q_u16(src + i + 8), half);
+        t0 = vshrq_n_u16(vsubq_u16(t0, vshrq_n_u16(t0, 8)), 8);
+        t1 = vshrq_n_u16(vsubq_u16(t1, vshrq_n_u16(t1, 8)), 8);
+        vst1q_u8(out + i, vcombine_u8(vmovn_u16(t0), vmovn_u16(t1)));
+    }
+#endif
+    for (; i < count; i++) out[i] = static_cast<uint8_t>((src[i] + 128) / 257);
+    if (isSRGB) {
+        for (size_t i = 0; i < count; i += 4) {
+            out[i] = tables.linearToSRGB[src[i] >> 4];
+            out[i + 1] = tables.linearToSRGB[src[i + 1] >> 4];
+            out[i + 2] = tables.linearToSRGB[src[i + 2] >> 4];
+        }
+    }
+    return level;
+}
+
+inline uint16_t roundedAverage(uint16_t a, uint16_t b) { return static_cast<uint16_t>((a + b + 1) >> 1); }
+
+// one output row of the 2x2 box filter, two output texels (four input texels of both rows) per simd step.
+// odd widths clamp the second column instead of widening the filter
+void downsampleRow(const uint16_t *row0, const uint16_t *row1, uint32_t srcWidth, uint32_t dstWidth,
+                   uint16_t *out) {
+    uint32_t x = 0;
+#if defined(GPRO_ENCODER_SSE)
+    for (; 2 * x + 3 < srcWidth; x += 2) {
+        const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + 8 * x));
+        const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + 8 * x + 8));
+        const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + 8 * x));
+        const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + 8 * x + 8));
+        const __m128i v0 = _mm_avg_epu16(a0, b0);  // texels 2x, 2x + 1
+        const __m128i v1 = _mm_avg_epu16(a1, b1);  // texels 2x + 2, 2x + 3
+        const __m128i v = _mm_avg_epu16(_mm_unpacklo_epi64(v0, v1), _mm_unpackhi_epi64(v0, v1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 4 * x), v);
+    }
+#elif defined(GPRO_ENCODER_NEON)
+    for (; 2 * x + 3 < srcWidth; x += 2) {
+        const uint16x8_t v0 = vrhaddq_u16(vld1q_u16(row0 + 8 * x), vld1q_u16(row1 + 8 * x));
+        const uint16x8_t v1 = vrhaddq_u16(vld1q_u16(row0 + 8 * x + 8), vld1q_u16(row1 + 8 * x + 8));
+        const uint16x8_t v = vrhaddq_u16(vcombine_u16(vget_low_u16(v0), vget_low_u16(v1)),
+                                         vcombine_u16(vget_high_u16(v0), vget_high_u16(v1)));
+        vst1q_u16(out + 4 * x, v);
+    }
+#endif
+    // same rounding as the simd path
+    for (; x < dstWidth; x++) {
+        const uint32_t x0 = std::min(2 * x, srcWidth - 1) * 4;
+        const uint32_t x1 = std::min(2 * x + 1, srcWidth - 1) * 4;
+        for (int c = 0; c < 4; c++) {
+            out[4 * x + c] = roundedAverage(roundedAverage(row0[x0 + c], row1[x0 + c]),
+                                            roundedAverage(row0[x1 + c], row1[x1 + c]));
+        }
+    }
+}
+
+Level16 halfSize(uint32_t width, uint32_t height) {
+    Level16 level{std::max(1u, width / 2), std::max(1u, height / 2), {}};
+    level.data.resize(size_t(level.width) * level.height * 4);
+    return level;
+}
+
+void downsample(const Level16& src, Level16& dst) {
+    dst = halfSize(src.width, src.height);
+    for (uint32_t y = 0; y < dst.height; y++) {
+        const uint16_t *row0 = src.data.data() + size_t(std::min(2 * y, src.height - 1)) * src.width * 4;
+        const uint16_t *row1 = src.data.data() + size_t(std::min(2 * y + 1, src.height - 1)) * src.width * 4;
+        downsampleRow(row0, row1, src.width, dst.width, dst.data.data() + size_t(y) * dst.width * 4);
+    }
+}
+
+// the first level straight from rgba8, widening two rows at a time instead of the whole image
+void downsample(const uint8_t *rgba, uint32_t width, uint32_t height, bool isSRGB, Level16& dst) {
+    dst = halfSize(width, height);
+    std::vector<uint16_t> rows(size_t(width) * 8);
+    uint16_t *row0 = rows.data();
+    uint16_t *row1 = rows.data() + size_t(width) * 4;
+    for (uint32_t y = 0; y < dst.height; y++) {
+        widenRow(rgba + size_t(std::min(2 * y, height - 1)) * width * 4, size_t(width) * 4, isSRGB, row0);
+        widenRow(rgba + size_t(std::min(2 * y + 1, height - 1)) * width * 4, size_t(width) * 4, isSRGB, row1);
+        downsampleRow(row0, row1, width, dst.width, dst.data.data() + size_t(y) * dst.width * 4);
+    }
+}
+
+// 4x4 texels of a block, edges clamped
+void fetchBlock(const uint8_t *rgba, uint32_t width, uint32_t height, uint32_t bx, uint32_t by,
+                float (&texels)[16][4]) {
+    for (uint32_t y = 0; y < 4; y++) {
+        const uint32_t sy = std::min(by * 4 + y, height - 1);
+        for (uint32_t x = 0; x < 4; x++) {
+            const uint32_t sx = std::min(bx * 4 + x, width - 1);
+            const uint8_t *texel = rgba + (size_t(sy) * width + sx) * 4;
+            for (uint32_t c = 0; c < 4; c++) texels[y * 4 + x][c] = texel[c];
+        }
+    }
+}
+
+// endpoints on the principal axis of the block (power iteration), inset by 1/16 of the range
+template <int C>
+void fitEndpoints(const float (&texels)[16][4], float (&e0)[C], float (&e1)[C]) {
+    float mean[C] = {};
+    for (const auto& t : texels)
+        for (int c = 0; c < C; c++) mean[c] += t[c] / 16.f;
+
+    float covariance[C][C] = {};
+    for (const auto& t : texels)
+        for (int i = 0; i < C; i++)
+            for (int j = 0; j < C; j++) covariance[i][j] += (t[i] - mean[i]) * (t[j] - mean[j]);
+
+    float axis[C];
+    for (int c = 0; c < C; c++) axis[c] = 1.f;
+    for (int iteration = 0; iteration < 8; iteration++) {
+        float next[C] = {};
+        float length = 0;
+        for (int i = 0; i < C; i++) {
+            for (int j = 0; j < C; j++) next[i] += covariance[i][j] * axis[j];
+            length = std::max(length, std::abs(next[i]));
+        }
+        if (length < 1e-6f) break;
+        for (int c = 0; c < C; c++) axis[c] = next[c] / length;
+    }
+
+    float minProjection = std::numeric_limits<float>::max();
+    float maxProjection = std::numeric_limits<float>::lowest();
+    for (const auto& t : texels) {
+        float projection = 0;
+        for (int c = 0; c < C; c++) projection += (t[c] - mean[c]) * axis[c];
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+
+    const float inset = (maxProjection - minProjection) / 16.f;
+    for (int c = 0; c < C; c++) {
+        e0[c] = std::clamp(mean[c] + axis[c] * (maxProjection - inset), 0.f, 255.f);
+        e1[c] = std::clamp(mean[c] + axis[c] * (minProjection + inset), 0.f, 255.f);
+    }
+}
+
+// least squares endpoints for fixed palette weights (0 -> e0, 1 -> e1), false if the system is degenerate
+template <int C>
+bool refineEndpoints(const float (&texels)[16][4], const float (&weights)[16], float (&e0)[C], float (&e1)[C]) {
+    float a = 0, b = 0, d = 0;
+    float x0[C] = {}, x1[C] = {};
+    for (int i = 0; i < 16; i++) {
+        const float w = weights[i];
+        a += (1 - w) * (1 - w);
+        b += (1 - w) * w;
+        d += w * w;
+        for (int c = 0; c < C; c++) {
+            x0[c] += (1 - w) * texels[i][c];
+            x1[c] += w * texels[i][c];
+        }
+    }
+
+    const float determinant = a * d - b * b;
+    if (std::abs(determinant) < 1e-6f) return false;
+    for (int c = 0; c < C; c++) {
+        e0[c] = std::clamp((d * x0[c] - b * x1[c]) / determinant, 0.f, 255.f);
+        e1[c] = std::clamp((a * x1[c] - b * x0[c]) / determinant, 0.f, 255.f);
+    }
+    return true;
+}
+
+// nearest palette entry per texel, returns the squared error of the block
+template <int C>
+float assignIndices(const float (&texels)[16][4], const float (*palette)[4], int paletteSize, uint8_t (&indices)[16]) {
+    float error = 0;
+    for (int i = 0; i < 16; i++) {
+        float best = std::numeric_limits<float>::max();
+        for (int p = 0; p < paletteSize; p++) {
+            float distance = 0;
+            for (int c = 0; c < C; c++) distance += (texels[i][c] - palette[p][c]) * (texels[i][c] - palette[p][c]);
+            if (distance < best) {
+                best = distance;
+                indices[i] = static_cast<uint8_t>(p);
+            }
+        }
+        error += best;
+    }
+    return error;
+}
+
+/* ----------------------------------- bc1 ---------------------------------- */
+
+uint16_t packRGB565(const float (&color)[3]) {
+    const uint32_t r = static_cast<uint32_t>(std::round(color[0] * 31.f / 255.f));
+    const uint32_t g = static_cast<uint32_t>(std::round(color[1] * 63.f / 255.f));
+    const uint32_t b = static_cast<uint32_t>(std::round(color[2] * 31.f / 255.f));
+    return static_cast<uint16_t>(r << 11 | g << 5 | b);
+}
+
+void unpackRGB565(uint16_t packed, float (&color)[4]) {
+    const uint32_t r = packed >> 11 & 31, g = packed >> 5 & 63, b = packed & 31;
+    color[0] = static_cast<float>(r << 3 | r >> 2);
+    color[1] = static_cast<float>(g << 2 | g >> 4);
+    color[2] = static_cast<float>(b << 3 | b >> 2);
+    color[3] = 255.f;
+}
+
+// palette in index order. c0 > c1: c0, c1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1,
+// otherwise c0, c1, 1/2 c0 + 1/2 c1, transparent black
+void bc1Palette(uint16_t c0, uint16_t c1, float (&palette)[4][4]) {
+    unpackRGB565(c0, palette[0]);
+    unpackRGB565(c1, palette[1]);
+    for (int c = 0; c < 4; c++) {
+        if (c0 > c1) {
+            palette[2][c] = std::floor((2 * palette[0][c] + palette[1][c]) / 3.f);
+            palette[3][c] = std::floor((palette[0][c] + 2 * palette[1][c]) / 3.f);
+        } else {
+            palette[2][c] = std::floor((palette[0][c] + palette[1][c]) / 2.f);
+            palette[3][c] = 0;
+        }
+    }
+}
+
+constexpr float BC1_WEIGHTS[4] = {0.f, 1.f, 1.f / 3.f, 2.f / 3.f};
+
+float encodeBC1Endpoints(const float (&texels)[16][4], const float (&e0)[3], const float (&e1)[3], uint8_t *block) {
+    uint16_t c0 = packRGB565(e0), c1 = packRGB565(e1);
+    // c0 > c1 selects the 4-color mode
+    if (c0 < c1) std::swap(c0, c1);
+
+    float palette[4][4];
+    bc1Palette(c0, c1, palette);
+    uint8_t indices[16] = {};
+    // equal endpoints decode in 3-color mode, only index 0 is safe there
+    const float error = assignIndices<3>(texels, palette, c0 == c1 ? 1 : 4, indices);
+
+    uint32_t bits = 0;
+    for (int i = 0; i < 16; i++) bits |= static_cast<uint32_t>(indices[i]) << (i * 2);
+    std::memcpy(block, &c0, 2);
+    std::memcpy(block + 2, &c1, 2);
+    std::memcpy(block + 4, &bits, 4);
+    return error;
+}
+
+void encodeBC1Block(const float (&texels)[16][4], uint8_t *block) {
+    float e0[3], e1[3];
+    fitEndpoints<3>(texels, e0, e1);
+    float error = encodeBC1Endpoints(texels, e0, e1, block);
+
+    // one least squares pass over the chosen indices
+    uint32_t bits;
+    std::memcpy(&bits, block + 4, 4);
+    uint16_t c0, c1;
+    std::memcpy(&c0, block, 2);
+    std::memcpy(&c1, block + 2, 2);
+    if (c0 == c1) return;
+
+    float weights[16];
+    for (int i = 0; i < 16; i++) weights[i] = BC1_WEIGHTS[bits >> (i * 2) & 3];
+    if (!refineEndpoints<3>(texels, weights, e0, e1)) return;
+
+    uint8_t refined[TextureEncoder::BC1_BLOCK_BYTES];
+    if (encodeBC1Endpoints(texels, e0, e1, refined) < error) std::memcpy(block, refined, sizeof(refined));
+}
+
+/* ----------------------------------- bc7 ---------------------------------- */
+
+constexpr uint32_t BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+// 7-bit endpoint + p-bit closest to the color
+void quantizeBC7Endpoint(const float (&color)[4], uint32_t (&quantized)[4], uint32_t& pBit) {
+    float bestError = std::numeric_limits<float>::max();
+    for (uint32_t p = 0; p < 2; p++) {
+        uint32_t q[4];
+        float error = 0;
+        for (int c = 0; c < 4; c++) {
+            q[c] = static_cast<uint32_t>(std::clamp(std::round((color[c] - p) / 2.f), 0.f, 127.f));
+            const float reconstructed = static_cast<float>(q[c] << 1 | p);
+            error += (reconstructed - color[c]) * (reconstructed - color[c]);
+        }
+        if (error < bestError) {
+            bestError = error;
+            pBit = p;
+            std::copy(q, q + 4, quantized);
+        }
+    }
+}
+
+void bc7Palette(const uint32_t (&q0)[4], uint32_t p0, const uint32_t (&q1)[4], uint32_t p1, float (&palette)[16][4]) {
+    for (int c = 0; c < 4; c++) {
+        const uint32_t a = q0[c] << 1 | p0, b = q1[c] << 1 | p1;
+        for (int i = 0; i < 16; i++)
+            palette[i][c] = static_cast<float>(((64 - BC7_WEIGHTS[i]) * a + BC7_WEIGHTS[i] * b + 32) >> 6);
+    }
+}
+
+void writeBits(uint8_t *block, uint32_t& position, uint32_t value, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++, position++) {
+        if (value >> i & 1) block[position / 8] |= static_cast<uint8_t>(1 << (position % 8));
+    }
+}
+
+uint32_t readBits(const uint8_t *block, uint32_t& position, uint32_t count) {
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < count; i++, position++) {
+        value |= static_cast<uint32_t>(block[position / 8] >> (position % 8) & 1) << i;
+    }
+    return value;
+}
+
+float encodeBC7Endpoints(const float (&texels)[16][4], const float (&e0)[4], const float (&e1)[4], uint8_t *block) {
+    uint32_t q0[4], q1[4], p0, p1;
+    quantizeBC7Endpoint(e0, q0, p0);
+    quantizeBC7Endpoint(e1, q1, p1);
+
+    float palette[16][4];
+    bc7Palette(q0, p0, q1, p1, palette);
+    uint8_t indices[16];
+    const float error = assignIndices<4>(texels, palette, 16, indices);
+
+    // the msb of the first index is implicit 0, swap the endpoints to get there
+    if (indices[0] >= 8) {
+        std::swap(q0, q1);
+        std::swap(p0, p1);
+        for (auto& index : indices) index = 15 - index;
+    }
+
+    std::memset(block, 0, TextureEncoder::BC7_BLOCK_BYTES);
+    uint32_t position = 0;
+    writeBits(block, position, 1 << 6, 7);  // mode 6
+    for (int c = 0; c < 4; c++) {
+        writeBits(block, position, q0[c], 7);
+        writeBits(block, position, q1[c], 7);
+    }
+    writeBits(block, position, p0, 1);
+    writeBits(block, position, p1, 1);
+    for (int i = 0; i < 16; i++) writeBits(block, position, indices[i], i == 0 ? 3 : 4);
+    return error;
+}
+
+void decodeBC7Indices(const uint8_t *block, uint8_t (&indices)[16]) {
+    uint32_t position = 65;
+    for (int i = 0; i < 16; i++) indices[i] = static_cast<uint8_t>(readBits(block, position, i == 0 ? 3 : 4));
+}
+
+void encodeBC7Block(const float (&texels)[16][4], uint8_t *block) {
+    float e0[4], e1[4];
+    fitEndpoints<4>(texels, e0, e1);
+    const float error = encodeBC7Endpoints(texels, e0, e1, block);
+
+    // one least squares pass, weights follow the (possibly swapped) endpoints written to the block
+    uint8_t indices[16];
+    decodeBC7Indices(block, indices);
+    float weights[16];
+    for (int i = 0; i < 16; i++) weights[i] = BC7_WEIGHTS[indices[i]] / 64.f;
+    if (!refineEndpoints<4>(texels, weights, e0, e1)) return;
+
+    uint8_t refined[TextureEncoder::BC7_BLOCK_BYTES];
+    if (encodeBC7Endpoints(texels, e0, e1, refined) < error) std::memcpy(block, refined, sizeof(refined));
+}
+
+// calls encode(texels, block) for every block, row major
+template <typename Encode>
+std::vector<uint8_t> encodeBlocks(const uint8_t *rgba, uint32_t width, uint32_t height, uint32_t blockBytes,
+                                  Encode encode) {
+    const uint32_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    std::vector<uint8_t> blocks(size_t(blocksX) * blocksY * blockBytes);
+
+    float texels[16][4];
+    for (uint32_t by = 0; by < blocksY; by++) {
+        for (uint32_t bx = 0; bx < blocksX; bx++) {
+            fetchBlock(rgba, width, height, bx, by, texels);
+            encode(texels, blocks.data() + (size_t(by) * blocksX + bx) * blockBytes);
+        }
+    }
+    return blocks;
+}
+
+// writes the texels of a decoded block that lie inside the image
+void storeBlock(const float (*palette)[4], const uint8_t (&indices)[16], uint32_t bx, uint32_t by,
+                uint32_t width, uint32_t height, uint8_t *rgba) {
+    for (uint32_t y = 0; y < 4 && by * 4 + y < height; y++) {
+        for (uint32_t x = 0; x < 4 && bx * 4 + x < width; x++) {
+            uint8_t *texel = rgba + (size_t(by * 4 + y) * width + bx * 4 + x) * 4;
+            for (int c = 0; c < 4; c++) texel[c] = static_cast<uint8_t>(palette[indices[y * 4 + x]][c]);
+        }
+    }
+}
+
+}  // namespace
+
+std::vector<TextureEncoder::Level> TextureEncoder::buildMipChain(const uint8_t *rgba, uint32_t width,
+                                                                 uint32_t height, bool isSRGB) {
+    std::vector<Level> levels;
+    levels.push_back({width, height, std::vector<uint8_t>(rgba, rgba + size_t(width) * height * 4)});
+
+    if (width == 1 && height == 1) return levels;
+
+    Level16 current;
+    downsample(rgba, width, height, isSRGB, current);
+    levels.push_back(toLevel8(current, isSRGB));
+    while (current.width > 1 || current.height > 1) {
+        Level16 next;
+        downsample(current, next);
+        levels.push_back(toLevel8(next, isSRGB));
+        current = std::move(next);
+    }
+    return levels;
+}
+
+std::vector<uint8_t> TextureEncoder::encodeBC1(const uint8_t *rgba, uint32_t width, uint32_t height) {
+    return encodeBlocks(rgba, width, height, BC1_BLOCK_BYTES, encodeBC1Block);
+}
+
+std::vector<uint8_t> TextureEncoder::encodeBC7(const uint8_t *rgba, uint32_t width, uint32_t height) {
+    return encodeBlocks(rgba, width, height, BC7_BLOCK_BYTES, encodeBC7Block);
+}
+
+void TextureEncoder::decodeBC1(const uint8_t *blocks, uint32_t width, uint32_t height, uint8_t *rgba) {
+    const uint32_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    for (uint32_t by = 0; by < blocksY; by++) {
+        for (uint32_t bx = 0; bx < blocksX; bx++, blocks += BC1_BLOCK_BYTES) {
+            uint16_t c0, c1;
+            uint32_t bits;
+            std::memcpy(&c0, blocks, 2);
+            std::memcpy(&c1, blocks + 2, 2);
+            std::memcpy(&bits, blocks + 4, 4);
+
+            float palette[4][4];
+            bc1Palette(c0, c1, palette);
+            uint8_t indices[16];
+            for (int i = 0; i < 16; i++) indices[i] = bits >> (i * 2) & 3;
+            storeBlock(palette, indices, bx, by, width, height, rgba);
+        }
+    }
+}
+
+bool TextureEncoder::decodeBC7(const uint8_t *blocks, uint32_t width, uint32_t height, uint8_t *rgba) {
+    const uint32_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    for (uint32_t by = 0; by < blocksY; by++) {
+        for (uint32_t bx = 0; bx < blocksX; bx++, blocks += BC7_BLOCK_BYTES) {
+            if ((blocks[0] & 0x7F) != 1 << 6) return false;
+
+            uint32_t position = 7;
+            uint32_t q0[4], q1[4];
+            for (int c = 0; c < 4; c++) {
+                q0[c] = readBits(blocks, position, 7);
+                q1[c] = readBits(blocks, position, 7);
+            }
+            const uint32_t p0 = readBits(blocks, position, 1);
+            const uint32_t p1 = readBits(blocks, position, 1);
+
+            float palette[16][4];
+            bc7Palette(q0, p0, q1, p1, palette);
+            uint8_t indices[16];
+            decodeBC7Indices(blocks, indices);
+            storeBlock(palette, indices, bx, by, width, height, rgba);
+        }
+    }
+    return true;
+}
+
+size_t TextureEncoder::blockCompressedSize(uint32_t width, uint32_t height, uint32_t blockBytes) {
+    return size_t((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+}
+
+}  // namespace gpro
@@ -0,0 +1,179 @@
+#include "gpro/texture_loader.hpp"
+
+#include "gpro/cpu_profiler.hpp"
+#include "gpro/renderer.hpp"
+#include "gpro/texture_encoder.hpp"
+#include "gpro/utils.hpp"
+#include "tga/tga_utils.hpp"
+
+namespace gpro {
+
+#ifdef GPRO_VIRTUAL_TEXTURES
+static constexpr uint32_t s_pageSize = VirtualTextureStreamer::PAGE_SIZE;  // streamed from paged rgba8 entries
+#else
+static constexpr uint32_t s_pageSize = 0;
+#endif
+
+TextureLoader::TextureLoader(ThreadPool& threadPool) : m_threadPool(threadPool) {}
+
+void TextureLoader::request(const std::string& path, TextureCache::Encoding encoding) {
+    {
+        // the first request of a path decides its encoding
+        std::lock_guard lock(m_requestMutex);
+        if (!m_requested.insert(path).second) return;
+    }
+    _loadAsync(path, encoding);
+}
+
+void TextureLoader::processLoaded() {
+    TextureAsset asset;
+    uint32_t uploadCount = 0;
+    auto ts = std::chrono::steady_clock::now();
+    while (m_loadedTextures.tryPop(asset)) {
+        if (!asset.isLoaded) {
+            // forget failed paths, so the next request retries
+            std::lock_guard lock(m_requestMutex);
+            m_requested.erase(asset.path);
+            continue;
+        }
+
+#ifdef GPRO_VIRTUAL_TEXTURES
+        const uint32_t textureID = Renderer::get().virtualTextures().add(std::move(asset.texture));
+        if (textureID == VirtualTextureStreamer::INVALID_ID) {
+            std::lock_guard lock(m_requestMutex);
+            m_requested.erase(asset.path);
+            continue;
+        }
+        m_textureIDs.insert_or_assign(asset.path, textureID);
+#else
+        tga::Texture texture;
+        if (asset.image.data.empty()) {  // one copy from the mapped cache entry into the staging buffer
+            const auto& level = asset.texture.levels[0];
+            texture = util::createTexture(level.width, level.height, level.data, level.size,
+                                          tga::Format::r8g8b8a8_srgb, tga::SamplerMode::linear);
+        } else {
+            texture = util::createTexture(asset.image, tga::Format::r8g8b8a8_srgb, tga::SamplerMode::linear);
+        }
+        m_textureIDs.insert_or_assign(asset.path, Renderer::get().textureRegistry().add(texture));
+#endif
+        uploadCount++;
+    }
+
+    if (uploadCount > 0) {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
+        std::cout << std::format("uploaded textures: {0} ({1:.2f} ms)\n", uploadCount, ms);
+    }
+}
+
+bool TextureLoader::find(const std::string& path, uint32_t& textureID) const {
+    auto it = m_textureIDs.find(path);
+    if (it == m_textureIDs.end()) return false;
+    textureID = it->second;
+    return true;
+}
+
+bool TextureLoader::isPending(const std::string& path) {
+    if (m_textureIDs.contains(path)) return false;
+    std::lock_guard lock(m_requestMutex);
+    return m_requested.contains(path);
+}
+
+void TextureLoader::invalidate(const std::string& path) {
+    auto it = m_textureIDs.find(path);
+    if (it == m_textureIDs.end()) return;  // in flight or failed, the next request reads the file anyway
+#ifndef GPRO_VIRTUAL_TEXTURES
+    Renderer::get().textureRegistry().release(it->second);
+#endif
+    m_textureIDs.erase(it);
+
+    std::lock_guard lock(m_requestMutex);
+    m_requested.erase(path);
+}
+
+AsyncTask TextureLoader::_loadAsync(std::string path, TextureCache::Encoding encoding) {
+    // the rest runs on a worker
+    co_await m_threadPool.schedule();
+    GPRO_ZONE("load texture");
+
+    auto ts = std::chrono::steady_clock::now();
+    TextureAsset asset;
+    asset.path = path;
+    try {
+        asset.isLoaded = _load(path, encoding, asset);
+    } catch (const std::exception& e) {
+        std::cerr << std::format("Failed to load texture '{0}': {1}\n", path, e.what());
+    }
+    asset.loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
+
+    m_loadedTextures.push(std::move(asset));
+}
+
+bool TextureLoader::_load(const std::string& path, TextureCache::Encoding encoding, TextureAsset& asset) {
+    constexpr bool isSRGB = true;  // textures are sampled as r8g8b8a8_srgb
+    if (s_pageSize > 0) encoding = TextureCache::Encoding::rgba8;  // pages are not block compressed
+    auto ts = std::chrono::steady_clock::now();
+
+    // cold path: decode the png, build and encode the mips on the cpu and write the cache entry
+    if (!TextureCache::load(path, encoding, isSRGB, s_pageSize, asset.texture)) {
+        if (!_decodeImage(path, asset.image)) return false;
+        double decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
+
+        auto tsStore = std::chrono::steady_clock::now();
+        if (!TextureCache::store(path, encoding, isSRGB, s_pageSize, asset.image) ||
+            !TextureCache::load(path, encoding, isSRGB, s_pageSize, asset.texture)) {
+            std::cerr << std::format("Failed to write the texture cache entry for: '{}'\n", path);
+            return s_pageSize == 0;  // the decoded image is uploaded instead, pages are only streamed from the cache
+        }
+        double storeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tsStore).count();
+        std::cout << std::format("loaded texture from png: {0} ({1:.2f} ms decode, {2:.2f} ms mips + {3})\n", path,
+                                 decodeMs, storeMs, TextureCache::encodingName(encoding));
+        asset.image = {};
+        ts = std::chrono::steady_clock::now();
+    }
+
+    // tga textures have a single level in a plain format: upload level 0, block compressed levels are unpacked
+    const auto& level = asset.texture.levels[0];
+    if (encoding != TextureCache::Encoding::rgba8) {
+        asset.image.width = level.width;
+        asset.image.height = level.height;
+        asset.image.components = 4;
+        asset.image.data.resize(size_t(level.width) * level.height * 4);
+        if (encoding == TextureCache::Encoding::bc1)
+            TextureEncoder::decodeBC1(level.data, level.width, level.height, asset.image.data.data());
+        else if (!TextureEncoder::decodeBC7(level.data, level.width, level.height, asset.image.data.data()))
+            return false;
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
+    std::cout << std::format("loaded texture from cache: {0} ({1:.2f} ms, {2} levels, {3})\n", path, ms,
+                             asset.texture.levels.size(), TextureCache::encodingName(encoding));
+    return true;
+}
+
+bool TextureLoader::_decodeImage(const std::string& path, tga::Image& image) {
+    image = tga::loadImage(path);
+    if (image.width == 0 || image.height == 0 || image.components == 0) {
+        std::cerr << std::format("Failed to decode an image: '{}'\n", path);
+        return false;
+    }
+
+    // expand to rgba8 and flip vertically, as tga::loadTexture(..., doVerticalFlip = true) did
+    const size_t rowPixels = image.width;
+    std::vector<uint8_t> rgba(rowPixels * image.height * 4);
+    for (size_t y = 0; y < image.height; y++) {
+        const uint8_t *src = image.data.data() + (image.height - 1 - y) * rowPixels * image.components;
+        uint8_t *dst = rgba.data() + y * rowPixels * 4;
+        for (size_t x = 0; x < rowPixels; x++, src += image.components, dst += 4) {
+            const bool isGrey = image.components < 3;
+            dst[0] = src[0];
+            dst[1] = isGrey ? src[0] : src[1];
+            dst[2] = isGrey ? src[0] : src[2];
+            dst[3] = image.components == 2 || image.components == 4 ? src[image.components - 1] : 255;
+        }
+    }
+    image.data = std::move(rgba);
+    image.components = 4;
+    return true;
+}
+
+}  // namespace gpro
@@ -0,0 +1,65 @@
+#include "gpro/texture_registry.hpp"
+
+#include "gpro/utils.hpp"
+
+namespace gpro {
+
+void TextureRegistry::init() {
+    const uint8_t white[4] = {255, 255, 255, 255};
+    m_textures = {
+        util::createTexture(1, 1, white, sizeof(white), tga::Format::r8g8b8a8_srgb, tga::SamplerMode::nearest)};
+    m_refCounts = {1};  // never released
+    m_isDirty = true;
+}
+
+uint32_t TextureRegistry::add(tga::Texture texture) {
+    uint32_t id;
+    if (!m_freeIDs.empty()) {
+        id = m_freeIDs.back();
+        m_freeIDs.pop_back();
+        m_textures[id] = texture;
+    } else if (m_textures.size() < MAX_TEXTURE_COUNT) {
+        id = m_textures.size();
+        m_textures.push_back(texture);
+        m_refCounts.push_back(0);
+    } else {
+        std::cerr << std::format("Texture registry is full ({} textures), using the default texture\n",
+                                 MAX_TEXTURE_COUNT);
+        m_releasedTextures.release(texture);
+        retain(DEFAULT_TEXTURE_ID);
+        return DEFAULT_TEXTURE_ID;
+    }
+
+    m_refCounts[id] = 1;
+    m_isDirty = true;
+    return id;
+}
+
+void TextureRegistry::retain(uint32_t id) { m_refCounts[id]++; }
+
+void TextureRegistry::release(uint32_t id) {
+    if (--m_refCounts[id] > 0 || id == DEFAULT_TEXTURE_ID) return;
+
+    m_releasedTextures.release(m_textures[id]);
+    m_textures[id] = m_textures[DEFAULT_TEXTURE_ID];
+    m_freeIDs.push_back(id);
+    m_isDirty = true;
+}
+
+void TextureRegistry::update(tga::RenderPass renderPass, uint32_t setIndex) {
+    // free what no frame in flight uses anymore
+    m_releasedTextures.nextFrame();
+    m_releasedInputSets.nextFrame();
+
+    if (!m_isDirty) return;
+    m_isDirty = false;
+
+    tga::InputSetInfo info{renderPass, {}, setIndex};
+    for (uint32_t i = 0; i < MAX_TEXTURE_COUNT; i++) {
+        info.bindings.emplace_back(i < m_textures.size() ? m_textures[i] : m_textures[DEFAULT_TEXTURE_ID], 0, i);
+    }
+    m_releasedInputSets.release(m_inputSet);
+    m_inputSet = tgai.createInputSet(info);
+}
+
+}  // namespace gpro
@@ -0,0 +1,91 @@
+#include "gpro/thread_pool.hpp"
+
+#include <atomic>
+
+#include "gpro/cpu_profiler.hpp"
+
+namespace gpro {
+
+namespace {
+
+// shared by the calls of one parallelFor, outlives it if a worker only gets to it afterwards
+struct ParallelFor {
+    std::function<void(uint32_t)> fn;
+    uint32_t count;
+    std::atomic<uint32_t> nextIndex{0};
+    std::atomic<uint32_t> doneCount{0};
+
+    void run() {
+        for (uint32_t i = nextIndex.fetch_add(1); i < count; i = nextIndex.fetch_add(1)) {
+            fn(i);
+            if (doneCount.fetch_add(1) + 1 == count) doneCount.notify_all();
+        }
+    }
+};
+
+AsyncTask runOnWorker(ThreadPool& pool, std::shared_ptr<ParallelFor> parallelFor) {
+    co_await pool.schedule();
+    parallelFor->run();
+}
+
+}  // namespace
+
+ThreadPool::ThreadPool(uint32_t threadCount) {
+    if (threadCount == 0) threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+    m_threads.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++) m_threads.emplace_back(&ThreadPool::_run, this);
+}
+
+ThreadPool::~ThreadPool() { stop(); }
+
+void ThreadPool::stop() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_isStopping = true;
+    }
+    m_condition.notify_all();
+    for (auto& thread : m_threads) thread.join();
+    m_threads.clear();
+
+    // coroutines that never got a worker
+    for (auto handle : m_queue) handle.destroy();
+    m_queue.clear();
+}
+
+void ThreadPool::parallelFor(uint32_t count, const std::function<void(uint32_t)>& fn) {
+    if (count == 0) return;
+    auto parallelFor = std::make_shared<ParallelFor>(fn, count);
+    for (uint32_t i = 0; i < std::min(count - 1, threadCount()); i++) runOnWorker(*this, parallelFor);
+    parallelFor->run();
+
+    for (uint32_t doneCount = parallelFor->doneCount.load(); doneCount < count;
+         doneCount = parallelFor->doneCount.load())
+        parallelFor->doneCount.wait(doneCount);
+}
+
+void ThreadPool::_enqueue(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard lock(m_mutex);
+        m_queue.push_back(handle);
+    }
+    m_condition.notify_one();
+}
+
+void ThreadPool::_run() {
+    GPRO_THREAD_NAME("worker");
+    while (true) {
+        std::coroutine_handle<> handle;
+        {
+            std::unique_lock lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_isStopping || !m_queue.empty(); });
+            if (m_isStopping) return;
+
+            handle = m_queue.front();
+            m_queue.pop_front();
+        }
+        handle.resume();
+    }
+}
+
+}  // namespace gpro
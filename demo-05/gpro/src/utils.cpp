@@ -1,5 +1,12 @@
 #include "gpro/utils.hpp"
 
+#include <filesystem>
+#include <glm/gtc/packing.hpp>
+
+#include "gpro/mapped_file.hpp"
+#include "gpro/obj_parser.hpp"
+#include "gpro/vertex_welder.hpp"
+
 namespace gpro::util {
 
 glm::vec3 rnd3() {
@@ -12,6 +19,44 @@ glm::vec3 rnd3() {
     return glm::vec3(x, y, z);
 }
 
+uint64_t hashBytes(const uint8_t *data, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+bool fileStamp(const std::string& path, int64_t& writeTime, uint64_t& size) {
+    std::error_code ec;
+    auto time = std::filesystem::last_write_time(path, ec);
+    if (ec) return false;
+    auto fileSize = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+
+    writeTime = static_cast<int64_t>(time.time_since_epoch().count());
+    size = static_cast<uint64_t>(fileSize);
+    return true;
+}
+
+bool hashFile(const std::string& path, uint64_t& hash) {
+    MappedFile file(path);
+    if (!file.isOpen()) return false;
+    hash = hashBytes(file.data(), file.size());
+    return true;
+}
+
+bool isFileUnchanged(const std::string& path, int64_t writeTime, uint64_t size, uint64_t hash) {
+    int64_t currentWriteTime;
+    uint64_t currentSize;
+    if (!fileStamp(path, currentWriteTime, currentSize) || currentSize != size) return false;
+    if (currentWriteTime == writeTime) return true;
+
+    uint64_t currentHash;
+    return hashFile(path, currentHash) && currentHash == hash;
+}
+
 tga::Buffer createBuffer(tga::BufferUsage usage, size_t size, uint8_t const *data) {
     tga::StagingBuffer stagingBuffer = tgai.createStagingBuffer({size, data});
     tga::Buffer buffer = tgai.createBuffer({usage, size, stagingBuffer});
@@ -19,6 +64,14 @@ tga::Buffer createBuffer(tga::BufferUsage usage, size_t size, uint8_t const *dat
     return buffer;
 }
 
+tga::Buffer createBuffer(tga::BufferUsage usage, size_t capacity, uint8_t const *data, size_t size) {
+    tga::StagingBuffer stagingBuffer = tgai.createStagingBuffer({capacity});
+    std::memcpy(tgai.getMapping(stagingBuffer), data, size);
+    tga::Buffer buffer = tgai.createBuffer({usage, capacity, stagingBuffer});
+    tgai.free(stagingBuffer);
+    return buffer;
+}
+
 tga::Buffer createUniformBuffer(size_t size, uint8_t const *data) {
     return createBuffer(tga::BufferUsage::uniform, size, data);
 }
@@ -31,6 +84,10 @@ tga::Buffer createVertexBuffer(std::vector<Vertex>& vertices) {
     return createBuffer(tga::BufferUsage::vertex, vertices.size() * sizeof(Vertex), tga::memoryAccess(vertices));
 }
 
+tga::Buffer createVertexBuffer(std::vector<CompactVertex>& vertices) {
+    return createBuffer(tga::BufferUsage::vertex, vertices.size() * sizeof(CompactVertex), tga::memoryAccess(vertices));
+}
+
 tga::Buffer createIndexBuffer(std::vector<IndexFormat>& indices) {
     return createBuffer(tga::BufferUsage::index, indices.size() * sizeof(IndexFormat), tga::memoryAccess(indices));
 }
@@ -40,47 +97,108 @@ tga::Buffer createDrawIndexedIndirectBuffer(std::vector<tga::DrawIndexedIndirect
                         tga::memoryAccess(diicmds));
 }
 
+tga::Texture createTexture(const tga::Image& image, tga::Format format, tga::SamplerMode samplerMode) {
+    return createTexture(image.width, image.height, image.data.data(), image.data.size(), format, samplerMode);
+}
+
+tga::Texture createTexture(uint32_t width, uint32_t height, const uint8_t *data, size_t size, tga::Format format,
+                           tga::SamplerMode samplerMode) {
+    tga::StagingBuffer stagingBuffer = tgai.createStagingBuffer({size, data});
+    tga::Texture texture = tgai.createTexture({width, height, format, samplerMode, tga::AddressMode::repeat,
+                                               tga::TextureType::_2D, 1, stagingBuffer});
+    tgai.free(stagingBuffer);
+    return texture;
+}
+
 void loadObj(const std::string& objFilePath, std::vector<Vertex>& vBuffer, std::vector<IndexFormat>& iBuffer) {
-    uint32_t vInitialSize = vBuffer.size();
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string warn, err;
-
-    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, objFilePath.c_str())) {
-        throw std::runtime_error(warn + err);
+    auto ts = std::chrono::steady_clock::now();
+    ObjParser::Result obj;
+    ObjParser::parse(objFilePath, obj);
+    double parseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - ts).count();
+    double megaBytes = std::filesystem::file_size(objFilePath) / (1024.0 * 1024.0);
+    std::cout << std::format("parsed obj: {0} ({1:.2f} MB in {2:.2f} ms, {3:.0f} MB/s)\n", objFilePath, megaBytes,
+                             parseSeconds * 1000, megaBytes / parseSeconds);
+
+    // weld the face corners into unique vertices while the indices are emitted
+    ts = std::chrono::steady_clock::now();
+    VertexWelder welder(vBuffer, obj.positions.size());
+    iBuffer.reserve(iBuffer.size() + obj.corners.size());
+    for (const auto& corner : obj.corners) {
+        Vertex vertex{};
+        vertex.position = obj.positions[corner.position];
+        if (corner.normal != ObjParser::MISSING) vertex.normal = obj.normals[corner.normal];
+        if (corner.uv != ObjParser::MISSING) vertex.uv = {obj.uvs[corner.uv].x, 1.f - obj.uvs[corner.uv].y};
+        iBuffer.emplace_back(welder.weld(vertex));
     }
+    double weldSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - ts).count();
+    std::cout << std::format("welded vertices: {0} -> {1} ({2:.2f} ms, {3:.2f} MB table)\n", obj.corners.size(),
+                             welder.uniqueCount(), weldSeconds * 1000, welder.tableBytes() / (1024.0 * 1024.0));
+}
 
-    std::vector<Vertex> preVertexBuffer;
-    for (const auto& shape : shapes) {
-        for (const auto& index : shape.mesh.indices) {
-            Vertex vertex{};
-            vertex.position = {attrib.vertices[3 * index.vertex_index + 0], attrib.vertices[3 * index.vertex_index + 1],
-                               attrib.vertices[3 * index.vertex_index + 2]};
-            vertex.normal = {attrib.normals[3 * index.normal_index + 0], attrib.normals[3 * index.normal_index + 1],
-                             attrib.normals[3 * index.normal_index + 2]};
-            vertex.uv = {attrib.texcoords[2 * index.texcoord_index + 0],
-                         1.f - attrib.texcoords[2 * index.texcoord_index + 1]};
-            preVertexBuffer.emplace_back(vertex);
-        }
+std::array<int16_t, 2> encodeOctahedral(const glm::vec3& normal) {
+    float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (l1 == 0) return {0, 0};
+
+    // project onto the octahedron, fold the lower hemisphere over the diagonals
+    float x = normal.x / l1;
+    float y = normal.y / l1;
+    if (normal.z < 0) {
+        float fx = (1.f - std::abs(y)) * (x >= 0 ? 1.f : -1.f);
+        float fy = (1.f - std::abs(x)) * (y >= 0 ? 1.f : -1.f);
+        x = fx;
+        y = fy;
     }
 
-    std::unordered_map<Vertex, uint32_t> foundVertices{};
-    // vBuffer.clear();
-    // iBuffer.clear();
-
-    for (const auto& vertex : preVertexBuffer) {
-        if (!foundVertices.count(vertex)) {  // It's a new Vertex
-            foundVertices[vertex] = static_cast<uint32_t>(vBuffer.size() - vInitialSize);
-            vBuffer.emplace_back(vertex);
-        } else {  // Seen before, average the the tangents
-            auto& v = vBuffer[foundVertices[vertex]];
-            // v.tangent += vertex.tangent;
-            // v.bitangent += vertex.bitangent;
+    return {static_cast<int16_t>(std::round(std::clamp(x, -1.f, 1.f) * 32767.f)),
+            static_cast<int16_t>(std::round(std::clamp(y, -1.f, 1.f) * 32767.f))};
+}
+
+void quantizeVertices(std::span<const Vertex> vertices, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                      std::vector<CompactVertex>& out) {
+    out.reserve(out.size() + vertices.size());
+
+    glm::vec3 extent = boundsMax - boundsMin;
+    for (const auto& vertex : vertices) {
+        CompactVertex compact{};
+        for (int i = 0; i < 3; i++) {
+            float t = extent[i] > 0 ? (vertex.position[i] - boundsMin[i]) / extent[i] : 0.f;
+            compact.position[i] = static_cast<uint16_t>(std::round(std::clamp(t, 0.f, 1.f) * 65535.f));
         }
-        iBuffer.emplace_back(foundVertices[vertex]);
+        compact.uv[0] = glm::packHalf1x16(vertex.uv.x);
+        compact.uv[1] = glm::packHalf1x16(vertex.uv.y);
+        auto normal = encodeOctahedral(vertex.normal);
+        compact.normal[0] = normal[0];
+        compact.normal[1] = normal[1];
+        out.push_back(compact);
+    }
+}
+
+glm::vec3 decodeOctahedral(int16_t x, int16_t y) {
+    glm::vec3 normal(x / 32767.f, y / 32767.f, 0.f);
+    normal.z = 1.f - std::abs(normal.x) - std::abs(normal.y);
+
+    // unfold the lower hemisphere
+    if (normal.z < 0) {
+        float fx = (1.f - std::abs(normal.y)) * (normal.x >= 0 ? 1.f : -1.f);
+        float fy = (1.f - std::abs(normal.x)) * (normal.y >= 0 ? 1.f : -1.f);
+        normal.x = fx;
+        normal.y = fy;
+    }
+    return glm::normalize(normal);
+}
+
+void dequantizeVertices(const std::vector<CompactVertex>& vertices, const glm::vec3& boundsMin,
+                        const glm::vec3& boundsMax, std::vector<Vertex>& out) {
+    out.reserve(out.size() + vertices.size());
+
+    glm::vec3 extent = boundsMax - boundsMin;
+    for (const auto& compact : vertices) {
+        Vertex vertex{};
+        for (int i = 0; i < 3; i++) vertex.position[i] = boundsMin[i] + compact.position[i] / 65535.f * extent[i];
+        vertex.uv = glm::vec2(glm::unpackHalf1x16(compact.uv[0]), glm::unpackHalf1x16(compact.uv[1]));
+        vertex.normal = decodeOctahedral(compact.normal[0], compact.normal[1]);
+        out.push_back(vertex);
     }
-    preVertexBuffer.clear();
 }
 
 template <typename T>
@@ -0,0 +1,42 @@
+#include "gpro/vertex_welder.hpp"
+
+#include <bit>
+
+namespace gpro {
+
+VertexWelder::VertexWelder(std::vector<Vertex>& vertices, size_t expectedUniqueCount)
+    : m_vertices(vertices), m_base(vertices.size()) {
+    // keep the load factor at or below 1/2
+    _rehash(std::bit_ceil(std::max<size_t>(16, expectedUniqueCount * 2)));
+}
+
+uint32_t VertexWelder::weld(const Vertex& vertex) {
+    size_t slot = hashVertex(vertex) & m_mask;
+    while (true) {
+        uint32_t index = m_slots[slot];
+        if (index == EMPTY) break;
+        if (m_vertices[m_base + index] == vertex) return index;
+        slot = (slot + 1) & m_mask;
+    }
+
+    // new vertex
+    uint32_t index = static_cast<uint32_t>(m_count++);
+    m_slots[slot] = index;
+    m_vertices.emplace_back(vertex);
+
+    if (m_count * 2 > m_slots.size()) _rehash(m_slots.size() * 2);
+    return index;
+}
+
+void VertexWelder::_rehash(size_t capacity) {
+    m_slots.assign(capacity, EMPTY);
+    m_mask = capacity - 1;
+
+    for (uint32_t index = 0; index < m_count; index++) {
+        size_t slot = hashVertex(m_vertices[m_base + index]) & m_mask;
+        while (m_slots[slot] != EMPTY) slot = (slot + 1) & m_mask;
+        m_slots[slot] = index;
+    }
+}
+
+}  // namespace gpro
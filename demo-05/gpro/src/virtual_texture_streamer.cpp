@@ -0,0 +1,246 @@
+#include "gpro/virtual_texture_streamer.hpp"
+
+#include <algorithm>
+
+#include "gpro/utils.hpp"
+
+namespace gpro {
+
+// frames until every pixel of a 4x4 block wrote feedback once
+static constexpr uint32_t s_feedbackCycle =
+    VirtualTextureStreamer::FEEDBACK_RATE * VirtualTextureStreamer::FEEDBACK_RATE;
+
+void VirtualTextureStreamer::init() {
+    m_physicalPagesBuffer = tgai.createBuffer({tga::BufferUsage::storage, size_t(PHYSICAL_PAGE_COUNT) * PAGE_BYTES});
+    for (auto& staging : m_uploadStagings)
+        staging = tgai.createStagingBuffer({size_t(MAX_UPLOADS_PER_FRAME) * PAGE_BYTES});
+    m_streamingBuffer = util::createUniformBuffer(sizeof(uint32_t), toui8(std::addressof(m_frame)));
+
+    m_physicalToVirtual.assign(PHYSICAL_PAGE_COUNT, INVALID_PAGE);
+    m_isPinned.assign(PHYSICAL_PAGE_COUNT, 0);
+    for (uint32_t i = 0; i < PHYSICAL_PAGE_COUNT; i++) m_freePhysicalPages.push_back(PHYSICAL_PAGE_COUNT - 1 - i);
+}
+
+uint32_t VirtualTextureStreamer::add(TextureCache::MappedTexture texture) {
+    if (texture.pageSize != PAGE_SIZE || texture.encoding != TextureCache::Encoding::rgba8 || texture.levels.empty()) {
+        std::cerr << "Virtual textures need paged rgba8 texture cache entries\n";
+        return INVALID_ID;
+    }
+
+    const uint32_t id = m_textures.size();
+    const size_t firstPage = m_virtualPages.size();
+    uint64_t virtualBytes = 0;
+    VirtualTextureGPU textureGPU{};
+    textureGPU.width = texture.levels[0].width;
+    textureGPU.height = texture.levels[0].height;
+
+    // levels down to the tail, coarser ones are never sampled
+    while (textureGPU.levelCount < std::min<size_t>(texture.levels.size(), MAX_LEVEL_COUNT)) {
+        const auto& level = texture.levels[textureGPU.levelCount];
+        const uint32_t pageCount = TextureCache::pageCount(level.width, level.height, PAGE_SIZE);
+        if (level.size < uint64_t(pageCount) * PAGE_BYTES) {
+            std::cerr << "Corrupt virtual texture level\n";
+            m_virtualPages.resize(firstPage);
+            return INVALID_ID;
+        }
+
+        textureGPU.levelFirstPage[textureGPU.levelCount] = m_virtualPages.size();
+        for (uint32_t i = 0; i < pageCount; i++) m_virtualPages.push_back({id, textureGPU.levelCount, i});
+        textureGPU.levelCount++;
+        virtualBytes += uint64_t(level.width) * level.height * 4;
+
+        if (level.width <= PAGE_SIZE && level.height <= PAGE_SIZE) break;
+    }
+
+    m_pageTable.resize(m_virtualPages.size(), 0);
+    m_stats.virtualBytes += virtualBytes;
+    m_pinRequests.push_back(textureGPU.levelFirstPage[textureGPU.levelCount - 1]);
+    m_textures.push_back(std::move(texture));
+    m_texturesGPU.push_back(textureGPU);
+    m_isDirty = true;
+
+    return id;
+}
+
+void VirtualTextureStreamer::update(tga::CommandRecorder& cmdRecorder, tga::RenderPass renderPass, uint32_t setIndex,
+                                    uint32_t frameSlot) {
+    if (m_textures.empty()) return;
+    auto ts = std::chrono::steady_clock::now();
+
+    m_releasedBuffers.nextFrame();
+    m_releasedInputSets.nextFrame();
+    m_frameSlot = frameSlot;
+
+    // feedback of the slot's last frame, if it matches the current buffers. then the buffers of new textures
+    std::vector<uint32_t> requestedPages;
+    std::vector<uint32_t> evictionCandidates;
+    FeedbackReadback& readback = m_feedbackReadbacks[frameSlot];
+    if (readback.isPending && readback.bufferGeneration == m_bufferGeneration) {
+        _readFeedback(static_cast<const uint32_t *>(tgai.getMapping(readback.staging)), requestedPages,
+                      evictionCandidates);
+    }
+    readback.isPending = false;
+    if (m_isDirty) _recreateBuffers(renderPass, setIndex);
+
+    m_frame++;
+    cmdRecorder.inlineBufferUpdate(m_streamingBuffer, std::addressof(m_frame), sizeof(uint32_t));
+
+    // tails of new textures first, they are pinned
+    uint32_t slot = 0;
+    while (!m_pinRequests.empty() && slot < MAX_UPLOADS_PER_FRAME) {
+        const uint32_t physicalPage = _allocatePhysicalPage(cmdRecorder, evictionCandidates);
+        if (physicalPage == INVALID_PAGE) {
+            std::cerr << "Virtual texture pool is full of pinned pages\n";
+            break;
+        }
+        m_isPinned[physicalPage] = 1;
+        _upload(cmdRecorder, m_pinRequests.back(), physicalPage, slot++);
+        m_pinRequests.pop_back();
+    }
+
+    // then the requested pages, coarse levels first: they are the fallback of the finer ones
+    std::stable_sort(requestedPages.begin(), requestedPages.end(), [this](uint32_t a, uint32_t b) {
+        return m_virtualPages[a].level > m_virtualPages[b].level;
+    });
+    uint32_t streamedCount = 0;
+    for (uint32_t page : requestedPages) {
+        if (slot == MAX_UPLOADS_PER_FRAME) break;
+        const uint32_t physicalPage = _allocatePhysicalPage(cmdRecorder, evictionCandidates);
+        if (physicalPage == INVALID_PAGE) break;  // everything resident is still in use
+        _upload(cmdRecorder, page, physicalPage, slot++);
+        streamedCount++;
+
+        auto it = m_faultTimes.find(page);
+        if (it == m_faultTimes.end()) continue;
+        const double latencyMs =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - it->second).count();
+        m_faultTimes.erase(it);
+        m_stats.faultCount++;
+        m_stats.averageFaultLatencyMs += (latencyMs - m_stats.averageFaultLatencyMs) / m_stats.faultCount;
+        m_stats.maxFaultLatencyMs = std::max(m_stats.maxFaultLatencyMs, latencyMs);
+    }
+    cmdRecorder.barrier(tga::PipelineStage::Transfer, tga::PipelineStage::FragmentShader);
+
+    m_stats.residentPageCount = PHYSICAL_PAGE_COUNT - m_freePhysicalPages.size();
+    m_stats.pendingPageCount = requestedPages.size() - streamedCount;
+    m_stats.streamedPageCount = streamedCount;
+
+    if (streamedCount > 0) {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ts).count();
+        std::cout << std::format(
+            "Virtual textures: streamed {0} pages ({1:.2f} ms), resident {2}/{3} pages ({4:.1f} of {5:.1f} MB), "
+            "pending {6}, fault latency avg/max: {7:.1f}/{8:.1f} ms\n",
+            streamedCount, ms, m_stats.residentPageCount, PHYSICAL_PAGE_COUNT, m_stats.residentBytes() / 1048576.0,
+            m_stats.virtualBytes / 1048576.0, m_stats.pendingPageCount, m_stats.averageFaultLatencyMs,
+            m_stats.maxFaultLatencyMs);
+    }
+}
+
+void VirtualTextureStreamer::downloadFeedback(tga::CommandRecorder& cmdRecorder, uint32_t frameSlot) {
+    if (!m_feedbackBuffer) return;
+
+    // the slot's last frame has completed, so its staging buffer is free
+    FeedbackReadback& readback = m_feedbackReadbacks[frameSlot];
+    if (readback.pageCount < m_bufferPageCount) {
+        if (readback.staging) tgai.free(readback.staging);
+        readback.staging = tgai.createStagingBuffer({size_t(m_bufferPageCount) * sizeof(uint32_t)});
+        readback.pageCount = m_bufferPageCount;
+    }
+    cmdRecorder.barrier(tga::PipelineStage::FragmentShader, tga::PipelineStage::Transfer)
+        .bufferDownload(m_feedbackBuffer, readback.staging, size_t(m_bufferPageCount) * sizeof(uint32_t));
+    readback.bufferGeneration = m_bufferGeneration;
+    readback.isPending = true;
+}
+
+void VirtualTextureStreamer::_recreateBuffers(tga::RenderPass renderPass, uint32_t setIndex) {
+    m_releasedBuffers.release(m_texturesBuffer);
+    m_releasedBuffers.release(m_pageTableBuffer);
+    m_releasedBuffers.release(m_feedbackBuffer);
+    m_releasedInputSets.release(m_inputSet);
+
+    // resident pages are already in m_pageTable, the feedback starts over
+    const std::vector<uint32_t> feedback(m_virtualPages.size(), 0);
+    m_texturesBuffer = util::createStorageBuffer(sizeof(VirtualTextureGPU) * m_texturesGPU.size(),
+                                                 tga::memoryAccess(m_texturesGPU));
+    m_pageTableBuffer =
+        util::createStorageBuffer(sizeof(uint32_t) * m_pageTable.size(), tga::memoryAccess(m_pageTable));
+    m_feedbackBuffer = util::createStorageBuffer(sizeof(uint32_t) * feedback.size(), tga::memoryAccess(feedback));
+    m_bufferPageCount = m_virtualPages.size();
+    m_bufferGeneration++;
+
+    m_inputSet = tgai.createInputSet({renderPass,
+                                      {{m_texturesBuffer, 0},
+                                       {m_pageTableBuffer, 1},
+                                       {m_physicalPagesBuffer, 2},
+                                       {m_feedbackBuffer, 3},
+                                       {m_streamingBuffer, 4}},
+                                      setIndex});
+    m_isDirty = false;
+}
+
+void VirtualTextureStreamer::_readFeedback(const uint32_t *feedback, std::vector<uint32_t>& requestedPages,
+                                           std::vector<uint32_t>& evictionCandidates) {
+    // a page counts as requested if any of its pixels asked for it in the last feedback cycle. the feedback is
+    // FRAMES_IN_FLIGHT frames old, hence the extra frames
+    const uint32_t oldestStamp =
+        m_frame > s_feedbackCycle + FRAMES_IN_FLIGHT ? m_frame - s_feedbackCycle - FRAMES_IN_FLIGHT : 1;
+    auto now = std::chrono::steady_clock::now();
+
+    for (uint32_t page = 0; page < m_bufferPageCount; page++) {
+        if (feedback[page] < oldestStamp || m_pageTable[page] != 0) continue;
+        requestedPages.push_back(page);
+        m_faultTimes.try_emplace(page, now);
+    }
+    std::erase_if(m_faultTimes, [&](const auto& fault) {
+        return fault.first >= m_bufferPageCount || feedback[fault.first] < oldestStamp;
+    });
+
+    // resident pages that were not requested in the cycle, least recently requested last
+    for (uint32_t physicalPage = 0; physicalPage < PHYSICAL_PAGE_COUNT; physicalPage++) {
+        const uint32_t page = m_physicalToVirtual[physicalPage];
+        if (page == INVALID_PAGE || m_isPinned[physicalPage] || page >= m_bufferPageCount) continue;
+        if (feedback[page] < oldestStamp) evictionCandidates.push_back(physicalPage);
+    }
+    std::sort(evictionCandidates.begin(), evictionCandidates.end(), [&](uint32_t a, uint32_t b) {
+        return feedback[m_physicalToVirtual[a]] > feedback[m_physicalToVirtual[b]];
+    });
+}
+
+uint32_t VirtualTextureStreamer::_allocatePhysicalPage(tga::CommandRecorder& cmdRecorder,
+                                                       std::vector<uint32_t>& evictionCandidates) {
+    if (!m_freePhysicalPages.empty()) {
+        const uint32_t physicalPage = m_freePhysicalPages.back();
+        m_freePhysicalPages.pop_back();
+        return physicalPage;
+    }
+    if (evictionCandidates.empty()) return INVALID_PAGE;
+
+    // evict, the shader falls back to a coarser level from this frame on
+    const uint32_t physicalPage = evictionCandidates.back();
+    evictionCandidates.pop_back();
+    const uint32_t page = m_physicalToVirtual[physicalPage];
+    m_pageTable[page] = 0;
+    cmdRecorder.inlineBufferUpdate(m_pageTableBuffer, std::addressof(m_pageTable[page]), sizeof(uint32_t),
+                                   size_t(page) * sizeof(uint32_t));
+    m_physicalToVirtual[physicalPage] = INVALID_PAGE;
+    return physicalPage;
+}
+
+void VirtualTextureStreamer::_upload(tga::CommandRecorder& cmdRecorder, uint32_t virtualPage, uint32_t physicalPage,
+                                     uint32_t slot) {
+    // one page copy from the mapped cache entry into the staging buffer
+    const VirtualPage& page = m_virtualPages[virtualPage];
+    const auto& level = m_textures[page.textureID].levels[page.level];
+    const tga::StagingBuffer uploadStaging = m_uploadStagings[m_frameSlot];
+    uint8_t *staging = static_cast<uint8_t *>(tgai.getMapping(uploadStaging)) + size_t(slot) * PAGE_BYTES;
+    std::memcpy(staging, level.data + size_t(page.levelPage) * PAGE_BYTES, PAGE_BYTES);
+
+    cmdRecorder.bufferUpload(uploadStaging, m_physicalPagesBuffer, PAGE_BYTES, size_t(slot) * PAGE_BYTES,
+                             size_t(physicalPage) * PAGE_BYTES);
+    m_physicalToVirtual[physicalPage] = virtualPage;
+    m_pageTable[virtualPage] = physicalPage + 1;
+    cmdRecorder.inlineBufferUpdate(m_pageTableBuffer, std::addressof(m_pageTable[virtualPage]), sizeof(uint32_t),
+                                   size_t(virtualPage) * sizeof(uint32_t));
+}
+
+}  // namespace gpro
@@ -1,5 +1,6 @@
 #version 460
 #extension GL_EXT_nonuniform_qualifier: enable
+#extension GL_KHR_shader_subgroup_ballot: enable
 
 #define LIGHT_COUNT 1
 
@@ -8,12 +9,15 @@ struct Light {
     vec3 color;
 };
 
+// occluded fragments are not shaded, so the fragment count and the depth copy only see visible ones
+layout(early_fragment_tests) in;
+
 // input 
 layout(location = 0) in Frag{
     vec3 position;
     vec2 uv;
     vec3 normal;
-    flat uint drawID;
+    flat uint textureID;
 }frag;
 
 // uniform
@@ -26,6 +30,18 @@ layout(set = 0, binding = 2) uniform Lights{
     Light lights[LIGHT_COUNT];
 };
 
+// depth copy for the occlusion culling pyramid (Renderer::DepthCopy)
+layout(set = 0, binding = 4) buffer DepthCopy{
+    uint width;
+    uint isWritten;  // occlusion culling is enabled
+    uint depth[];    // float bits, nearest
+};
+
+// Renderer::CullingStats
+layout(set = 0, binding = 5) buffer CullingStats{
+    uint fragmentCount;
+};
+
 layout(set = 1, binding = 0) uniform sampler2D diffuseMaps[];
 
 // output
@@ -33,8 +49,16 @@ layout(location = 0) out vec4 color;
 
 void main()
 {
+    // shaded fragments (one atomic per subgroup) and the depth copy
+    uvec4 fragments = subgroupBallot(true);
+    if (subgroupElect()) atomicAdd(fragmentCount, subgroupBallotBitCount(fragments));
+    if (isWritten != 0) {
+        uint pixel = uint(gl_FragCoord.y) * width + uint(gl_FragCoord.x);
+        atomicMin(depth[pixel], floatBitsToUint(gl_FragCoord.z));
+    }
+
     // base color
-    vec4 col4 = texture(diffuseMaps[frag.drawID], frag.uv);
+    vec4 col4 = texture(diffuseMaps[nonuniformEXT(frag.textureID)], frag.uv);
 
     vec3 col = col4.xyz;
 
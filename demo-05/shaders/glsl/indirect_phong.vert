@@ -24,18 +24,28 @@ layout(set = 2, binding = 1) readonly buffer InstanceIdToMeshIDMap{
     uint instanceIdToMeshIDMap[];
 };
 
+layout(set = 2, binding = 3) readonly buffer InstanceIdToTextureIDMap{
+    uint instanceIdToTextureIDMap[];
+};
+
+// compacted by the culling pass, indexed by gl_InstanceIndex
+layout(set = 2, binding = 4) readonly buffer VisibleInstanceIDs{
+    uint visibleInstanceIDs[];
+};
+
 // output
 layout(location = 0) out Frag{
     vec3 position;
     vec2 uv;
     vec3 normal;
-    flat uint drawID;
+    flat uint textureID;  // diffuse map, index into the global texture table
 }frag;
 
 void main() {
+    uint instanceID = visibleInstanceIDs[gl_InstanceIndex];
+
     // vertex world pos
-    mat4 model = models[gl_InstanceIndex];
-    uint meshID = instanceIdToMeshIDMap[gl_InstanceIndex]; 
+    mat4 model = models[instanceID];
     vec3 worldPos = (model * vec4(position, 1.0)).xyz;
     
     gl_Position = mat_projection * mat_view * vec4(worldPos,1);
@@ -44,5 +54,5 @@ void main() {
     frag.position = worldPos.xyz;
     frag.uv = uv;
     frag.normal = mat3(transpose(inverse(model))) * normal;
-    frag.drawID = meshID;
+    frag.textureID = instanceIdToTextureIDMap[instanceID];
 }
@@ -0,0 +1,82 @@
+#version 460
+#extension GL_EXT_nonuniform_qualifier: enable
+
+struct AABB {
+    vec3 mn;
+    vec3 mx;
+};
+
+// inputs (CompactVertex)
+layout(location = 0) in vec4 position;  // unorm16, relative to the mesh aabb
+layout(location = 1) in vec2 uv;        // half float
+layout(location = 2) in vec2 normal;    // snorm16, octahedral
+
+// bindings
+layout(set = 0, binding = 0) uniform Camera {
+    mat4 mat_view;
+    mat4 mat_projection;
+};
+
+layout(set = 0, binding = 3) uniform Time {
+    float time;
+};
+
+layout(set = 2, binding = 0) readonly buffer Models {
+    mat4 models[];
+};
+
+layout(set = 2, binding = 1) readonly buffer InstanceIdToMeshIDMap{
+    uint instanceIdToMeshIDMap[];
+};
+
+layout(set = 2, binding = 3) readonly buffer InstanceIdToTextureIDMap{
+    uint instanceIdToTextureIDMap[];
+};
+
+// compacted by the culling pass, indexed by gl_InstanceIndex
+layout(set = 2, binding = 4) readonly buffer VisibleInstanceIDs{
+    uint visibleInstanceIDs[];
+};
+
+layout(set = 2, binding = 2) readonly buffer AABBs{
+    AABB aabbs[];
+};
+
+// output
+layout(location = 0) out Frag{
+    vec3 position;
+    vec2 uv;
+    vec3 normal;
+    flat uint textureID;  // diffuse map, index into the global texture table
+}frag;
+
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+void main() {
+    uint instanceID = visibleInstanceIDs[gl_InstanceIndex];
+
+    uint meshID = instanceIdToMeshIDMap[instanceID];
+    AABB aabb = aabbs[meshID];
+
+    // decode
+    vec3 localPos = aabb.mn + position.xyz * (aabb.mx - aabb.mn);
+    vec3 localNormal = octDecode(normal);
+
+    // vertex world pos
+    mat4 model = models[instanceID];
+    vec3 worldPos = (model * vec4(localPos, 1.0)).xyz;
+    
+    gl_Position = mat_projection * mat_view * vec4(worldPos,1);
+    
+    // pass fragment data
+    frag.position = worldPos.xyz;
+    frag.uv = uv;
+    frag.normal = mat3(transpose(inverse(model))) * localNormal;
+    frag.textureID = instanceIdToTextureIDMap[instanceID];
+}
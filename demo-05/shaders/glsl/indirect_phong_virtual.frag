@@ -0,0 +1,185 @@
+#version 460
+#extension GL_KHR_shader_subgroup_ballot: enable
+
+#define LIGHT_COUNT 1
+
+struct Light {
+    vec3 position;
+    vec3 color;
+};
+
+// occluded fragments are not shaded, so the fragment count and the depth copy only see visible ones
+layout(early_fragment_tests) in;
+
+// input 
+layout(location = 0) in Frag{
+    vec3 position;
+    vec2 uv;
+    vec3 normal;
+    flat uint textureID;
+}frag;
+
+// uniform
+layout(set = 0, binding = 0) uniform Camera{
+    mat4 mat_view;
+    mat4 mat_projection;
+};
+
+layout(set = 0, binding = 2) uniform Lights{
+    Light lights[LIGHT_COUNT];
+};
+
+// depth copy for the occlusion culling pyramid (Renderer::DepthCopy)
+layout(set = 0, binding = 4) buffer DepthCopy{
+    uint width;
+    uint isWritten;  // occlusion culling is enabled
+    uint depth[];    // float bits, nearest
+};
+
+// Renderer::CullingStats
+layout(set = 0, binding = 5) buffer CullingStats{
+    uint fragmentCount;
+};
+
+// virtual diffuse maps (VirtualTextureStreamer)
+#define PAGE_SIZE 128
+#define MAX_LEVEL_COUNT 16
+#define FEEDBACK_RATE 4
+
+struct VirtualTexture {
+    uint width;
+    uint height;
+    uint levelCount;  // up to the tail level, which is always resident
+    uint padding;
+    uint levelFirstPage[MAX_LEVEL_COUNT];
+};
+
+layout(set = 1, binding = 0) readonly buffer VirtualTextures{
+    VirtualTexture virtualTextures[];
+};
+
+layout(set = 1, binding = 1) readonly buffer PageTable{
+    uint pageTable[];  // physical page + 1, 0 if not resident
+};
+
+layout(set = 1, binding = 2) readonly buffer PhysicalPages{
+    uint physicalPages[];  // PAGE_SIZE^2 rgba8 (srgb) texels each
+};
+
+layout(set = 1, binding = 3) writeonly buffer Feedback{
+    uint feedback[];  // frame of the last request, per virtual page
+};
+
+layout(set = 1, binding = 4) uniform Streaming{
+    uint frame;
+};
+
+// output
+layout(location = 0) out vec4 color;
+
+vec3 srgbToLinear(vec3 c) {
+    return mix(c / 12.92, pow((c + 0.055) / 1.055, vec3(2.4)), greaterThan(c, vec3(0.04045)));
+}
+
+vec4 fetchTexel(uint physicalPage, ivec2 texel) {
+    vec4 c = unpackUnorm4x8(physicalPages[physicalPage * PAGE_SIZE * PAGE_SIZE + uint(texel.y * PAGE_SIZE + texel.x)]);
+    return vec4(srgbToLinear(c.rgb), c.a);
+}
+
+uint pageIndex(VirtualTexture vt, uint level, vec2 uv, out ivec2 pageOrigin) {
+    ivec2 size = ivec2(max(vt.width >> level, 1u), max(vt.height >> level, 1u));
+    ivec2 page = clamp(ivec2(uv * vec2(size)), ivec2(0), size - 1) / PAGE_SIZE;
+    pageOrigin = page * PAGE_SIZE;
+    return vt.levelFirstPage[level] + uint(page.y * ((size.x + PAGE_SIZE - 1) / PAGE_SIZE) + page.x);
+}
+
+vec4 sampleVirtual(uint textureID, vec2 uv) {
+    VirtualTexture vt = virtualTextures[textureID];
+
+    // level from the uv derivatives, like the sampler's nearest mip
+    vec2 texelUV = uv * vec2(vt.width, vt.height);
+    vec2 dx = dFdx(texelUV);
+    vec2 dy = dFdy(texelUV);
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8));
+    uint level = uint(clamp(floor(lod + 0.5), 0.0, float(vt.levelCount - 1)));
+    uv = fract(uv);
+
+    // request the page from one pixel of each FEEDBACK_RATE^2 block, a different one every frame
+    ivec2 pageOrigin;
+    uvec2 pixel = uvec2(gl_FragCoord.xy) % uint(FEEDBACK_RATE);
+    uint phase = frame % uint(FEEDBACK_RATE * FEEDBACK_RATE);
+    if (pixel.x == phase % uint(FEEDBACK_RATE) && pixel.y == phase / uint(FEEDBACK_RATE))
+        feedback[pageIndex(vt, level, uv, pageOrigin)] = frame;
+
+    // the finest resident level, bilinear within its page
+    for (; level < vt.levelCount; level++) {
+        uint entry = pageTable[pageIndex(vt, level, uv, pageOrigin)];
+        if (entry == 0) continue;
+
+        ivec2 size = ivec2(max(vt.width >> level, 1u), max(vt.height >> level, 1u));
+        vec2 p = uv * vec2(size) - 0.5;
+        ivec2 t0 = clamp(ivec2(floor(p)) - pageOrigin, ivec2(0), ivec2(PAGE_SIZE - 1));
+        ivec2 t1 = clamp(ivec2(floor(p)) + 1 - pageOrigin, ivec2(0), ivec2(PAGE_SIZE - 1));
+        vec2 f = fract(p);
+        vec4 top = mix(fetchTexel(entry - 1, t0), fetchTexel(entry - 1, ivec2(t1.x, t0.y)), f.x);
+        vec4 bottom = mix(fetchTexel(entry - 1, ivec2(t0.x, t1.y)), fetchTexel(entry - 1, t1), f.x);
+        return mix(top, bottom, f.y);
+    }
+    return vec4(1);  // the tail is not resident yet
+}
+
+void main()
+{
+    // shaded fragments (one atomic per subgroup) and the depth copy
+    uvec4 fragments = subgroupBallot(true);
+    if (subgroupElect()) atomicAdd(fragmentCount, subgroupBallotBitCount(fragments));
+    if (isWritten != 0) {
+        uint pixel = uint(gl_FragCoord.y) * width + uint(gl_FragCoord.x);
+        atomicMin(depth[pixel], floatBitsToUint(gl_FragCoord.z));
+    }
+
+    // base color
+    vec4 col4 = sampleVirtual(frag.textureID, frag.uv);
+
+    vec3 col = col4.xyz;
+
+    // Blinn Phong Illumination model
+    vec3 N = normalize(frag.normal);
+
+    // The ambient term is replaced by a gradient
+    float NdS = clamp(0.5*N.y+0.5, 0.0, 1.0);
+    vec3 skyColor = vec3(0.5, 0.5, 0.5);
+    vec3 ambient = NdS * skyColor;
+
+    vec3 camPos = mat_view[3].xyz;
+    vec3 V = normalize(camPos-frag.position);
+    
+    // The specularity is normalized to approximate energy conservation
+    float n = 128.;
+
+    for(int i = 0; i < LIGHT_COUNT; i++)
+    {
+        Light light = lights[i];
+
+        vec3 L = normalize(light.position);
+        float NdL = max(dot(N,L),0);
+
+        vec3 H = normalize(V+L);
+
+        float spec = pow(max(dot(N,H),0),n);
+        spec *= (n+2)/(4*(2-exp2(-n*0.5)));
+
+        // The decompose the light data
+        vec3 lightCol = light.color;
+
+        // make distance dependent
+        float coeff = pow((distance(frag.position, light.position)+0.001) / 6, 10);
+        coeff = 1 / coeff;
+
+        col += col*lightCol*NdL * coeff;
+        col += lightCol*spec * coeff * 0.5;
+    }
+
+    col += col*skyColor*NdS;
+    color = vec4(col,col4.w);
+}
@@ -0,0 +1,71 @@
+#include <random>
+
+#include "gpro/frustum_culler.hpp"
+#include "test.hpp"
+
+namespace {
+
+using gpro::AABB;
+using gpro::FrustumCuller;
+using gpro::Plane;
+
+// six planes with random normals, each 0.5 to 1.5 from the origin with the origin inside, so primitives around it
+// land on both sides
+gpro::Frustum randomFrustum(std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    auto plane = [&] {
+        glm::vec3 normal(unit(rng), unit(rng), unit(rng));
+        if (glm::length(normal) < 0.1f) normal = glm::vec3(0, 1, 0);
+        return Plane(-glm::normalize(normal) * (1 + 0.5f * unit(rng)), normal);
+    };
+    return {plane(), plane(), plane(), plane(), plane(), plane()};
+}
+
+}  // namespace
+
+// the simd loops test 4 primitives at a time and the rest one by one. every count up to a few lanes past 4 must
+// give the scalar result for each primitive, and leave the visibility past the count untouched
+TEST(frustum_culler_matches_scalar) {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> position(-2.f, 2.f);
+    std::uniform_real_distribution<float> size(0.f, 0.5f);
+
+    size_t visibleTotal = 0, testedTotal = 0;
+    for (uint32_t frustumIndex = 0; frustumIndex < 32; frustumIndex++) {
+        const FrustumCuller culler(randomFrustum(rng));
+        for (size_t count = 0; count <= 13; count++) {
+            std::vector<glm::vec4> spheres;
+            std::vector<AABB> aabbs;
+            for (size_t i = 0; i < count; i++) {
+                const glm::vec3 center(position(rng), position(rng), position(rng));
+                const glm::vec3 extent(size(rng), size(rng), size(rng));
+                spheres.emplace_back(center, size(rng));
+                aabbs.emplace_back(center - extent, center + extent);
+            }
+
+            std::vector<uint8_t> sphereVisibility(count + 1, 0xcd), aabbVisibility(count + 1, 0xcd);
+            const size_t sphereCount = culler.cullSpheres(spheres.data(), count, sphereVisibility.data());
+            const size_t aabbCount = culler.cullAABBs(aabbs.data(), count, aabbVisibility.data());
+
+            size_t expectedSphereCount = 0, expectedAABBCount = 0;
+            bool isSphereMatch = true, isAABBMatch = true;
+            for (size_t i = 0; i < count; i++) {
+                const bool isSphereVisible = culler.isSphereVisible(spheres[i]);
+                const bool isAABBVisible = culler.isAABBVisible(aabbs[i]);
+                isSphereMatch &= sphereVisibility[i] == (isSphereVisible ? 1 : 0);
+                isAABBMatch &= aabbVisibility[i] == (isAABBVisible ? 1 : 0);
+                expectedSphereCount += isSphereVisible;
+                expectedAABBCount += isAABBVisible;
+            }
+            CHECK(isSphereMatch && sphereCount == expectedSphereCount);
+            CHECK(isAABBMatch && aabbCount == expectedAABBCount);
+            CHECK(sphereVisibility.back() == 0xcd && aabbVisibility.back() == 0xcd);
+
+            visibleTotal += expectedSphereCount + expectedAABBCount;
+            testedTotal += 2 * count;
+        }
+    }
+
+    // both outcomes are covered
+    CHECK(visibleTotal > testedTotal / 10 && visibleTotal < testedTotal - testedTotal / 10);
+}
@@ -0,0 +1,21 @@
+#include "test.hpp"
+
+int main() {
+    using namespace gpro::test;
+
+    uint32_t failedCount = 0;
+    for (const TestCase& test : registry()) {
+        const uint32_t failuresBefore = checkFailures();
+        try {
+            test.run();
+        } catch (const std::exception& e) {
+            std::cerr << std::format("    threw: {}\n", e.what());
+            checkFailures()++;
+        }
+        const bool isPassed = checkFailures() == failuresBefore;
+        if (!isPassed) failedCount++;
+        std::cout << std::format("{0} {1}\n", isPassed ? "passed" : "FAILED", test.name);
+    }
+    std::cout << std::format("{0} of {1} tests passed\n", registry().size() - failedCount, registry().size());
+    return static_cast<int>(failedCount);
+}
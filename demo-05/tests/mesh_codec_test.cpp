@@ -0,0 +1,105 @@
+#include <random>
+
+#include "gpro/mesh_codec.hpp"
+#include "test.hpp"
+
+namespace {
+
+using gpro::IndexFormat;
+using gpro::MeshCodec;
+
+bool roundTripIndices(const std::vector<IndexFormat>& indices) {
+    const auto encoded = MeshCodec::encodeIndices(indices.data(), indices.size());
+    std::vector<IndexFormat> decoded(indices.size() + 1, 0xdeadbeef);  // the guard stays untouched
+    const bool isDecoded = MeshCodec::decodeIndices(encoded.data(), encoded.size(), decoded.data(), indices.size());
+    const bool isEqual = std::equal(indices.begin(), indices.end(), decoded.begin());
+
+    // a truncated or padded stream is rejected
+    bool isRejected = true;
+    if (!encoded.empty()) {
+        isRejected &= !MeshCodec::decodeIndices(encoded.data(), encoded.size() - 1, decoded.data(), indices.size());
+        auto padded = encoded;
+        padded.push_back(0);
+        isRejected &= !MeshCodec::decodeIndices(padded.data(), padded.size(), decoded.data(), indices.size());
+    }
+    return isDecoded && isEqual && decoded.back() == 0xdeadbeef && isRejected;
+}
+
+bool roundTripVertices(const std::vector<uint8_t>& vertices, size_t stride) {
+    const size_t count = vertices.size() / stride;
+    const auto encoded = MeshCodec::encodeVertices(vertices.data(), count, stride);
+    std::vector<uint8_t> decoded(vertices.size() + stride, 0xcd);
+    const bool isDecoded = MeshCodec::decodeVertices(encoded.data(), encoded.size(), decoded.data(), count, stride);
+    const bool isEqual = std::equal(vertices.begin(), vertices.end(), decoded.begin());
+    const bool isGuarded = std::all_of(decoded.end() - stride, decoded.end(), [](uint8_t b) { return b == 0xcd; });
+
+    bool isRejected = true;
+    if (!encoded.empty()) {
+        isRejected &= !MeshCodec::decodeVertices(encoded.data(), encoded.size() - 1, decoded.data(), count, stride);
+        auto padded = encoded;
+        padded.push_back(0);
+        isRejected &= !MeshCodec::decodeVertices(padded.data(), padded.size(), decoded.data(), count, stride);
+    }
+    return isDecoded && isEqual && isGuarded && isRejected;
+}
+
+}  // namespace
+
+// triangle lists with locality (1-2 byte deltas), full range values (4 bytes) and partial control bytes
+TEST(mesh_codec_indices) {
+    std::mt19937 rng(4);
+    for (size_t count : {0, 1, 3, 4, 5, 17, 3001}) {
+        std::vector<IndexFormat> local, random;
+        for (size_t i = 0; i < count; i++) {
+            local.push_back(static_cast<IndexFormat>(i / 2 + rng() % 64));
+            random.push_back(rng());
+        }
+        CHECK(roundTripIndices(local));
+        CHECK(roundTripIndices(random));
+    }
+    CHECK(roundTripIndices({0, 0xffffffff, 0, 0x80000000, 0x7fffffff, 1}));
+}
+
+// every stride the codec takes, partial last groups, and the 0/2/4/8-bit planes: constant, slowly changing and
+// random bytes. strides that are multiples of 16 take the simd decoder where there is one
+TEST(mesh_codec_vertices) {
+    std::mt19937 rng(5);
+    for (size_t stride : {4, 8, 12, 16, 32, 48, 256}) {
+        for (size_t count : {0, 1, 15, 16, 17, 100}) {
+            std::vector<uint8_t> constant(count * stride, 0x5a), smooth(count * stride), random(count * stride);
+            for (size_t i = 0; i < count * stride; i++) {
+                smooth[i] = static_cast<uint8_t>((i / stride) * (i % stride % 3) + i % stride);
+                random[i] = static_cast<uint8_t>(rng());
+            }
+            CHECK(roundTripVertices(constant, stride));
+            CHECK(roundTripVertices(smooth, stride));
+            CHECK(roundTripVertices(random, stride));
+        }
+    }
+
+    // the 32-byte float layout of the mesh cache
+    std::vector<gpro::Vertex> vertices;
+    for (uint32_t i = 0; i < 1000; i++) {
+        const float f = static_cast<float>(i);
+        vertices.push_back({{std::sin(f), std::cos(f), f * 0.01f}, {f / 1000.f, 0.5f}, {0, 1, 0}});
+    }
+    std::vector<uint8_t> bytes(vertices.size() * sizeof(gpro::Vertex));
+    std::memcpy(bytes.data(), vertices.data(), bytes.size());
+    CHECK(roundTripVertices(bytes, sizeof(gpro::Vertex)));
+}
+
+TEST(mesh_codec_rejects_strides) {
+    const uint8_t data[16] = {};
+    uint8_t out[16];
+    CHECK(!MeshCodec::decodeVertices(data, sizeof(data), out, 1, 6));
+    CHECK(!MeshCodec::decodeVertices(data, sizeof(data), out, 1, 0));
+    CHECK(!MeshCodec::decodeVertices(data, sizeof(data), out, 1, MeshCodec::MAX_VERTEX_STRIDE + 4));
+
+    bool isThrown = false;
+    try {
+        MeshCodec::encodeVertices(data, 1, 6);
+    } catch (const std::runtime_error&) {
+        isThrown = true;
+    }
+    CHECK(isThrown);
+}
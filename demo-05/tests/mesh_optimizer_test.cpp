@@ -0,0 +1,224 @@
+#include <array>
+#include <numeric>
+#include <random>
+
+#include "gpro/mesh_optimizer.hpp"
+#include "test.hpp"
+
+namespace {
+
+using gpro::IndexFormat;
+using gpro::MeshOptimizer;
+using gpro::Vertex;
+
+using Triangle = std::array<IndexFormat, 3>;
+
+// a size x size quad grid over a fixed seed height field, triangles row by row, facing +y
+void makeGrid(uint32_t size, std::vector<Vertex>& vertices, std::vector<IndexFormat>& indices) {
+    std::mt19937 rng(5489u);
+    for (uint32_t y = 0; y <= size; y++) {
+        for (uint32_t x = 0; x <= size; x++) {
+            const float height = static_cast<float>(rng() >> 8) / (1u << 24) * 0.02f;
+            const glm::vec2 uv(float(x) / size, float(y) / size);
+            vertices.push_back({{uv.x, height, uv.y}, uv, {0, 1, 0}});
+        }
+    }
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            const IndexFormat i = y * (size + 1) + x;
+            const IndexFormat j = i + size + 1;
+            indices.insert(indices.end(), {i, j, j + 1, i, j + 1, i + 1});
+        }
+    }
+}
+
+// the triangles as a sorted list, each rotated to start at its smallest index so the winding is kept
+std::vector<Triangle> triangleSet(const std::vector<IndexFormat>& indices) {
+    std::vector<Triangle> triangles;
+    for (size_t i = 0; i + 3 <= indices.size(); i += 3) {
+        Triangle t = {indices[i], indices[i + 1], indices[i + 2]};
+        std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+        triangles.push_back(t);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+// the same triangles in a fixed seed random order
+std::vector<IndexFormat> shuffleTriangles(const std::vector<IndexFormat>& indices) {
+    std::vector<uint32_t> order(indices.size() / 3);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), std::mt19937(7));
+
+    std::vector<IndexFormat> shuffled;
+    for (uint32_t t : order) shuffled.insert(shuffled.end(), indices.begin() + t * 3, indices.begin() + t * 3 + 3);
+    return shuffled;
+}
+
+// the meshlets of every lod tile its index range in order, within the limits, with bounds that hold their triangles
+void checkMeshlets(const std::vector<Vertex>& vertices, const std::vector<IndexFormat>& indices,
+                   const std::vector<gpro::MeshLOD>& lods, const std::vector<gpro::Meshlet>& meshlets,
+                   uint32_t maxVertices, uint32_t maxTriangles) {
+    uint32_t meshletOffset = 0;
+    uint32_t coneCount = 0;
+    for (uint32_t level = 0; level < lods.size(); level++) {
+        const gpro::MeshLOD& lod = lods[level];
+        CHECK(lod.meshletOffset == meshletOffset && lod.meshletCount > 0);
+        meshletOffset += lod.meshletCount;
+        if (meshletOffset > meshlets.size()) return;
+
+        uint32_t nextIndex = lod.indexOffset;
+        bool isTiled = true, isInLimits = true, isVertexCountCorrect = true, isContained = true, isBehind = true;
+        for (uint32_t m = lod.meshletOffset; m < meshletOffset; m++) {
+            const gpro::Meshlet& meshlet = meshlets[m];
+            const uint32_t end = meshlet.indexOffset + meshlet.triangleCount * 3;
+            isTiled &= meshlet.indexOffset == nextIndex && meshlet.lod == level && meshlet.triangleCount > 0;
+            nextIndex = end;
+            if (end > indices.size()) return;
+
+            std::vector<IndexFormat> used(indices.begin() + meshlet.indexOffset, indices.begin() + end);
+            std::sort(used.begin(), used.end());
+            used.erase(std::unique(used.begin(), used.end()), used.end());
+            isVertexCountCorrect &= meshlet.vertexCount == used.size();
+            isInLimits &= meshlet.vertexCount <= maxVertices && meshlet.triangleCount <= maxTriangles;
+
+            for (IndexFormat index : used) {
+                const float distance = glm::length(vertices[index].position - meshlet.center);
+                isContained &= distance <= meshlet.radius * (1 + 1e-5f) + 1e-6f;
+            }
+
+            // a cone is only tested if its apex is behind (or on) the plane of every triangle
+            if (meshlet.coneCutoff >= 1) continue;
+            coneCount++;
+            for (uint32_t i = meshlet.indexOffset; i < end; i += 3) {
+                const glm::vec3& a = vertices[indices[i]].position;
+                const glm::vec3 n =
+                    glm::cross(vertices[indices[i + 1]].position - a, vertices[indices[i + 2]].position - a);
+                if (glm::length(n) <= std::numeric_limits<float>::min()) continue;
+                isBehind &= glm::dot(meshlet.coneApex - a, glm::normalize(n)) <= 1e-5f;
+            }
+        }
+        CHECK(isTiled && nextIndex == lod.indexOffset + lod.indexCount);
+        CHECK(isInLimits);
+        CHECK(isVertexCountCorrect);
+        CHECK(isContained);
+        CHECK(isBehind);
+    }
+    CHECK(meshletOffset == meshlets.size());
+    CHECK(coneCount > 0);  // the grid is close to flat, most meshlets get a cone
+}
+
+}  // namespace
+
+// Tipsify only reorders triangles, each one keeps its corners and winding
+TEST(mesh_optimizer_vertex_cache_keeps_triangles) {
+    std::vector<Vertex> vertices;
+    std::vector<IndexFormat> indices;
+    makeGrid(48, vertices, indices);
+
+    for (const auto& input : {indices, shuffleTriangles(indices)}) {
+        std::vector<IndexFormat> optimized = input;
+        MeshOptimizer::optimizeVertexCache(optimized, vertices.size());
+        CHECK(optimized.size() == input.size());
+        CHECK(triangleSet(optimized) == triangleSet(input));
+    }
+}
+
+// the vertices move into first-use order, every index still names the vertex it named before
+TEST(mesh_optimizer_vertex_fetch_keeps_vertices) {
+    std::vector<Vertex> vertices;
+    std::vector<IndexFormat> indices;
+    makeGrid(32, vertices, indices);
+    MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+
+    // an unreferenced vertex is dropped
+    vertices.push_back({{9, 9, 9}, {0, 0}, {1, 0, 0}});
+    const std::vector<Vertex> sourceVertices = vertices;
+    const std::vector<IndexFormat> sourceIndices = indices;
+    MeshOptimizer::optimizeVertexFetch(vertices, indices);
+
+    CHECK(indices.size() == sourceIndices.size());
+    CHECK(vertices.size() == sourceVertices.size() - 1);
+    bool isSameVertex = true;
+    for (size_t i = 0; i < indices.size(); i++)
+        isSameVertex &= indices[i] < vertices.size() && vertices[indices[i]] == sourceVertices[sourceIndices[i]];
+    CHECK(isSameVertex);
+
+    // first-use order: each index is at most one past the largest one before it
+    IndexFormat next = 0;
+    bool isFirstUseOrder = true;
+    for (IndexFormat index : indices) {
+        isFirstUseOrder &= index <= next;
+        if (index == next) next++;
+    }
+    CHECK(isFirstUseOrder);
+}
+
+// the row by row grid is already cache friendly, the optimization must not make it worse. a shuffled one must get
+// much better
+TEST(mesh_optimizer_acmr_on_grid) {
+    std::vector<Vertex> vertices;
+    std::vector<IndexFormat> indices;
+    makeGrid(64, vertices, indices);
+
+    std::vector<IndexFormat> optimized = indices;
+    MeshOptimizer::optimizeVertexCache(optimized, vertices.size());
+    const auto before = MeshOptimizer::analyzeVertexCache(indices, vertices.size());
+    const auto after = MeshOptimizer::analyzeVertexCache(optimized, vertices.size());
+    CHECK(after.acmr <= before.acmr);
+
+    indices = shuffleTriangles(indices);
+    const auto shuffledBefore = MeshOptimizer::analyzeVertexCache(indices, vertices.size());
+    MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+    const auto shuffledAfter = MeshOptimizer::analyzeVertexCache(indices, vertices.size());
+    CHECK(shuffledAfter.acmr < shuffledBefore.acmr * 0.6f);
+    CHECK(shuffledAfter.acmr <= before.acmr);
+}
+
+// every lod is a whole number of triangles inside the index buffer, indexing the shared vertices, with fewer
+// triangles and no smaller error than the one before
+TEST(mesh_optimizer_lod_ranges) {
+    std::vector<Vertex> vertices;
+    std::vector<IndexFormat> indices;
+    makeGrid(64, vertices, indices);
+    const size_t sourceIndexCount = indices.size();
+
+    std::vector<gpro::MeshLOD> lods;
+    MeshOptimizer::buildLodChain(vertices, indices, lods);
+    CHECK(lods.size() > 1 && lods.size() <= MeshOptimizer::MAX_LOD_COUNT);
+    CHECK(lods[0].indexOffset == 0 && lods[0].indexCount == sourceIndexCount && lods[0].error == 0);
+
+    for (size_t level = 0; level < lods.size(); level++) {
+        const gpro::MeshLOD& lod = lods[level];
+        CHECK(lod.indexOffset % 3 == 0 && lod.indexCount % 3 == 0 && lod.indexCount > 0);
+        CHECK(lod.indexOffset <= indices.size() && lod.indexCount <= indices.size() - lod.indexOffset);
+        CHECK(std::all_of(indices.begin() + lod.indexOffset, indices.begin() + lod.indexOffset + lod.indexCount,
+                          [&](IndexFormat index) { return index < vertices.size(); }));
+        if (level == 0) continue;
+        CHECK(lod.indexOffset == lods[level - 1].indexOffset + lods[level - 1].indexCount);
+        CHECK(lod.indexCount < lods[level - 1].indexCount);
+        CHECK(lod.error >= lods[level - 1].error);
+    }
+    CHECK(lods.back().indexOffset + lods.back().indexCount == indices.size());
+}
+
+TEST(mesh_optimizer_meshlets) {
+    std::vector<Vertex> vertices;
+    std::vector<IndexFormat> indices;
+    makeGrid(64, vertices, indices);
+    MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+    MeshOptimizer::optimizeVertexFetch(vertices, indices);
+
+    std::vector<gpro::MeshLOD> lods;
+    MeshOptimizer::buildLodChain(vertices, indices, lods);
+
+    // the default limits, and small ones that split on both the vertex and the triangle count
+    std::vector<gpro::Meshlet> meshlets;
+    MeshOptimizer::buildMeshlets(vertices, indices, lods, meshlets);
+    checkMeshlets(vertices, indices, lods, meshlets, MeshOptimizer::MAX_MESHLET_VERTICES,
+                  MeshOptimizer::MAX_MESHLET_TRIANGLES);
+    MeshOptimizer::buildMeshlets(vertices, indices, lods, meshlets, 16, 12);
+    checkMeshlets(vertices, indices, lods, meshlets, 16, 12);
+    MeshOptimizer::buildMeshlets(vertices, indices, lods, meshlets, 64, 5);
+    checkMeshlets(vertices, indices, lods, meshlets, 64, 5);
+}
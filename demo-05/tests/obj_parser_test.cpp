@@ -0,0 +1,128 @@
+#include "gpro/obj_parser.hpp"
+#include "test.hpp"
+
+namespace {
+
+using gpro::ObjParser;
+
+// the parser only splits files of at least 256 KB per chunk
+constexpr size_t MIN_CHUNK_SIZE = 256 * 1024;
+
+// groups of 4 positions, uvs and normals with a quad over them (negative indices), a triangle over the previous
+// group (negative indices that reach back past the group, possibly into the previous chunk) and one with absolute
+// indices. crlf line endings, comments, a uv without v and position/normal-only corners
+std::string generateObj(size_t minSize) {
+    std::string obj = "# generated\r\no plane\r\n";
+    uint32_t groupCount = 0;
+    while (obj.size() < minSize) {
+        const float x = static_cast<float>(groupCount % 97) * 0.25f;
+        const float z = static_cast<float>(groupCount / 97) * -0.5f;
+        for (uint32_t i = 0; i < 4; i++) {
+            obj += std::format("v {0} {1} {2}\r\n", x + (i & 1), 0.125f * i, z - (i >> 1));
+            if (i == 3) obj += std::format("vt {}\r\n", 0.75f);
+            else obj += std::format("vt {0} {1}\r\n", 0.5f * (i & 1), 0.5f * (i >> 1));
+            obj += std::format("vn {0} {1} {2}\r\n", 0, 1, -0.0f);
+        }
+        if (groupCount % 5 == 0) obj += "# a comment line between the records\r\ng group\r\n";
+        obj += "f -4/-4/-4 -3/-3/-3 -1/-1/-1 -2/-2/-2\r\n";
+        if (groupCount > 0) obj += "f -8//-8 -7//-7 -5//-5\r\n";
+        const uint32_t base = groupCount * 4 + 1;
+        obj += std::format("f {0}/{0} {1}/{1} {2}/{2}\r\n", base, base + 1, base + 2);
+        groupCount++;
+    }
+    return obj;
+}
+
+bool isEqual(const ObjParser::Result& a, const ObjParser::Result& b) {
+    if (a.positions != b.positions || a.uvs != b.uvs || a.normals != b.normals) return false;
+    if (a.corners.size() != b.corners.size()) return false;
+    for (size_t i = 0; i < a.corners.size(); i++) {
+        const ObjParser::Corner& ca = a.corners[i];
+        const ObjParser::Corner& cb = b.corners[i];
+        if (ca.position != cb.position || ca.uv != cb.uv || ca.normal != cb.normal) return false;
+    }
+    return true;
+}
+
+ObjParser::Result parse(const std::string& obj, uint32_t threadCount) {
+    ObjParser::Result result;
+    ObjParser::parse(obj.data(), obj.size(), result, threadCount);
+    return result;
+}
+
+}  // namespace
+
+TEST(obj_parser_serial_result) {
+    const std::string obj = generateObj(64 * 1024);
+    const ObjParser::Result result = parse(obj, 1);
+
+    const size_t groupCount = result.positions.size() / 4;
+    CHECK(groupCount > 0);
+    CHECK(result.positions.size() == groupCount * 4);
+    CHECK(result.uvs.size() == groupCount * 4);
+    CHECK(result.normals.size() == groupCount * 4);
+    CHECK(result.corners.size() == 3 * (groupCount * 4 - 1));
+    CHECK(result.uvs[3] == glm::vec2(0.75f, 0));
+
+    // the first group: its quad, then the absolute triangle
+    const int32_t quad[] = {0, 1, 3, 0, 3, 2};
+    for (uint32_t i = 0; i < 6; i++) {
+        CHECK(result.corners[i].position == quad[i]);
+        CHECK(result.corners[i].uv == quad[i]);
+        CHECK(result.corners[i].normal == quad[i]);
+    }
+    for (uint32_t i = 0; i < 3; i++) {
+        CHECK(result.corners[6 + i].position == static_cast<int32_t>(i));
+        CHECK(result.corners[6 + i].normal == ObjParser::MISSING);
+    }
+    // the second group's triangle over the first group
+    CHECK(result.corners[15].position == 0);
+    CHECK(result.corners[15].uv == ObjParser::MISSING);
+    CHECK(result.corners[15].normal == 0);
+}
+
+// two chunks, the split swept over every byte of a few lines by a padding comment in front. the split lands
+// mid-line, mid-face, on the '\r' and '\n' of a crlf and right at the start of a line
+TEST(obj_parser_split_boundaries) {
+    const std::string body = generateObj(2 * MIN_CHUNK_SIZE + 1024);
+    const ObjParser::Result serial = parse(body, 1);
+
+    bool isMidLine = false, isMidFace = false, isCr = false, isLf = false, isLineStart = false;
+    for (uint32_t padding = 0; padding < 160; padding++) {
+        const std::string obj = "#" + std::string(padding, 'x') + "\r\n" + body;
+        const size_t split = obj.size() / 2;  // where the parser starts looking for the end of the first chunk
+        const char c = obj[split];
+        const size_t lineStart = obj.rfind('\n', split - 1) + 1;
+        isCr |= c == '\r';
+        isLf |= c == '\n';
+        isLineStart |= lineStart == split;
+        isMidLine |= lineStart < split && c != '\r' && c != '\n';
+        isMidFace |= lineStart < split && obj[lineStart] == 'f' && c != '\r' && c != '\n';
+
+        if (!isEqual(parse(obj, 2), serial)) {
+            std::cerr << std::format("    split at byte {0} ('{1}') differs from the serial result\n", split,
+                                     c == '\r' ? "\\r" : c == '\n' ? "\\n" : std::string(1, c));
+            CHECK(false);
+        }
+    }
+    CHECK(isMidLine);
+    CHECK(isMidFace);
+    CHECK(isCr);
+    CHECK(isLf);
+    CHECK(isLineStart);
+}
+
+// more chunks than fit: the parser clamps to one chunk per MIN_CHUNK_SIZE. the last line has no line ending
+TEST(obj_parser_thread_counts) {
+    std::string obj = generateObj(8 * MIN_CHUNK_SIZE + 4096);
+    obj += "f 1 2 3";
+    const ObjParser::Result serial = parse(obj, 1);
+    CHECK(serial.corners.back().position == 2);
+
+    for (uint32_t threadCount : {2u, 3u, 4u, 7u, 8u, 16u}) {
+        if (!isEqual(parse(obj, threadCount), serial)) {
+            std::cerr << std::format("    {} threads differ from the serial result\n", threadCount);
+            CHECK(false);
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <functional>
+
+#include "gpro/shared.hpp"
+
+namespace gpro::test {
+
+// Minimal test registry: TEST(name) defines a test that main runs, CHECK(condition) reports a failure with its
+// location and lets the test continue. The executable returns the number of failed tests.
+struct TestCase {
+    const char *name;
+    std::function<void()> run;
+};
+
+inline std::vector<TestCase>& registry() {
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+inline uint32_t& checkFailures() {
+    static uint32_t failures = 0;
+    return failures;
+}
+
+struct Registrar {
+    Registrar(const char *name, std::function<void()> run) { registry().push_back({name, std::move(run)}); }
+};
+
+inline void reportFailure(const char *condition, const char *file, int line) {
+    std::cerr << std::format("    {0}:{1}: CHECK({2}) failed\n", file, line, condition);
+    checkFailures()++;
+}
+
+}  // namespace gpro::test
+
+#define TEST(name)                                                                   \
+    static void gproTest_##name();                                                   \
+    static ::gpro::test::Registrar gproTestRegistrar_##name(#name, gproTest_##name); \
+    static void gproTest_##name()
+#define CHECK(condition) ((condition) ? (void)0 : ::gpro::test::reportFailure(#condition, __FILE__, __LINE__))
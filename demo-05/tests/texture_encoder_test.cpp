@@ -0,0 +1,136 @@
+#include <random>
+
+#include "gpro/texture_encoder.hpp"
+#include "test.hpp"
+
+namespace {
+
+using gpro::TextureEncoder;
+
+struct Image {
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint8_t> rgba;
+};
+
+// smooth color ramps and a falling alpha, the kind of content the block encoders are fit for
+Image gradient(uint32_t width, uint32_t height) {
+    Image image{width, height, std::vector<uint8_t>(width * height * 4)};
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            uint8_t *texel = &image.rgba[(y * width + x) * 4];
+            texel[0] = static_cast<uint8_t>(x * 255 / (width - 1));
+            texel[1] = static_cast<uint8_t>(y * 255 / (height - 1));
+            texel[2] = static_cast<uint8_t>((x + y) * 127 / (width + height - 2));
+            texel[3] = static_cast<uint8_t>(255 - x * 255 / (width - 1));
+        }
+    }
+    return image;
+}
+
+struct Error {
+    double rmse;
+    int max;
+};
+
+Error compare(const Image& image, const std::vector<uint8_t>& decoded, uint32_t firstChannel, uint32_t channelCount) {
+    double sum = 0;
+    int maxError = 0;
+    for (size_t i = 0; i < image.rgba.size(); i += 4) {
+        for (uint32_t c = firstChannel; c < firstChannel + channelCount; c++) {
+            const int error = std::abs(image.rgba[i + c] - decoded[i + c]);
+            sum += error * error;
+            maxError = std::max(maxError, error);
+        }
+    }
+    return {std::sqrt(sum / (image.rgba.size() / 4 * channelCount)), maxError};
+}
+
+std::vector<uint8_t> roundTripBC1(const Image& image) {
+    const auto blocks = TextureEncoder::encodeBC1(image.rgba.data(), image.width, image.height);
+    const size_t size = TextureEncoder::blockCompressedSize(image.width, image.height, TextureEncoder::BC1_BLOCK_BYTES);
+    CHECK(blocks.size() == size);
+    std::vector<uint8_t> decoded(image.rgba.size());
+    TextureEncoder::decodeBC1(blocks.data(), image.width, image.height, decoded.data());
+    return decoded;
+}
+
+std::vector<uint8_t> roundTripBC7(const Image& image) {
+    const auto blocks = TextureEncoder::encodeBC7(image.rgba.data(), image.width, image.height);
+    const size_t size = TextureEncoder::blockCompressedSize(image.width, image.height, TextureEncoder::BC7_BLOCK_BYTES);
+    CHECK(blocks.size() == size);
+    std::vector<uint8_t> decoded(image.rgba.size());
+    CHECK(TextureEncoder::decodeBC7(blocks.data(), image.width, image.height, decoded.data()));
+    return decoded;
+}
+
+// the image repeated past its last row and column up to whole blocks
+Image padToBlocks(const Image& image) {
+    const uint32_t size = TextureEncoder::BLOCK_SIZE;
+    Image padded{(image.width + size - 1) / size * size, (image.height + size - 1) / size * size, {}};
+    padded.rgba.resize(padded.width * padded.height * 4);
+    for (uint32_t y = 0; y < padded.height; y++) {
+        for (uint32_t x = 0; x < padded.width; x++) {
+            const uint32_t sx = std::min(x, image.width - 1), sy = std::min(y, image.height - 1);
+            std::memcpy(&padded.rgba[(y * padded.width + x) * 4], &image.rgba[(sy * image.width + sx) * 4], 4);
+        }
+    }
+    return padded;
+}
+
+}  // namespace
+
+// bounds a little above the measured errors (bc1 rmse 3.3, max 12; bc7 rmse 2.6, max 8, alpha rmse 0.7, max 3)
+TEST(texture_encoder_gradient_error) {
+    const Image image = gradient(64, 64);
+
+    const auto bc1 = roundTripBC1(image);
+    const Error bc1Color = compare(image, bc1, 0, 3);
+    CHECK(bc1Color.rmse < 4.0 && bc1Color.max <= 16);
+    bool isOpaque = true;
+    for (size_t i = 3; i < bc1.size(); i += 4) isOpaque &= bc1[i] == 255;
+    CHECK(isOpaque);  // bc1 drops the alpha
+
+    const auto bc7 = roundTripBC7(image);
+    const Error bc7Color = compare(image, bc7, 0, 3);
+    const Error bc7Alpha = compare(image, bc7, 3, 1);
+    CHECK(bc7Color.rmse < 3.5 && bc7Color.max <= 12);
+    CHECK(bc7Alpha.rmse < 1.5 && bc7Alpha.max <= 4);
+}
+
+// a solid block is within half a 5/6-bit step in bc1 (565 endpoints) and one step in bc7 (7-bit endpoints + p-bit)
+TEST(texture_encoder_solid_blocks) {
+    std::mt19937 rng(3);
+    int bc1Max = 0, bc7Max = 0;
+    for (uint32_t i = 0; i < 1000; i++) {
+        const uint32_t color = rng();
+        Image image{4, 4, std::vector<uint8_t>(64)};
+        for (uint32_t t = 0; t < 16; t++) std::memcpy(&image.rgba[t * 4], &color, 4);
+
+        bc1Max = std::max(bc1Max, compare(image, roundTripBC1(image), 0, 3).max);
+        bc7Max = std::max(bc7Max, compare(image, roundTripBC7(image), 0, 4).max);
+    }
+    CHECK(bc1Max <= 4);
+    CHECK(bc7Max <= 1);
+}
+
+// partial edge blocks encode like the image padded by repeating its last row and column
+TEST(texture_encoder_partial_blocks) {
+    const Image image = gradient(13, 7);
+    const Image padded = padToBlocks(image);
+
+    const auto bc1 = TextureEncoder::encodeBC1(image.rgba.data(), image.width, image.height);
+    const auto bc7 = TextureEncoder::encodeBC7(image.rgba.data(), image.width, image.height);
+    CHECK(bc1 == TextureEncoder::encodeBC1(padded.rgba.data(), padded.width, padded.height));
+    CHECK(bc7 == TextureEncoder::encodeBC7(padded.rgba.data(), padded.width, padded.height));
+
+    // and decode into the image's own size
+    const auto decoded = roundTripBC7(image);
+    const auto paddedDecoded = roundTripBC7(padded);
+    bool isCropped = true;
+    for (uint32_t y = 0; y < image.height; y++) {
+        isCropped &= std::memcmp(&decoded[y * image.width * 4], &paddedDecoded[y * padded.width * 4],
+                                 image.width * 4) == 0;
+    }
+    CHECK(isCropped);
+}
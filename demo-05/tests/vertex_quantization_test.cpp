@@ -0,0 +1,72 @@
+#include <random>
+
+#include "gpro/utils.hpp"
+#include "test.hpp"
+
+using namespace gpro;
+
+// positions within half a unorm16 step of the bounds' extent, uvs within half a half-float ulp, normals within the
+// octahedral snorm16 grid (measured below 6.5e-5 rad)
+TEST(vertex_quantization_error_bounds) {
+    const glm::vec3 boundsMin(-3.f, 0.f, 10.f);
+    const glm::vec3 boundsMax(5.f, 0.25f, 1000.f);
+
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    std::normal_distribution<float> gauss;
+
+    std::vector<Vertex> vertices = {
+        {boundsMin, {0, 0}, {0, 0, 1}},
+        {boundsMax, {1, 1}, {0, 0, -1}},
+        {boundsMin, {4, -2}, {1, 0, 0}},
+        {boundsMax, {0.5f, 3.9f}, {0, -1, 0}},
+    };
+    for (uint32_t i = 0; i < 100000; i++) {
+        const glm::vec3 t(unit(rng), unit(rng), unit(rng));
+        const glm::vec3 normal(gauss(rng), gauss(rng), gauss(rng));
+        vertices.push_back({boundsMin + t * (boundsMax - boundsMin), {4 * unit(rng) - 2, 4 * unit(rng)},
+                            glm::normalize(normal)});
+    }
+
+    std::vector<CompactVertex> compact;
+    util::quantizeVertices(vertices, boundsMin, boundsMax, compact);
+    std::vector<Vertex> decoded;
+    util::dequantizeVertices(compact, boundsMin, boundsMax, decoded);
+    CHECK(compact.size() == vertices.size());
+    CHECK(decoded.size() == vertices.size());
+    if (decoded.size() != vertices.size()) return;
+
+    const glm::vec3 positionBound = (boundsMax - boundsMin) * (0.5f / 65535.f) * 1.01f;  // and the float rounding
+    float maxNormalError = 0;
+    bool isPositionInBounds = true, isUVInBounds = true, isNormalAligned = true;
+    for (size_t i = 0; i < vertices.size(); i++) {
+        const Vertex& a = vertices[i];
+        const Vertex& b = decoded[i];
+        for (int c = 0; c < 3; c++) isPositionInBounds &= std::abs(a.position[c] - b.position[c]) <= positionBound[c];
+        for (int c = 0; c < 2; c++)
+            isUVInBounds &= std::abs(a.uv[c] - b.uv[c]) <= std::max(std::abs(a.uv[c]), 1.f / 16384) / 2048;
+        // the sine of the angle, acos loses the small angles to float rounding
+        maxNormalError = std::max(maxNormalError, glm::length(glm::cross(a.normal, b.normal)));
+        isNormalAligned &= glm::dot(a.normal, b.normal) > 0;
+    }
+    CHECK(isPositionInBounds);
+    CHECK(isUVInBounds);
+    CHECK(isNormalAligned && maxNormalError < 1e-4f);
+
+    // the corners of the bounds are exact
+    CHECK(decoded[0].position == boundsMin);
+    CHECK(decoded[1].position == boundsMax);
+}
+
+// a flat axis quantizes to its bound instead of dividing by zero
+TEST(vertex_quantization_flat_bounds) {
+    const glm::vec3 bounds(1.f, 2.f, 3.f);
+    const std::vector<Vertex> vertices = {{bounds, {0, 0}, {0, 1, 0}}};
+
+    std::vector<CompactVertex> compact;
+    util::quantizeVertices(vertices, bounds, bounds, compact);
+    std::vector<Vertex> decoded;
+    util::dequantizeVertices(compact, bounds, bounds, decoded);
+    CHECK(decoded.size() == 1 && decoded[0].position == bounds);
+    CHECK(util::encodeOctahedral(glm::vec3(0)) == (std::array<int16_t, 2>{0, 0}));
+}
@@ -0,0 +1,90 @@
+#include <random>
+
+#include "gpro/vertex_welder.hpp"
+#include "test.hpp"
+
+namespace {
+
+using gpro::Vertex;
+using gpro::VertexWelder;
+
+Vertex makeVertex(uint32_t seed) {
+    const float f = static_cast<float>(seed);
+    return {{f, 0.5f * f, -f}, {f / 1024.f, 1.f - f / 1024.f}, {0, seed & 1 ? 1.f : -1.f, 0}};
+}
+
+// every input maps back to itself, the output holds each distinct vertex once, after what was there before
+void checkLossless(const std::vector<Vertex>& input, size_t expectedUniqueCount) {
+    std::vector<Vertex> vertices = {makeVertex(123456), makeVertex(654321)};  // not owned by the welder
+    const std::vector<Vertex> prefix = vertices;
+    VertexWelder welder(vertices, expectedUniqueCount);
+
+    std::vector<uint32_t> indices;
+    for (const Vertex& vertex : input) indices.push_back(welder.weld(vertex));
+
+    CHECK(vertices.size() == prefix.size() + welder.uniqueCount());
+    CHECK(std::equal(prefix.begin(), prefix.end(), vertices.begin()));
+    bool isLossless = true;
+    for (size_t i = 0; i < input.size(); i++) {
+        isLossless &= indices[i] < welder.uniqueCount() && vertices[prefix.size() + indices[i]] == input[i];
+    }
+    CHECK(isLossless);
+
+    bool isUnique = true;
+    for (size_t i = prefix.size(); i < vertices.size(); i++)
+        for (size_t j = prefix.size(); j < i; j++) isUnique &= !(vertices[i] == vertices[j]);
+    CHECK(isUnique);
+}
+
+}  // namespace
+
+TEST(vertex_welder_lossless) {
+    std::mt19937 rng(1);
+    std::vector<Vertex> input;
+    for (uint32_t i = 0; i < 5000; i++) input.push_back(makeVertex(rng() % 700));
+
+    checkLossless(input, 0);    // grows from the smallest table
+    checkLossless(input, 700);  // sized up front
+    checkLossless({}, 0);
+}
+
+// -0.0f compares equal to 0.0f, so both weld to one vertex. one bit anywhere else keeps vertices apart
+TEST(vertex_welder_signed_zero) {
+    std::vector<Vertex> vertices;
+    VertexWelder welder(vertices);
+
+    const Vertex positive{{0, 1, 0}, {0, 0}, {0, 0, 1}};
+    const Vertex negative{{-0.f, 1, -0.f}, {-0.f, 0}, {0, -0.f, 1}};
+    CHECK(welder.weld(positive) == welder.weld(negative));
+
+    Vertex nextUp = positive;
+    nextUp.uv.y = std::nextafter(0.f, 1.f);
+    CHECK(welder.weld(nextUp) != welder.weld(positive));
+    CHECK(welder.uniqueCount() == 2);
+}
+
+// distinct vertices whose hashes share the low 16 bits probe into one run of slots at every table size up to 64k
+TEST(vertex_welder_hash_collisions) {
+    std::vector<Vertex> colliding;
+    const uint64_t bits = gpro::hashVertex(makeVertex(0)) & 0xffff;
+    for (uint32_t seed = 0; colliding.size() < 48; seed++) {
+        const Vertex vertex = makeVertex(seed);
+        if ((gpro::hashVertex(vertex) & 0xffff) == bits) colliding.push_back(vertex);
+    }
+
+    std::vector<Vertex> input;
+    for (uint32_t round = 0; round < 3; round++) input.insert(input.end(), colliding.begin(), colliding.end());
+    for (uint32_t i = 0; i < 200; i++) {  // unrelated vertices in between
+        Vertex vertex = makeVertex(i);
+        vertex.normal = {0, 0, 1};
+        input.push_back(vertex);
+    }
+    input.insert(input.end(), colliding.rbegin(), colliding.rend());
+
+    checkLossless(input, 0);
+
+    std::vector<Vertex> vertices;
+    VertexWelder welder(vertices);
+    for (const Vertex& vertex : input) welder.weld(vertex);
+    CHECK(welder.uniqueCount() == colliding.size() + 200);
+}